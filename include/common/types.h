@@ -18,6 +18,7 @@
 #ifndef LBIO_COMMON_TYPES_H
 #define LBIO_COMMON_TYPES_H
 
+#include <cstddef>
 #include <cstdint>
 
 // This file contains definition of types used throughout the
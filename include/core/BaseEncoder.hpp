@@ -0,0 +1,83 @@
+#ifndef BASE_ENCODER_H
+#define BASE_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * \brief Bulk conversion of bases (ASCII characters) to packed 2 and
+ * 4 bits codes and back.
+ *
+ * Codes are the same of DNAAlphabet2Bits (2 bits, \c A=0, \c C=1,
+ * \c G=2, \c T=3) and of DNACompressedSymbol (4 bits IUPAC codes),
+ * lower case bases are accepted. Packed codes are stored starting
+ * from the most significant bits of each byte, which is the layout
+ * of CompressedSequence::getPackedBytes().
+ *
+ * Bases that can not be represented with 2 bits (\c N and the other
+ * IUPAC symbols) are encoded as \c A and flagged in a side mask: bit
+ * \c i%64 of word \c i/64 is set when base \c i is ambiguous. The mask
+ * can be given back to the decoder to restore such bases as \c N.
+ *
+ * On x86 processors the conversions use SSE4.1 or AVX2 kernels (16
+ * or 32 bases per step), the best instruction set supported by the
+ * running processor is selected at run time. Other processors use
+ * table driven scalar code.
+ *
+ * \code
+ * std::vector<uint8_t> packed((n + 3) / 4);
+ * std::vector<uint64_t> ambiguous((n + 63) / 64);
+ * BaseEncoder::encode2Bits(bases, n, packed.data(), ambiguous.data());
+ * \endcode
+ *
+ * \sa DNAAlphabet2Bits
+ * \sa DNACompressedSymbol
+ */
+class BaseEncoder {
+ public:
+  /**
+   * \brief Packs \c n bases into \f$ \lceil n/4 \rceil \f$ bytes
+   *
+   * \param bases The bases to encode
+   * \param n The number of bases
+   * \param packed The output bytes
+   * \param ambiguous The output mask of ambiguous bases (\f$
+   * \lceil n/64 \rceil \f$ words), can be \c NULL
+   */
+  static void encode2Bits(const char* bases, size_t n, uint8_t* packed,
+			  uint64_t* ambiguous = NULL);
+
+  /**
+   * \brief Unpacks \c n bases from 2 bits codes
+   *
+   * \param packed The packed codes
+   * \param n The number of bases
+   * \param bases The output bases
+   * \param ambiguous The mask returned by the encoder, bases flagged
+   * are decoded as \c N (can be \c NULL)
+   */
+  static void decode2Bits(const uint8_t* packed, size_t n, char* bases,
+			  const uint64_t* ambiguous = NULL);
+
+  /**
+   * \brief Packs \c n bases (IUPAC symbols) into \f$ \lceil n/2
+   * \rceil \f$ bytes
+   *
+   * Characters that are not IUPAC symbols are encoded as 0 (gap).
+   */
+  static void encode4Bits(const char* bases, size_t n, uint8_t* packed);
+
+  /**
+   * \brief Unpacks \c n bases (IUPAC symbols) from 4 bits codes
+   */
+  static void decode4Bits(const uint8_t* packed, size_t n, char* bases);
+
+  /**
+   * \brief Returns the name of the instruction set used by the
+   * conversions (\c avx2, \c sse4.1 or \c scalar)
+   */
+  static std::string getInstructionSet();
+};
+
+#endif
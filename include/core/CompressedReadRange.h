@@ -0,0 +1,128 @@
+#ifndef COMPRESSED_READ_RANGE_H
+#define COMPRESSED_READ_RANGE_H
+
+#include "CompressedReadSet.h"
+
+#include <util/char_span.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief A non owning view of a range of consecutive reads of a
+ * CompressedReadSet.
+ *
+ * A range is just the set and the indices of its reads, creating,
+ * copying and splitting ranges never copies (nor allocates) the
+ * compressed reads. This allows, for example, to assign disjoint
+ * ranges of a set to different threads; reads are decoded only when
+ * needed, in a buffer provided by the caller, using a
+ * CompressedReadIterator.
+ *
+ * The range is valid as long as the set is alive and is not modified.
+ *
+ * \code
+ * std::vector<CompressedReadRange> parts = set.getRange(0, set.getReadCount()).split(threads);
+ * // in thread t
+ * std::vector<char> buffer(set.getReadLength());
+ * CompressedReadIterator it(parts[t], buffer.data());
+ * while (it.next()) {
+ *   // it.getBases() ...
+ * }
+ * \endcode
+ *
+ * \sa CompressedReadSet::getRange()
+ * \sa CompressedReadIterator
+ */
+class CompressedReadRange {
+ private:
+  const CompressedReadSet* set;
+  size_t first;
+  size_t count;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  /**
+   * \brief Creates the range of the reads [first, first+count-1]
+   * of the set (truncated to the reads in the set)
+   */
+  CompressedReadRange(const CompressedReadSet& set, size_t first, size_t count);
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  const CompressedReadSet& getSet() const;
+  /**
+   * \brief Returns the index (in the set) of the first read
+   */
+  size_t getFirst() const;
+  size_t size() const;
+  bool empty() const;
+
+  /**
+   * \brief Returns the reads [first, first+count-1] of this range
+   * (indices are relative to the range)
+   */
+  CompressedReadRange subRange(size_t first, size_t count) const;
+
+  /**
+   * \brief Splits the range into (at most) \c parts ranges of
+   * almost the same size
+   */
+  std::vector< CompressedReadRange > split(size_t parts) const;
+
+  /**
+   * \brief Decodes the i-th read of the range (IUPAC symbols, see
+   * DNACompressedSymbol) into \c bases
+   *
+   * \param i The index of the read in the range
+   * \param bases The output buffer (at least the read length)
+   */
+  void decode(size_t i, char* bases) const;
+
+  /**
+   * \brief Copies the compressed symbols of the i-th read of the
+   * range into \c symbols, one symbol per byte
+   */
+  void unpack(size_t i, uint8_t* symbols) const;
+};
+
+/**
+ * \brief Decodes the reads of a CompressedReadRange one at a time
+ * into a buffer provided by the caller.
+ *
+ * The buffer must hold (at least) CompressedReadSet::getReadLength()
+ * characters and it is overwritten by each call to next().
+ */
+class CompressedReadIterator {
+ private:
+  CompressedReadRange range;
+  char* buffer;
+  size_t position;
+
+ public:
+  CompressedReadIterator(const CompressedReadRange& range, char* buffer);
+
+  /**
+   * \brief Decodes the next read of the range
+   *
+   * \return \c false when all the reads of the range have been decoded
+   */
+  bool next();
+
+  /**
+   * \brief Returns the index (in the set) of the last decoded read
+   */
+  size_t getIndex() const;
+
+  /**
+   * \brief Returns the bases of the last decoded read (a view of
+   * the caller buffer)
+   */
+  lbio::char_span getBases() const;
+};
+
+#endif
@@ -4,9 +4,15 @@
 #include "CompressedSequence.h"
 #include <core/Read.hpp>
 
+#include <util/file_format.hpp>
+#include <util/mapped_file.hpp>
+
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
+class CompressedReadRange;
+
 // TODO LIST
 // 1. Perform resizing of the read size in order to have a multiple of 8 sequence size (in bits) -- DONE
 // 2. Add the 'append' methods (and the += operator as well)
@@ -15,6 +21,45 @@
 // 4. Add 'getReads(begin, count)' method to retrieve the 'count' reads [begin, begin+count-1] -- DONE
 
 
+/**
+ * \brief Header of the binary file of a CompressedReadSet.
+ *
+ * All the fields have a fixed size, the header is followed (at the
+ * page aligned offset \c dataOffset) by the 64 bits words of the
+ * sequence and then (at \c indexOffset) by the block index.
+ *
+ * \sa CompressedReadSet::writeToFile()
+ */
+struct CompressedReadSetHeader {
+  /**
+   * \brief Magic string \c LBIORSET, version and byte order
+   */
+  lbio::file_preamble preamble;
+  uint64_t elementSize;
+  uint64_t readCount;
+  uint64_t readLength;
+  uint64_t wordCount;
+  uint64_t dataOffset;
+  /**
+   * \brief The number of reads of every block (but the last)
+   */
+  uint64_t blockReads;
+  uint64_t blockCount;
+  uint64_t indexOffset;
+};
+
+/**
+ * \brief One entry of the block index of a CompressedReadSet file.
+ *
+ * Words are relative to the beginning of the sequence, a word may
+ * be shared with the previous block when reads are not word aligned.
+ */
+struct CompressedReadSetBlock {
+  uint64_t firstWord;
+  uint64_t wordCount;
+  uint64_t checksum;
+};
+
 /**
  * \brief This class represents a compressed set of reads. 
  *
@@ -42,7 +87,26 @@ class CompressedReadSet : public CompressedSequence {
  private:
   size_t readCount;
   size_t readLength;
+  lbio::mapped_file mapping;
+  const CompressedReadSetBlock* blocks;
+  size_t blockCount;
+  size_t blockReads;
+
+  /**
+   * \brief Encodes the bases of a read at the given element position
+   */
+  void encodeRead(const Read& read, size_t position, vector<uint8_t>& buffer);
+  /**
+   * \brief Moves the content of a mapped set in memory (so that it
+   * can be modified) and releases the mapping
+   */
+  void detach();
  public:
+  /**
+   * \brief Current version of the binary format
+   */
+  static const uint32_t FormatVersion = 1;
+
   // ---------------------------------------------------------
   // -------------- CONSTRUCTORS AND DESTRUCTOR --------------
   // ---------------------------------------------------------
@@ -108,6 +172,12 @@ class CompressedReadSet : public CompressedSequence {
   CompressedReadSet(const CompressedReadSet& other);
   ~CompressedReadSet();
 
+  /**
+   * \brief Replaces the content with a copy of another set (the
+   * copy is always held in memory)
+   */
+  CompressedReadSet& operator=(const CompressedReadSet& other);
+
   // ---------------------------------------------------------
   // ------------------ GET AND SET METHODS ------------------
   // ---------------------------------------------------------
@@ -119,6 +189,26 @@ class CompressedReadSet : public CompressedSequence {
    */
   size_t getReadCount() const;
 
+  /**
+   * \brief Returns the length of each read (reads are padded so that
+   * each read starts on a byte boundary)
+   */
+  size_t getReadLength() const;
+
+  /**
+   * \brief Returns a view of the reads [start, start+count-1].
+   *
+   * Nothing is copied, the range is truncated to the reads in the
+   * set. The range is valid as long as the set is not modified.
+   *
+   * \param start The index of the first read of the range
+   * \param count The number of reads of the range
+   * \return The (non owning) range
+   *
+   * \sa CompressedReadRange
+   */
+  CompressedReadRange getRange(size_t start, size_t count) const;
+
   /**
    * \brief Returns a copy of the sequence consisting of count reads
    * from the position start. 
@@ -134,6 +224,7 @@ class CompressedReadSet : public CompressedSequence {
    * \return a copy of the sequence for returned reads
    * possibily padded with all zeros reads
    *
+   * \sa getRange(size_t start, size_t count) const
    */
   uint8_t* getReads(size_t start, size_t count) const;
 
@@ -148,10 +239,9 @@ class CompressedReadSet : public CompressedSequence {
    * read its size is translated to match the actual size. If
    * the real size of read is smaller zeros are padded at the end
    * otherwise base sequence is truncated to actual length.
-   * Since the compressed seqeunce is enlarged for the amount of
-   * space required by the new read, it is more convenient to use
-   * other overloaded versions of this method when more reads need
-   * to be appended to the compressed sequence.
+   * The compressed sequence grows geometrically, so appending
+   * reads one at a time costs (amortized) constant time per read,
+   * reserve() can be used when the number of reads is known.
    *
    * \param read The read to be appended
    * \return This object after append has been performed
@@ -177,18 +267,43 @@ class CompressedReadSet : public CompressedSequence {
    */
   CompressedReadSet& append(const vector<Read>& reads);
 
+  /**
+   * \brief Appends a batch of reads to the sequence.
+   *
+   * The sequence is enlarged once for the whole batch and the bases
+   * of each read are encoded directly at the end of the sequence.
+   * Reads are adapted to the read length as in append(const Read& read).
+   *
+   * \param reads The array of reads to be appended
+   * \param count The number of reads in the array
+   * \return This object after append has been performed
+   */
+  CompressedReadSet& append(const Read* reads, size_t count);
+
+  /**
+   * \brief Makes room for (at least) \c readCount reads, so that
+   * the set can be filled without reallocations.
+   *
+   * \param readCount The total number of reads expected
+   */
+  void reserve(size_t readCount);
+
   // I/O methods
   /**
    * \brief Writes the content to a file. 
    *
-   * In the target file are stored
-   * *in binary format) the size of the entire sequence, the number
-   * of reads and the length of each read, after this information
-   * the raw sequence is stored (again in binary format).
+   * The file starts with a CompressedReadSetHeader (magic number,
+   * version and byte order marker, the element size, the number
+   * of reads and the length of each read), the words of the
+   * sequence are stored from the first page boundary as they are
+   * in memory, so that the file can be used in place by mapFile().
+   * The sequence is followed by an index with the words and the
+   * checksum of each block of reads.
    * 
    * \param fileName the full path of the file.
    *
-   * \sa CompressedReadSet& loadFromFile(const string& fileName)
+   * \sa loadFromFile(const string& fileName)
+   * \sa mapFile(const string& fileName)
    */
   void writeToFile(const string& fileName) const;
 
@@ -196,16 +311,51 @@ class CompressedReadSet : public CompressedSequence {
    * \brief Loads the content of fileNmae. 
    *
    * The target file must follow
-   * the rules defined in writeToFile methods. The content of
-   * this object is destroyed after loading new content from
-   * file and is no longer available when the method returns.
+   * the rules defined in writeToFile methods (files written by
+   * previous versions, without header, are still accepted). The
+   * content of this object is destroyed after loading new content
+   * from file and is no longer available when the method returns.
+   * Checksums of all the blocks are verified.
    *
    * \param fileName The full path of the file
-   * \return This object after loading has been performed
+   * \return \c false if the file can not be read, it is not a valid
+   * read set file or a checksum does not match (the set is then left
+   * empty)
    *
    * \sa writeToFile(const string& fileName) const
    */
-  CompressedReadSet& loadFromFile(const string& fileName);
+  bool loadFromFile(const string& fileName);
+
+  /**
+   * \brief Uses a file written by writeToFile() in place.
+   *
+   * The file is memory mapped (read only) and the sequence is not
+   * copied: pages are loaded only when the reads they contain are
+   * accessed and are shared among the processes mapping the same
+   * file. Checksums are not verified (see verifyReads()). Appending
+   * reads to a mapped set first copies the whole set in memory.
+   *
+   * \param fileName The full path of the file
+   * \return \c false if the file can not be mapped or it is not a
+   * valid read set file (the set is then left empty)
+   */
+  bool mapFile(const string& fileName);
+
+  /**
+   * \brief Returns \c true if the set is used in place from a file
+   */
+  bool isMapped() const;
+
+  /**
+   * \brief Verifies the checksums of the blocks containing the
+   * reads [start, start+count-1] of a mapped set.
+   *
+   * Only the pages of such blocks are accessed. Sets held in memory
+   * have been verified when loaded and always return \c true.
+   *
+   * \return \c false if any of the blocks is corrupted
+   */
+  bool verifyReads(size_t start, size_t count) const;
 };
 
 #endif
@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <iosfwd>
 #include <string>
 using namespace std;
 
@@ -12,30 +13,42 @@ using namespace std;
  * \brief This class represents a sequence of \em compressed elements.
  *
  * Elements are compressed in the sense that, given the size in bits
- * of single element, the minumum number of \b bytes are used to
+ * of single element, the minumum number of \b words are used to
  * store the entire sequence. If the number of bits is less than
- * one byte more than one element is stored per byte.
+ * one word more than one element is stored per word.
  *
  * The class is designed to be used with element sizes (in bits)
- * that are power of two: 1,2,4 and 8 are typycal values although
- * 8 bits elements are best represented using a sequence of bytes.
+ * that are power of two: 1,2,4 and 8 are the supported values, so
+ * that an element never spans two words.
  *
- * Internally the sequence is stored as an array of bytes, if
+ * Internally the sequence is stored as an array of 64 bits words, if
  * \f$ n \f$ is the number of element in the sequence and \f$ m \f$
  * is the size (in bits) of a single element then the real size 
- * \f$ N \f$ of the internal sequence is
+ * \f$ N \f$ (in bytes) of the internal sequence is
  * \f[
- * N = \lceil \frac{n}{8} \cdot m \rceil
+ * N = 8 \cdot \lceil \frac{n \cdot m}{64} \rceil
  * \f]
  * This size can be obtained by calling the length() method and
  * is usually refered to as the <em>real size</em> of the sequence.
+ * Bits of the last word following the last element are always zero.
+ *
+ * Within each word elements are stored starting from the most
+ * significant bits, so that for 2 bits elements a word holds 32
+ * elements and element 0 is in bits 63-62. Reading the packed bytes
+ * (see getPackedBytes()) of such words gives the usual layout where
+ * the byte \c 0x1B holds the elements 0, 1, 2 and 3 (in this order).
+ * Since the first element is the most significant one, comparing
+ * words as unsigned integers gives the lexicographic order of the
+ * elements: bulk operations (pack(), unpack(), substring(),
+ * getWindow(), compare(), hammingDistance()) work on whole words
+ * rather than on single elements.
  */
 class CompressedSequence : public Sequence {
  protected:
   /**
-   * \brief The raw sequence
+   * \brief The raw sequence (64 bits words)
    */
-  uint8_t* seq;
+  uint64_t* seq;
   /**
    * \brief The number of elements of the sequence
    */
@@ -44,13 +57,18 @@ class CompressedSequence : public Sequence {
    * \brief The real size (in bytes) of the sequence
    */
   size_t realSize;
+  /**
+   * \brief The number of words allocated for the sequence (at least
+   * the words needed by the elements, see reserve())
+   */
+  size_t capacity;
   /**
    * \brief The size (in bits) of the single element
    */
   size_t elSize;
   /**
    * \brief The mask used to access single element within 
-   * a whole byte
+   * a whole word
    */
   uint8_t mask;
  public:
@@ -89,6 +107,23 @@ class CompressedSequence : public Sequence {
    */
   CompressedSequence(size_t n, size_t elSize = 2);
 
+  /**
+   * \brief Creates a new CompressedSequence copying an already
+   * packed sequence of bytes.
+   *
+   * The bytes must have the layout returned by getPackedBytes()
+   * (elements stored from the most significant bits of each byte)
+   * and contain (at least) the bytes needed to store \c n elements
+   * of \c elSize bits.
+   *
+   * \param raw The packed elements
+   * \param n The number of elements in the sequence
+   * \param elSize The size (in bits) of a single element
+   *
+   * \sa CompressedSequence(size_t n, size_t elSize)
+   */
+  CompressedSequence(const uint8_t* raw, size_t n, size_t elSize = 2);
+
   /**
    * \brief Copy constructor to initialize from another 
    * CompressedSequence instance.
@@ -101,6 +136,11 @@ class CompressedSequence : public Sequence {
   CompressedSequence(const CompressedSequence& s);
   ~CompressedSequence();
 
+  /**
+   * \brief Replaces the content with a copy of another sequence
+   */
+  CompressedSequence& operator=(const CompressedSequence& s);
+
   // ---------------------------------------------------------
   //                    GET AND SET METHODS
   // ---------------------------------------------------------
@@ -158,7 +198,8 @@ class CompressedSequence : public Sequence {
    * \brief Sets the i-th element of the sequence.
    *
    * The setting of the element take care of considering the
-   * proper number of bits from the parameter.
+   * proper number of bits from the parameter, the previous value
+   * of the element is overwritten.
    * \param i
    * \param e
    *
@@ -171,19 +212,114 @@ class CompressedSequence : public Sequence {
    * \brief Returns the internal sequence in its \e raw format.
    *
    * The method returns the sequence as a pointer, the returned
-   * reference points to <b>the same sequence stored internally</b>
-   * and therefore any change using the returned pointer will
-   * modify the internal sequence of the class.
+   * reference points to <b>the same sequence stored internally</b>.
    *
    * The only difference with the getSequence() method is that
-   * getawSequence() returns a uint8_t pointer (that is also
+   * getRawSequence() returns a uint64_t pointer (that is also
    * the way the sequence is stored internally)
    * 
    * \return A pointer to the internal sequence
    *
    * \sa getSequence() const
+   * \sa getWordCount() const
+   */
+  const uint64_t* getRawSequence() const;
+
+  /**
+   * \brief Returns the number of words of the internal sequence
+   */
+  size_t getWordCount() const;
+
+  /**
+   * \brief Returns the number of elements that can be stored
+   * without reallocating the internal sequence
+   */
+  size_t getCapacity() const;
+
+  /**
+   * \brief Returns the number of bytes needed to store the elements
+   * when packed in bytes, that is \f$ \lceil n \cdot m / 8 \rceil \f$
+   */
+  size_t getPackedByteCount() const;
+
+  /**
+   * \brief Copies \c count bytes of the packed representation of the
+   * sequence, starting from byte \c first, into \c out.
+   *
+   * Within each byte elements are stored starting from the most
+   * significant bits. Bytes past the end of the sequence are set to
+   * zero.
+   */
+  void getPackedBytes(size_t first, size_t count, uint8_t* out) const;
+
+  /**
+   * \brief Overwrites \c count bytes of the packed representation of
+   * the sequence, starting from byte \c first (the sequence must
+   * already contain such bytes).
+   *
+   * \sa getPackedBytes()
+   */
+  void setPackedBytes(size_t first, size_t count, const uint8_t* bytes);
+
+  /**
+   * \brief Returns the \c k elements starting at position \c i as
+   * an integer whose most significant element is the one at \c i.
+   *
+   * The elements are read with (at most) two word accesses, this is
+   * the building block to extract all the k-mers of a sequence.
+   * It is required that \f$ k \cdot m \leq 64 \f$ and that
+   * \c i + \c k is not larger than the number of elements.
+   *
+   * \param i The position of the first element of the window
+   * \param k The number of elements of the window
+   * \return The packed window
+   */
+  uint64_t getWindow(size_t i, size_t k) const;
+
+  /**
+   * \brief Unpacks \c count elements starting from position \c begin,
+   * one element per byte.
+   *
+   * \param begin The position of the first element
+   * \param count The number of elements to unpack
+   * \param out The output array (at least \c count bytes)
+   */
+  void unpack(size_t begin, size_t count, uint8_t* out) const;
+
+  /**
+   * \brief Returns a new sequence with \c len elements starting
+   * from \c begin (\c len is truncated at the end of the sequence).
    */
-  const uint8_t* getRawSequence() const;
+  CompressedSequence substring(size_t begin, size_t len) const;
+
+  // ---------------------------------------------------------
+  //                     COMPARE METHODS
+  // ---------------------------------------------------------
+
+  /**
+   * \brief Compares the sequence with another one (with the same
+   * element size) in lexicographic order.
+   *
+   * The comparison is performed one word at a time, when one of the
+   * sequences is a prefix of the other the shorter comes first.
+   *
+   * \return A negative value, zero or a positive value if this
+   * sequence is smaller, equal or greater than \c other.
+   */
+  int compare(const CompressedSequence& other) const;
+
+  /**
+   * \brief Returns the number of positions (among the first
+   * \f$ \min(n, n') \f$) where the two sequences have different
+   * elements.
+   *
+   * Elements are compared one word at a time.
+   */
+  size_t hammingDistance(const CompressedSequence& other) const;
+
+  bool operator==(const CompressedSequence& other) const;
+  bool operator!=(const CompressedSequence& other) const;
+  bool operator<(const CompressedSequence& other) const;
 
   // ---------------------------------------------------------
   //                      MODIFY METHODS
@@ -212,6 +348,44 @@ class CompressedSequence : public Sequence {
    */
   CompressedSequence& append(const CompressedSequence &other);
 
+  /**
+   * \brief Makes room for (at least) \c count elements.
+   *
+   * Appending elements never reallocates the sequence until its
+   * length exceeds the reserved capacity. When the capacity is
+   * exceeded it is (at least) doubled, so that appending \f$ n \f$
+   * elements costs \f$ O(n) \f$ overall even without reserving.
+   *
+   * \param count The number of elements to make room for
+   */
+  void reserve(size_t count);
+
+  /**
+   * \brief Sets \c count elements, starting from position \c begin,
+   * from an array with one element per byte.
+   *
+   * Elements are accumulated in a register and stored a whole word
+   * at a time. The sequence must already contain the positions to
+   * be written.
+   *
+   * \param values The elements (only the \c elSize less significant
+   * bits of each value are used)
+   * \param count The number of elements
+   * \param begin The position of the first element to set
+   */
+  void pack(const uint8_t* values, size_t count, size_t begin = 0);
+
+  /**
+   * \brief Sets \c count elements, starting from position \c begin,
+   * translating the symbols through a 256 entries table.
+   *
+   * \param symbols The symbols to be packed
+   * \param count The number of symbols
+   * \param code The element for each of the 256 possible symbols
+   * \param begin The position of the first element to set
+   */
+  void pack(const char* symbols, size_t count, const uint8_t* code, size_t begin = 0);
+
   // ---------------------------------------------------------
   //                        I/O METHODS
   // ---------------------------------------------------------
@@ -221,9 +395,10 @@ class CompressedSequence : public Sequence {
    *
    * In order to write the full information the output file
    * contains (at the beginning of the file) the binary formato
-   * of the <em>real size</em> and of the <em>element count</em>.
-   * After such information the raw sequence is written in
-   * binary format.
+   * of the number of elements and of the <em>element size</em>.
+   * After such information the packed bytes (see getPackedBytes())
+   * are written, so that the file does not depend on the word
+   * layout (nor on the endianness) of the machine.
    *
    * \param fileName The full path of the output file
    * 
@@ -236,9 +411,10 @@ class CompressedSequence : public Sequence {
    *
    * The method assumes that the input binary file has the
    * format produced by the writeToFile() method. That is, 
-   * at the beginning of the file it looks for the <em>real
-   * size</em> and for the <em>element size</em> (as size_t
-   * types) and afterward the raw sequence is loaded
+   * at the beginning of the file it looks for the number of
+   * elements and for the <em>element size</em> (as size_t
+   * types) and afterward the packed sequence is loaded (the
+   * sequence is left empty if the file is not valid)
    *
    * \param fileName The full path of the file to be loaded
    * \return a referenced copy of the sequence after the load
@@ -269,10 +445,35 @@ class CompressedSequence : public Sequence {
   /**
    * \brief Resizes the internal sequence
    *
+   * The sequence is reallocated only when the new size exceeds the
+   * capacity, new elements are set to zero.
+   *
    * \param newSize The new size of the internal sequence
    */
   void resize(size_t newSize);
 
+  /**
+   * \brief Writes the packed bytes of the sequence to a stream
+   */
+  void writePacked(ostream& os) const;
+
+  /**
+   * \brief Reads \c bytes packed bytes from a stream into the
+   * (already initialized) internal sequence
+   */
+  void readPacked(istream& is, size_t bytes);
+
+  /**
+   * \brief Sets to zero the bits following the last element
+   */
+  void clearPadding();
+
+  /**
+   * \brief Returns the 64 bits starting at the given bit offset
+   * (bits past the end of the sequence are zero)
+   */
+  uint64_t loadBits(size_t bitOffset) const;
+
 };
 
 #endif
@@ -0,0 +1,202 @@
+#ifndef COMPRESSED_VARIABLE_READ_SET_H
+#define COMPRESSED_VARIABLE_READ_SET_H
+
+#include "CompressedSequence.h"
+#include <core/Read.hpp>
+
+#include <structures/elias_fano.hpp>
+#include <util/char_span.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief This class represents a compressed set of reads of any
+ * length.
+ *
+ * Unlike CompressedReadSet, reads are not required to have the same
+ * length: the bases of all the reads are stored back to back (without
+ * any padding) in the compressed sequence and the offset of the first
+ * base of each read is kept in an Elias-Fano encoded index, which
+ * takes about \f$ 2 + \log_2 L \f$ bits per read (where \f$ L \f$ is
+ * the average read length) and gives constant time access to any read.
+ *
+ * Bases are stored with 4 bits (IUPAC symbols, see
+ * DNACompressedSymbol) or with 2 bits (see DNAAlphabet2Bits, in this
+ * case symbols other than \c A, \c C, \c G and \c T are stored as \c A).
+ *
+ * \code
+ * CompressedVariableReadSet set(2);
+ * set.append(reads);
+ * std::vector<char> buffer(set.getMaxReadLength());
+ * CompressedVariableReadIterator it(set, buffer.data());
+ * while (it.next()) {
+ *   // it.getBases() ...
+ * }
+ * \endcode
+ *
+ * \sa CompressedReadSet
+ * \sa CompressedVariableReadIterator
+ */
+class CompressedVariableReadSet : public CompressedSequence {
+ private:
+  /**
+   * \brief The offset of the first base of each read, followed by
+   * the total number of bases
+   */
+  lbio::elias_fano offsets;
+  size_t maxReadLength;
+
+ public:
+  // ---------------------------------------------------------
+  // -------------- CONSTRUCTORS AND DESTRUCTOR --------------
+  // ---------------------------------------------------------
+
+  /**
+   * \brief Creates an empty set
+   *
+   * \param bitsPerBase The size of the compressed bases (2 or 4)
+   */
+  CompressedVariableReadSet(size_t bitsPerBase = 4);
+  /**
+   * \brief Creates the set with the given reads
+   *
+   * \param reads The reads to be stored
+   * \param bitsPerBase The size of the compressed bases (2 or 4)
+   */
+  CompressedVariableReadSet(const vector<Read>& reads, size_t bitsPerBase = 4);
+
+  // ---------------------------------------------------------
+  // ------------------ GET AND SET METHODS ------------------
+  // ---------------------------------------------------------
+
+  size_t getReadCount() const;
+  /**
+   * \brief Returns the total number of bases of the reads
+   */
+  size_t getBaseCount() const;
+  size_t getReadLength(size_t i) const;
+  /**
+   * \brief Returns the position (in the compressed sequence) of the
+   * first base of the i-th read
+   */
+  size_t getReadOffset(size_t i) const;
+  /**
+   * \brief Returns the length of the longest read, that is the size
+   * of a buffer able to hold any read
+   */
+  size_t getMaxReadLength() const;
+  /**
+   * \brief Returns the size (in bytes) of the offsets index
+   */
+  size_t getIndexByteCount() const;
+
+  /**
+   * \brief Decodes the bases of the i-th read into \c bases (at
+   * least getReadLength(i) characters)
+   */
+  void decodeRead(size_t i, char* bases) const;
+  /**
+   * \brief Decodes \c length bases starting from the position
+   * \c offset of the compressed sequence
+   */
+  void decodeBases(size_t offset, size_t length, char* bases) const;
+  /**
+   * \brief Returns the bases of the i-th read
+   */
+  string getBases(size_t i) const;
+  /**
+   * \brief Copies the compressed symbols of the i-th read into
+   * \c symbols, one symbol per byte
+   */
+  void unpackRead(size_t i, uint8_t* symbols) const;
+
+  // ---------------------------------------------------------
+  //                      MODIFY METHODS
+  // ---------------------------------------------------------
+
+  /**
+   * \brief Appends the bases of a read
+   *
+   * \param bases The bases of the read
+   * \param length The number of bases
+   * \return This object after append has been performed
+   */
+  CompressedVariableReadSet& append(const char* bases, size_t length);
+  CompressedVariableReadSet& append(const Read& read);
+  CompressedVariableReadSet& append(const Read* reads, size_t count);
+  CompressedVariableReadSet& append(const vector<Read>& reads);
+
+  /**
+   * \brief Makes room for (at least) \c baseCount bases
+   */
+  void reserve(size_t baseCount);
+
+  // ---------------------------------------------------------
+  //                        I/O METHODS
+  // ---------------------------------------------------------
+
+  /**
+   * \brief Writes the set to a binary file.
+   *
+   * The file contains a magic number (\c LBIOVSET), the version,
+   * the size of an element, the number of reads and of bases, the
+   * length of each read (as 64 bits integers) and the packed bases
+   * (see CompressedSequence::getPackedBytes()).
+   *
+   * \sa loadFromFile(const string& fileName)
+   */
+  void writeToFile(const string& fileName) const;
+
+  /**
+   * \brief Loads a file written by writeToFile(), the previous
+   * content of the set is lost
+   *
+   * \return \c false if the file is not a valid variable read set file
+   * (the set is left unchanged, or empty when the sequence is
+   * truncated)
+   */
+  bool loadFromFile(const string& fileName);
+};
+
+/**
+ * \brief Decodes all the reads of a CompressedVariableReadSet one
+ * at a time into a buffer provided by the caller.
+ *
+ * The buffer must hold (at least)
+ * CompressedVariableReadSet::getMaxReadLength() characters and it is
+ * overwritten by each call to next(). Reads are visited in order, so
+ * that only one offset is read from the index for each read.
+ */
+class CompressedVariableReadIterator {
+ private:
+  const CompressedVariableReadSet* set;
+  char* buffer;
+  size_t position;
+  size_t begin;
+  size_t end;
+
+ public:
+  CompressedVariableReadIterator(const CompressedVariableReadSet& set, char* buffer);
+
+  /**
+   * \brief Decodes the next read
+   *
+   * \return \c false when all the reads have been decoded
+   */
+  bool next();
+
+  /**
+   * \brief Returns the index of the last decoded read
+   */
+  size_t getIndex() const;
+
+  /**
+   * \brief Returns the bases of the last decoded read (a view of
+   * the caller buffer)
+   */
+  lbio::char_span getBases() const;
+};
+
+#endif
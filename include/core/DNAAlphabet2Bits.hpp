@@ -1,12 +1,28 @@
 #ifndef DNA_ALPHABET_2BITS_H
 #define DNA_ALPHABET_2BITS_H
 
+#include <cstdint>
 #include <map>
 
 class DNAAlphabet2Bits {
 public:
+  /**
+   * \brief The code given by getCodeTable() to characters that are
+   * not bases
+   */
+  static const uint8_t InvalidCode = 4;
+
   static char intToChar(uint64_t i);
   static uint64_t charToInt(char c);
+  /**
+   * \brief Returns the codes of all the 256 characters, \c A, \c C,
+   * \c G and \c T (also lower case) have codes 0 to 3 while any other
+   * character has code InvalidCode
+   *
+   * Unlike charToInt() this allows to detect \c N and to convert
+   * bases with a table lookup and no function call.
+   */
+  static const uint8_t* getCodeTable();
 
   static std::map<char, uint64_t> charToIntMap();
 };
@@ -5,6 +5,8 @@
 #include <core/QualifiedSequence.hpp>
 #include <core/Sequence.h>
 
+#include <structures/arena.hpp>
+
 #include <string>
 
 /**
@@ -32,6 +34,8 @@ private:
   size_t symbolCount;
   double** probVector;
   size_t length;
+  // false when the matrix lives in an arena
+  bool ownsMatrix;
 public:
 
   // ---------------------------------------------------------
@@ -88,6 +92,21 @@ public:
    * FullQuality(size_t n)
    */
   FullQuality(const QualifiedSequence& qualSeq);
+  /**
+   * \brief Constructs the FullQuality in an arena
+   *
+   * Probabilities are assigned as in
+   * FullQuality(const Quality& qual, const Sequence& seq), but the
+   * matrix is allocated in the given arena (and released with it),
+   * so that the object can itself be created in the arena with
+   * lbio::arena::create().
+   *
+   * \param probs The error probability of each element of the
+   * sequence
+   * \param seq The Sequence from which obtain the characters
+   * \param arena The arena where the matrix is allocated
+   */
+  FullQuality(const double* probs, const Sequence& seq, lbio::arena& arena);
   ~FullQuality();
   // ---------------------------------------------------------
   //                         OPERATORS                        
@@ -110,6 +129,7 @@ private:
   // ---------------------------------------------------------
   //                     UTILITY FUNCTIONS                    
   // ---------------------------------------------------------
+  void setProbabilities(const double* probs, const Sequence& seq);
   double** initProbMatrix(size_t rows, size_t cols);
   void destroyProbMatrix(double** v, size_t rows, size_t cols);
 };
@@ -121,6 +141,7 @@ FullQuality<C>::FullQuality(size_t n) {
   this->symbolCount = C::length();
   this->length = n;
   this->probVector = initProbMatrix(this->symbolCount, this->length);
+  this->ownsMatrix = true;
 }
 
 template<class C>
@@ -128,19 +149,11 @@ FullQuality<C>::FullQuality(const Quality& qual, const Sequence& seq) {
   this->length = std::min(qual.length(), seq.getSequenceLength());
   this->symbolCount = C::length();
   this->probVector = initProbMatrix(this->symbolCount, this->length);
+  this->ownsMatrix = true;
   // get the probabilities vector
   double* probs = qual.getProbabilities();
-  // loop through all elements
-  for (size_t pos = 0; pos < this->length; ++pos) {
-    // get the index for the actual symbol
-    size_t symbolIndex = C::getIndex(seq.getBaseAt(pos));
-    double remind_p = (probs[pos] ) / ((double)(this->symbolCount - 1));
-    // loop through all symbols
-    for (size_t sym = 0; sym < this->symbolCount; ++sym) {
-      this->probVector[sym][pos] = remind_p;
-    }
-    this->probVector[symbolIndex][pos] = 1.0 - probs[pos];
-  }
+  setProbabilities(probs, seq);
+  delete[] probs;
 }
 
 template<class C>
@@ -149,9 +162,23 @@ FullQuality<C>::FullQuality(const QualifiedSequence& qualSeq)
 {
 }
 
+template<class C>
+FullQuality<C>::FullQuality(const double* probs, const Sequence& seq, lbio::arena& arena) {
+  this->length = seq.getSequenceLength();
+  this->symbolCount = C::length();
+  this->probVector = arena.allocate_array<double*>(this->symbolCount);
+  for (size_t i = 0; i < this->symbolCount; ++i) {
+    this->probVector[i] = arena.allocate_array<double>(this->length);
+  }
+  this->ownsMatrix = false;
+  setProbabilities(probs, seq);
+}
+
 template<class C>
 FullQuality<C>::~FullQuality() {
-  destroyProbMatrix(this->probVector, this->symbolCount, this->length);
+  if (this->ownsMatrix) {
+    destroyProbMatrix(this->probVector, this->symbolCount, this->length);
+  }
 }
 
 /************************* OPERATORS ************************/
@@ -166,6 +193,21 @@ double* FullQuality<C>::operator[] (char c) {
 
 /********************* UTILITY FUNCTIONS ********************/
 
+template<class C>
+void FullQuality<C>::setProbabilities(const double* probs, const Sequence& seq) {
+  // loop through all elements
+  for (size_t pos = 0; pos < this->length; ++pos) {
+    // get the index for the actual symbol
+    size_t symbolIndex = C::getIndex(seq.getBaseAt(pos));
+    double remind_p = (probs[pos] ) / ((double)(this->symbolCount - 1));
+    // loop through all symbols
+    for (size_t sym = 0; sym < this->symbolCount; ++sym) {
+      this->probVector[sym][pos] = remind_p;
+    }
+    this->probVector[symbolIndex][pos] = 1.0 - probs[pos];
+  }
+}
+
 template<class C>
 double** FullQuality<C>::initProbMatrix(size_t rows, size_t cols) {
   double** v = new double*[rows];
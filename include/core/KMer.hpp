@@ -3,6 +3,9 @@
 
 #include <core/Sequence.h>
 
+#include <structures/arena.hpp>
+#include <util/char_span.hpp>
+
 #include <cstdint>
 #include <string>
 #include <iostream>
@@ -116,4 +119,12 @@ public:
   char getBaseAt(size_t i) const;
 };
 
+/**
+ * \brief The k-mers of a sequence as views of its characters, the
+ * container is allocated in an arena
+ *
+ * \sa Read::getKMerList(size_t k, lbio::arena& arena)
+ */
+typedef lbio::arena_vector< lbio::char_span > KMerSpanList;
+
 #endif
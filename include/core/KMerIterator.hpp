@@ -0,0 +1,316 @@
+#ifndef K_MER_ITERATOR_H
+#define K_MER_ITERATOR_H
+
+#include <core/CompressedSequence.h>
+#include <core/DNAAlphabet2Bits.hpp>
+#include <core/NumericKMer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * \brief Reads the 2 bits codes of the bases of a sequence one at a
+ * time, used by KMerIterator.
+ *
+ * The class is specialized for the supported inputs: a raw character
+ * buffer (<tt>const char*</tt>), a \c std::string and a
+ * CompressedSequence (with 2 or 4 bits elements). Each specialization
+ * provides \c atEnd() and \c next(), the latter returns the code of
+ * the next base (see DNAAlphabet2Bits) or DNAAlphabet2Bits::InvalidCode
+ * for anything that is not \c A, \c C, \c G or \c T.
+ */
+template<class T>
+class KMerSource;
+
+template<>
+class KMerSource<const char*> {
+ private:
+  const char* bases;
+  const char* end;
+  const uint8_t* table;
+
+ public:
+  KMerSource(const char* bases, size_t length)
+    : bases(bases), end(bases + length), table(DNAAlphabet2Bits::getCodeTable())
+  {
+  }
+
+  bool atEnd() const {
+    return this->bases == this->end;
+  }
+
+  uint8_t next() {
+    return this->table[(uint8_t)*(this->bases++)];
+  }
+};
+
+template<>
+class KMerSource<std::string> : public KMerSource<const char*> {
+ public:
+  KMerSource(const std::string& bases)
+    : KMerSource<const char*>(bases.data(), bases.size())
+  {
+  }
+
+  KMerSource(const std::string& bases, size_t begin, size_t length)
+    : KMerSource<const char*>(bases.data() + begin, length)
+  {
+  }
+};
+
+/**
+ * \brief Reads the elements of a CompressedSequence directly from its
+ * words (one word load every 32 or 16 bases).
+ *
+ * Elements of 2 bits are taken as codes, elements of 4 bits as IUPAC
+ * symbols (see DNACompressedSymbol) where only \c A, \c C, \c G and
+ * \c T are valid bases. Other element sizes are rejected with a
+ * \c std::domain_error.
+ */
+template<>
+class KMerSource<CompressedSequence> {
+ private:
+  const uint64_t* words;
+  uint64_t word;
+  size_t bitsLeft;
+  size_t remaining;
+  size_t elSize;
+  uint8_t mask;
+
+ public:
+  KMerSource(const CompressedSequence& sequence)
+    : KMerSource(sequence, 0, sequence.getSequenceLength())
+  {
+  }
+
+  /**
+   * \brief Reads the \c length elements starting at \c begin (for
+   * instance a single read of a CompressedReadSet)
+   */
+  KMerSource(const CompressedSequence& sequence, size_t begin, size_t length)
+    : words(sequence.getRawSequence()), word(0), bitsLeft(0), remaining(length),
+      elSize(sequence.getElementSize()), mask((uint8_t)((1 << sequence.getElementSize()) - 1))
+  {
+    if (this->elSize != 2 && this->elSize != 4) {
+      throw std::domain_error("k-mers can only be read from 2 or 4 bits elements");
+    }
+    if (begin + length > sequence.getSequenceLength()) {
+      throw std::domain_error("k-mer range exceeds the sequence");
+    }
+    size_t bit = begin * this->elSize;
+    this->words += bit / 64;
+    if (length > 0 && bit % 64 != 0) {
+      this->word = *(this->words++);
+      this->bitsLeft = 64 - bit % 64;
+    }
+  }
+
+  bool atEnd() const {
+    return this->remaining == 0;
+  }
+
+  uint8_t next() {
+    // IUPAC numbers of A, C, G and T are 1, 2, 4 and 8
+    static const uint8_t iupacCodes[16] = {
+      4, 0, 1, 4, 2, 4, 4, 4, 3, 4, 4, 4, 4, 4, 4, 4
+    };
+    if (this->bitsLeft == 0) {
+      this->word = *(this->words++);
+      this->bitsLeft = 64;
+    }
+    this->bitsLeft -= this->elSize;
+    this->remaining--;
+    uint8_t value = (uint8_t)(this->word >> this->bitsLeft) & this->mask;
+    return (this->elSize == 2) ? value : iupacCodes[value];
+  }
+};
+
+/**
+ * \brief Rolling iterator over the k-mers of a sequence.
+ *
+ * Each k-mer is encoded with 2 bits per base (as in
+ * seq::NumericKMer, the first base in the most significant bits) and
+ * the codes are updated with one shift per base, both for the forward
+ * strand and for the reverse complement. K-mers containing bases
+ * other than \c A, \c C, \c G and \c T (e.g. \c N) are skipped: the
+ * iterator restarts after the invalid base.
+ *
+ * The type of the input is a template parameter (see KMerSource), so
+ * that the inner loop is specialized at compile time and performs no
+ * virtual call. Codes are made of \c W words (see seq::KMerWord),
+ * \f$ k \f$ must be in \f$ [1, 32W] \f$ (otherwise the constructor
+ * throws a \c std::domain_error): with the default \c W=1 codes are
+ * \c uint64_t values.
+ *
+ * \code
+ * KMerIterator<std::string> it(bases, k);
+ * while (it.next()) {
+ *   counts[it.getCanonical()]++;
+ * }
+ * \endcode
+ *
+ * \sa KMerSource
+ */
+template<class T, size_t W = 1>
+class KMerIterator {
+ public:
+  typedef seq::KMerWord<W> Word;
+  typedef typename Word::type CodeType;
+
+ private:
+  KMerSource<T> source;
+  size_t k;
+  CodeType mask;
+  size_t shift;
+  CodeType forward;
+  CodeType reverse;
+  // number of valid bases since the last invalid one
+  size_t valid;
+  // number of bases read so far
+  size_t position;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  /**
+   * \brief Iterates over the k-mers of a raw buffer of bases (only
+   * for <tt>T = const char*</tt>)
+   */
+  KMerIterator(const char* bases, size_t length, size_t k)
+    : source(bases, length)
+  {
+    init(k);
+  }
+  /**
+   * \brief Iterates over the k-mers of a whole sequence
+   */
+  KMerIterator(const T& sequence, size_t k)
+    : source(sequence)
+  {
+    init(k);
+  }
+  /**
+   * \brief Iterates over the k-mers of \c length bases starting at
+   * \c begin
+   */
+  KMerIterator(const T& sequence, size_t begin, size_t length, size_t k)
+    : source(sequence, begin, length)
+  {
+    init(k);
+  }
+
+  // ---------------------------------------------------------
+  //                     ITERATION METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Moves to the next k-mer made only of valid bases
+   *
+   * \return \c false when the end of the sequence is reached
+   */
+  bool next() {
+    while (!this->source.atEnd()) {
+      uint8_t c = this->source.next();
+      this->position++;
+      if (c >= DNAAlphabet2Bits::InvalidCode) {
+	this->valid = 0;
+	continue;
+      }
+      Word::shiftIn(this->forward, c, this->mask);
+      Word::shiftInReverse(this->reverse, 3 - c, this->shift);
+      if (++this->valid >= this->k) {
+	return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * \brief Returns the code of the current k-mer
+   */
+  const CodeType& getForward() const {
+    return this->forward;
+  }
+  /**
+   * \brief Returns the code of the reverse complement of the current
+   * k-mer
+   */
+  const CodeType& getReverse() const {
+    return this->reverse;
+  }
+  /**
+   * \brief Returns the smallest code between the k-mer and its
+   * reverse complement
+   */
+  const CodeType& getCanonical() const {
+    return Word::less(this->forward, this->reverse) ? this->forward : this->reverse;
+  }
+  /**
+   * \brief Returns the position (in the input) of the first base of
+   * the current k-mer
+   */
+  size_t getPosition() const {
+    return this->position - this->k;
+  }
+  size_t getK() const {
+    return this->k;
+  }
+
+ private:
+  void init(size_t k) {
+    if (k == 0 || k > 32 * W) {
+      throw std::domain_error("k-mer length must be in [1, 32W]");
+    }
+    this->k = k;
+    this->mask = Word::lowMask(k);
+    this->shift = 2 * (k - 1);
+    this->forward = CodeType();
+    this->reverse = CodeType();
+    this->valid = 0;
+    this->position = 0;
+  }
+};
+
+/**
+ * \brief Calls <tt>f(code, position)</tt> for each k-mer of the
+ * \c length elements of a Sequence starting at \c begin
+ *
+ * The KMerIterator is chosen once according to the actual type of
+ * the sequence (CompressedSequence or a sequence of characters, such
+ * as Read and Reference), so that no virtual call is made per base.
+ *
+ * \param s The sequence
+ * \param begin The first element to scan
+ * \param length The number of elements to scan
+ * \param k The length of the k-mers (at most \f$ 32W \f$)
+ * \param f The function receiving the forward code and the position
+ * (relative to \c begin) of each k-mer
+ */
+template<size_t W = 1, class F>
+void forEachKMer(const Sequence& s, size_t begin, size_t length, size_t k, F f) {
+  const CompressedSequence* packed = dynamic_cast<const CompressedSequence*>(&s);
+  if (packed != NULL) {
+    KMerIterator<CompressedSequence, W> it(*packed, begin, length, k);
+    while (it.next()) {
+      f(it.getForward(), it.getPosition());
+    }
+  } else {
+    KMerIterator<const char*, W> it((const char*)s.getSequence() + begin, length, k);
+    while (it.next()) {
+      f(it.getForward(), it.getPosition());
+    }
+  }
+}
+
+/**
+ * \brief Calls <tt>f(code, position)</tt> for each k-mer of a
+ * Sequence
+ */
+template<size_t W = 1, class F>
+void forEachKMer(const Sequence& s, size_t k, F f) {
+  forEachKMer<W>(s, 0, s.getSequenceLength(), k, f);
+}
+
+#endif
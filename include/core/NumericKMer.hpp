@@ -2,7 +2,12 @@
 #define NUMERIC_KMER_H
 
 #include <core/Sequence.h>
+#include <core/DNAAlphabet2Bits.hpp>
+
+#include <array>
+#include <cstdint>
 #include <iostream>
+#include <string>
 
 namespace seq
 {
@@ -40,5 +45,251 @@ public:
   static uint64_t fromChars(const char* chars, size_t k);
 };
 
+// -----------------------------------------------------------------------------
+//                          MULTI WORD NUMERIC K-MERS
+// -----------------------------------------------------------------------------
+
+// finalizer of MurmurHash3, spreads the bits of the k-mer codes
+// (whose high bits are often zero) over the whole word
+inline uint64_t mixKMerBits(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+/**
+ * \brief Operations on k-mer codes stored in a native unsigned
+ * integer (2 bits per base, the last base in the least significant
+ * bits)
+ */
+template<class T>
+struct NativeKMerWord {
+  typedef T type;
+
+  static type lowMask(size_t k) {
+    return (k >= 4 * sizeof(T)) ? ~(type)0 : ((type)1 << (2 * k)) - 1;
+  }
+  /**
+   * \brief Appends a base code at the end of the k-mer, the first
+   * base is dropped by \c mask
+   */
+  static void shiftIn(type& v, uint8_t code, const type& mask) {
+    v = ((v << 2) | code) & mask;
+  }
+  /**
+   * \brief Prepends a base code (at bit \c shift, that is
+   * \f$ 2(k-1) \f$) dropping the last base, this is the update of
+   * the reverse complement when a base is appended to the k-mer
+   */
+  static void shiftInReverse(type& v, uint8_t code, size_t shift) {
+    v = (v >> 2) | ((type)code << shift);
+  }
+  static uint8_t codeAt(const type& v, size_t i, size_t k) {
+    return (uint8_t)(v >> (2 * (k - 1 - i))) & 0x3;
+  }
+  static bool less(const type& a, const type& b) {
+    return a < b;
+  }
+  static size_t hash(const type& v) {
+    size_t h = 0;
+    for (size_t i = 0; i < sizeof(T) / sizeof(uint64_t); ++i) {
+      h = mixKMerBits(h ^ (uint64_t)(v >> (64 * i)));
+    }
+    return h;
+  }
+};
+
+/**
+ * \brief Operations on k-mer codes stored in \c W 64 bits words, the
+ * first word is the most significant one (so that arrays compare as
+ * the numbers they represent)
+ */
+template<size_t W>
+struct ArrayKMerWord {
+  typedef std::array<uint64_t, W> type;
+
+  static type lowMask(size_t k) {
+    type mask;
+    for (size_t i = 0; i < W; ++i) {
+      // bits [64j, 64j + 64) of the number
+      size_t j = W - 1 - i;
+      mask[i] = (2 * k >= 64 * (j + 1)) ? ~(uint64_t)0 :
+	(2 * k <= 64 * j) ? 0 : ((uint64_t)1 << (2 * k - 64 * j)) - 1;
+    }
+    return mask;
+  }
+  static void shiftIn(type& v, uint8_t code, const type& mask) {
+    for (size_t i = 0; i + 1 < W; ++i) {
+      v[i] = ((v[i] << 2) | (v[i + 1] >> 62)) & mask[i];
+    }
+    v[W - 1] = ((v[W - 1] << 2) | code) & mask[W - 1];
+  }
+  static void shiftInReverse(type& v, uint8_t code, size_t shift) {
+    for (size_t i = W - 1; i > 0; --i) {
+      v[i] = (v[i] >> 2) | (v[i - 1] << 62);
+    }
+    v[0] >>= 2;
+    v[W - 1 - shift / 64] |= (uint64_t)code << (shift % 64);
+  }
+  static uint8_t codeAt(const type& v, size_t i, size_t k) {
+    size_t bit = 2 * (k - 1 - i);
+    return (uint8_t)(v[W - 1 - bit / 64] >> (bit % 64)) & 0x3;
+  }
+  static bool less(const type& a, const type& b) {
+    return a < b;
+  }
+  static size_t hash(const type& v) {
+    size_t h = 0;
+    for (size_t i = 0; i < W; ++i) {
+      h = mixKMerBits(h ^ v[i]);
+    }
+    return h;
+  }
+};
+
+/**
+ * \brief Storage and operations of a k-mer code made of \c W 64 bits
+ * words, that is for \f$ k \le 32W \f$.
+ *
+ * One word uses \c uint64_t, two words use \c unsigned \c __int128
+ * (when the compiler supports it), larger sizes use
+ * <tt>std::array<uint64_t,W></tt>. All the operations are static and
+ * specialized for each width.
+ */
+template<size_t W>
+struct KMerWord : public ArrayKMerWord<W> {
+};
+
+template<>
+struct KMerWord<1> : public NativeKMerWord<uint64_t> {
+};
+
+#ifdef __SIZEOF_INT128__
+template<>
+struct KMerWord<2> : public NativeKMerWord<unsigned __int128> {
+};
+#endif
+
+/**
+ * \brief A numeric k-mer of (at most) \f$ 32W \f$ bases.
+ *
+ * The k-mer is encoded with 2 bits per base as NumericKMer, which is
+ * limited to \f$ k \le 32 \f$, but the code spans \c W words (see
+ * KMerWord). Codes can be rolled (a base appended and the first one
+ * dropped), compared and hashed (see KMerHash) so they can be used as
+ * keys of hash tables.
+ *
+ * \code
+ * BasicNumericKMer<2> kmer = BasicNumericKMer<2>::fromChars(bases, 55);
+ * kmer.roll(bases[55]);
+ * \endcode
+ *
+ * \sa KMerIterator
+ */
+template<size_t W>
+class BasicNumericKMer {
+public:
+  typedef typename KMerWord<W>::type CodeType;
+
+  static const size_t KMax = 32 * W;
+
+private:
+  CodeType code;
+  CodeType mask;
+  size_t k;
+
+public:
+  // CONSTRUCTORS
+  BasicNumericKMer(size_t k)
+    : code(), mask(KMerWord<W>::lowMask(k)), k(k)
+  {
+  }
+
+  BasicNumericKMer(const CodeType& code, size_t k)
+    : code(code), mask(KMerWord<W>::lowMask(k)), k(k)
+  {
+  }
+
+  // GET METHODS
+  const CodeType& getCode() const {
+    return this->code;
+  }
+
+  size_t getK() const {
+    return this->k;
+  }
+
+  char getBaseAt(size_t i) const {
+    return DNAAlphabet2Bits::intToChar(KMerWord<W>::codeAt(this->code, i, this->k));
+  }
+
+  std::string toString() const {
+    std::string out(this->k, 'A');
+    for (size_t i = 0; i < this->k; ++i) {
+      out[i] = getBaseAt(i);
+    }
+    return out;
+  }
+
+  // ROLLING UPDATE
+  /**
+   * \brief Appends a base and drops the first one (symbols that are
+   * not bases are taken as \c A, as in NumericKMer::fromChars())
+   */
+  void roll(char c) {
+    uint8_t base = DNAAlphabet2Bits::getCodeTable()[(uint8_t)c];
+    KMerWord<W>::shiftIn(this->code, base & 0x3, this->mask);
+  }
+
+  // COMPARISON AND HASHING
+  bool operator==(const BasicNumericKMer& other) const {
+    return (this->k == other.k) && (this->code == other.code);
+  }
+
+  bool operator!=(const BasicNumericKMer& other) const {
+    return !(*this == other);
+  }
+
+  bool operator<(const BasicNumericKMer& other) const {
+    return KMerWord<W>::less(this->code, other.code);
+  }
+
+  size_t hash() const {
+    return KMerWord<W>::hash(this->code);
+  }
+
+  // STATIC UTILITY METHODS
+  static BasicNumericKMer fromChars(const char* chars, size_t k) {
+    BasicNumericKMer kmer(k);
+    for (size_t i = 0; i < k; ++i) {
+      kmer.roll(chars[i]);
+    }
+    return kmer;
+  }
+};
+
+template<size_t W>
+std::ostream& operator<< (std::ostream& os, const BasicNumericKMer<W>& kmer) {
+  os << kmer.toString();
+  return os;
+}
+
+/**
+ * \brief Hash function for k-mer codes and BasicNumericKMer, to be
+ * used with the standard unordered containers
+ */
+template<size_t W>
+struct KMerHash {
+  size_t operator()(const typename KMerWord<W>::type& code) const {
+    return KMerWord<W>::hash(code);
+  }
+  size_t operator()(const BasicNumericKMer<W>& kmer) const {
+    return kmer.hash();
+  }
+};
+
 }
 #endif
@@ -53,7 +53,8 @@ PhredQuality(const int* quals, size_t n);
    *
    * The input string must contain a number of integer as indicated in the
    * second parameter, numbers must be separated using space
-   * characters (i.e. blank, tab, newlen , ... ).
+   * characters (i.e. blank, tab, newlen , ... ). Negative values
+   * (the \c -1 of missing calls) are stored as 0.
    *
    * \param quals The string containing quality values
    * \param n The number of values containing in the input string
@@ -109,6 +110,21 @@ PhredQuality(const std::string& quals, size_t n);
    */
   static int toPhred(double p);
 
+  /**
+   * \brief Parses integer quality values separated by white spaces
+   * (or commas) as found in color space \c .qual files.
+   *
+   * The string is scanned once without any allocation, negative
+   * values (e.g. the \c -1 used for missing calls) are allowed.
+   *
+   * \param s The characters to be parsed
+   * \param length The number of characters
+   * \param out The vector where values are stored
+   * \param maxValues The size of \c out, further values are ignored
+   * \return The number of values found (may exceed \c maxValues)
+   */
+  static size_t parseQualityValues(const char* s, size_t length, int* out, size_t maxValues);
+
   static void fromSangerQualities(const std::string& q, double* p);
   static void fromIlluminaQualities(const std::string& q, double* p);
   static void fromSolexaQualities(const std::string& q, double* p);
@@ -79,25 +79,56 @@ class Read : public Sequence {
    * \param qualities The new quality string
    */
   void setQualities(const std::string& qualities);
+  /**
+   * \brief Sets the header of the Read from a raw character buffer
+   *
+   * The internal string is reassigned in place so that its capacity
+   * is reused when the same Read object is loaded many times.
+   *
+   * \param header Pointer to the first character of the header
+   * \param n The number of characters to copy
+   */
+  void setHeader(const char* header, size_t n);
+  /**
+   * \brief Sets the base sequence of the Read from a raw character
+   * buffer (reusing the capacity of the internal string)
+   *
+   * \param bases Pointer to the first base
+   * \param n The number of bases to copy
+   */
+  void setBases(const char* bases, size_t n);
+  /**
+   * \brief Sets the qualities string of the Read from a raw
+   * character buffer (reusing the capacity of the internal string)
+   *
+   * \param qualities Pointer to the first quality character
+   * \param n The number of characters to copy
+   */
+  void setQualities(const char* qualities, size_t n);
 
   /**
    * \brief Returns the header of the Read
    *
+   * The reference remains valid until the Read is modified or
+   * destroyed, a copy must be made to keep the header longer.
+   *
    * \return The stored header
    */
-  std::string getHeader() const;
+  const std::string& getHeader() const;
   /**
    * \brief Returns the sequence of bases of the Read
    *
-   * \return The stored base sequence
+   * \return The stored base sequence (see getHeader() for the
+   * lifetime of the reference)
    */
-  std::string getBases() const;
+  const std::string& getBases() const;
   /**
    * \brief Returns the quality string of the Read
    *
-   * \return The stored quality string
+   * \return The stored quality string (see getHeader() for the
+   * lifetime of the reference)
    */
-  std::string getQualities() const;
+  const std::string& getQualities() const;
   /**
    * \brief Returns the length (in bases) of the string
    *
@@ -119,6 +150,19 @@ class Read : public Sequence {
    *
    */
   std::list<KMer> getKMerList(size_t k) const;
+  /**
+   * \brief Returns all the k-mers as views of the bases of the Read.
+   *
+   * No k-mer is copied and the container is allocated in the given
+   * arena, so building the list costs no heap allocation once the
+   * arena has grown. The k-mers remain valid until the Read is
+   * modified and the container until the arena is released.
+   *
+   * \param k the size of the k-mer
+   * \param arena The arena where the container is allocated
+   * \return The \f$ n - k + 1 \f$ k-mers of the read
+   */
+  KMerSpanList getKMerList(size_t k, lbio::arena& arena) const;
 
   // ---------------------------------------------------------
   //                     MODIFY OPERATION
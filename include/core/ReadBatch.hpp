@@ -0,0 +1,166 @@
+#ifndef READ_BATCH_H
+#define READ_BATCH_H
+
+#include "Read.hpp"
+#include "Sequence.h"
+
+#include <util/char_span.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * \brief A non owning view of a read.
+ *
+ * Header, bases and qualities are spans over memory owned by someone
+ * else (typically a ReadBatch or a Read), no copy is made when the
+ * record is created or passed around. The record implements Sequence
+ * so it can be given to any algorithm working on a Sequence (e.g.
+ * k-mers extraction) without materializing a Read.
+ *
+ * \sa ReadBatch
+ */
+class ReadRecord : public Sequence {
+ private:
+  lbio::char_span header;
+  lbio::char_span bases;
+  lbio::char_span qualities;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  /**
+   * \brief Creates an empty record
+   */
+  ReadRecord();
+  ReadRecord(lbio::char_span header, lbio::char_span bases, lbio::char_span qualities);
+  /**
+   * \brief Creates a view of the fields of a Read, the record is
+   * valid until the Read is modified or destroyed
+   */
+  explicit ReadRecord(const Read& read);
+
+  // ---------------------------------------------------------
+  //                    SET AND GET METHODS
+  // ---------------------------------------------------------
+  lbio::char_span getHeader() const;
+  lbio::char_span getBases() const;
+  lbio::char_span getQualities() const;
+  /**
+   * \brief Returns the length (in bases) of the record
+   */
+  size_t length() const;
+
+  /**
+   * \brief Copies the record into an existing Read (reusing the
+   * capacity of its strings)
+   */
+  void copyTo(Read& read) const;
+
+  // ---------------------------------------------------------
+  //                 'SEQUENCE' CLASS OVERRIDE
+  // ---------------------------------------------------------
+  const void* getSequence() const;
+  size_t getSequenceLength() const;
+  size_t getElementSize() const;
+  size_t getByteCount() const;
+  char getBaseAt(size_t i) const;
+};
+
+/**
+ * \brief A batch of reads whose fields live in one contiguous block.
+ *
+ * Headers, bases and qualities of all the reads are stored back to
+ * back in a single character buffer owned by the batch, while a
+ * second array keeps the offset of each field, so that storing a read
+ * costs no allocation once the buffer has grown to the size of a
+ * typical batch. clear() releases all the reads at once and keeps the
+ * memory for the next batch.
+ *
+ * Reads are accessed as ReadRecord objects pointing into the buffer,
+ * records are invalidated by clear() and by any append() (which may
+ * move the buffer).
+ *
+ * \code
+ * ReadBatch batch;
+ * for (...) {
+ *   batch.clear();
+ *   // batch.append(read) ...
+ *   for (size_t i = 0; i < batch.size(); ++i) {
+ *     ReadRecord r = batch.getRecord(i);
+ *   }
+ * }
+ * \endcode
+ *
+ * \sa ReadRecord
+ */
+class ReadBatch {
+ private:
+  std::vector< char > data;
+  // 3 offsets per read (header, bases, qualities) plus the end
+  std::vector< size_t > offsets;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  /**
+   * \brief Creates an empty batch
+   *
+   * \param bytesHint The initial size (in bytes) of the buffer
+   */
+  ReadBatch(size_t bytesHint = 0);
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Returns the number of reads in the batch
+   */
+  size_t size() const;
+  bool empty() const;
+  /**
+   * \brief Returns the number of bytes used by the fields of the
+   * reads
+   */
+  size_t getByteCount() const;
+  /**
+   * \brief Returns a view of the i-th read of the batch
+   */
+  ReadRecord getRecord(size_t i) const;
+  /**
+   * \brief Copies the i-th read into an existing Read
+   */
+  void copyTo(size_t i, Read& read) const;
+
+  // ---------------------------------------------------------
+  //                     MODIFY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Appends a read to the batch
+   *
+   * The fields may be views of reads of this batch.
+   *
+   * \return The index of the read in the batch
+   */
+  size_t append(const char* header, size_t headerLength,
+		const char* bases, size_t basesLength,
+		const char* qualities, size_t qualitiesLength);
+  size_t append(const ReadRecord& record);
+  size_t append(const Read& read);
+  /**
+   * \brief Makes room for \c reads reads taking \c bytes bytes
+   */
+  void reserve(size_t reads, size_t bytes);
+  /**
+   * \brief Removes all the reads (the allocated memory is kept)
+   */
+  void clear();
+
+ private:
+  void appendField(const char* field, size_t n);
+};
+
+#endif
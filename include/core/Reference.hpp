@@ -111,6 +111,18 @@ public:
    * \sa KMers
    */
   list<KMer> getKMerList(size_t k);
+  /**
+   * \brief Returns all k-mers as views of the reference sequence
+   *
+   * Same as getKMerList(size_t k) but no k-mer is copied and the
+   * container is allocated in the given arena (see
+   * Read::getKMerList(size_t k, lbio::arena& arena)).
+   *
+   * \param k The length of the returned substring
+   * \param arena The arena where the container is allocated
+   * \return The \f$ n - k + 1 \f$ k-mers of the reference
+   */
+  KMerSpanList getKMerList(size_t k, lbio::arena& arena) const;
 
   // ---------------------------------------------------------
   //                     CONVERSION METHODS
@@ -8,8 +8,11 @@
 #include <core/CompressedSequence.h>
 #include <core/DNACompressedSymbol.h>
 #include <core/CompressedReadSet.h>
+#include <core/CompressedReadRange.h>
+#include <core/CompressedVariableReadSet.h>
 
 #include <core/Read.hpp>
+#include <core/ReadBatch.hpp>
 #include <core/Reference.hpp>
 #include <core/KMer.hpp>
 
@@ -19,6 +22,8 @@
 #include <core/DNAAlphabet2Bits.hpp>
 
 #include <core/NumericKMer.hpp>
+#include <core/KMerIterator.hpp>
+#include <core/BaseEncoder.hpp>
 
 
 #include <core/DNAAlphabet2Bits.hpp>
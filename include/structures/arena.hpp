@@ -0,0 +1,259 @@
+// arena.hpp
+// Bump allocator for objects sharing the same lifetime
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+   \file structures/arena.hpp
+   Contains a bump (arena) allocator and an STL allocator adapter, so
+   that standard containers can allocate from an arena.
+ */
+
+#ifndef LBIO_ARENA_HPP
+#define LBIO_ARENA_HPP
+
+#include <lbio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+DEFAULT_NAMESPACE_BEGIN
+
+/**
+   \brief A bump allocator releasing all its objects at once.
+
+   Memory is taken from a chain of large blocks by moving a pointer
+   forward, there is no per object bookkeeping and deallocation of a
+   single object is a no-op. release() makes all the memory available
+   again in constant time; the blocks are kept, so that an arena used
+   for one batch after the other stops allocating once it has grown to
+   the size of a typical batch.
+
+   Destructors of the objects created in the arena are \b not run,
+   only objects that do not own other resources (no \c std::string,
+   no heap pointers) should be created with create().
+
+   \code
+   lbio::arena _arena;
+   for (...) {
+     _arena.release();
+     // objects of this batch are created in _arena ...
+   }
+   \endcode
+ */
+class arena
+{
+public:
+  typedef lbio_size_t    size_type;
+
+  static const size_type default_block_size = 64 * 1024;
+
+  explicit arena(size_type _bs = default_block_size)
+    : _first {nullptr}, _current {nullptr}, _ptr {0}, _end {0},
+      _block_size {_bs}, _used {0} { }
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  ~arena() { clear(); }
+
+  /**
+     \brief Returns \c _n bytes aligned to \c _align (a power of two)
+   */
+  void*
+  allocate(size_type _n, size_type _align = alignof(std::max_align_t)) {
+    uintptr_t _p = (_ptr + _align - 1) & ~(uintptr_t)(_align - 1);
+    if (_current == nullptr || _p + _n > _end) {
+      next_block(_n + _align);
+      _p = (_ptr + _align - 1) & ~(uintptr_t)(_align - 1);
+    }
+    _ptr = _p + _n;
+    _used += _n;
+    return reinterpret_cast<void*>(_p);
+  }
+
+  /**
+     \brief Returns uninitialized memory for \c _n objects of type T
+   */
+  template <typename T>
+  T*
+  allocate_array(size_type _n) {
+    return static_cast<T*>(allocate(_n * sizeof(T), alignof(T)));
+  }
+
+  /**
+     \brief Constructs an object in the arena (its destructor will
+     never be called)
+   */
+  template <typename T, typename... Args>
+  T*
+  create(Args&&... _args) {
+    return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(_args)...);
+  }
+
+  /**
+     \brief Releases all the objects, the memory is kept for reuse
+   */
+  void
+  release() {
+    _current = _first;
+    _ptr = (_first == nullptr) ? 0 : data(_first);
+    _end = (_first == nullptr) ? 0 : _ptr + _first->_size;
+    _used = 0;
+  }
+
+  /**
+     \brief Releases all the objects and gives the memory back to the
+     system
+   */
+  void
+  clear() {
+    while (_first != nullptr) {
+      block* _next = _first->_next;
+      ::operator delete(_first);
+      _first = _next;
+    }
+    _current = nullptr;
+    _ptr = _end = 0;
+    _used = 0;
+  }
+
+  /**
+     \brief Returns the number of bytes allocated since the last
+     release()
+   */
+  size_type
+  bytes_used() const { return _used; }
+
+  /**
+     \brief Returns the total size of the blocks owned by the arena
+   */
+  size_type
+  capacity() const {
+    size_type _total = 0;
+    for (block* _b = _first; _b != nullptr; _b = _b->_next) {
+      _total += _b->_size;
+    }
+    return _total;
+  }
+
+private:
+  struct block {
+    block*      _next;
+    size_type   _size;
+  };
+
+  static uintptr_t
+  data(block* _b) {
+    return reinterpret_cast<uintptr_t>(_b) + sizeof(block);
+  }
+
+  // moves to the next block of the chain with (at least) _n bytes,
+  // blocks kept by release() are reused before allocating new ones
+  void
+  next_block(size_type _n) {
+    while (_current != nullptr && _current->_next != nullptr) {
+      _current = _current->_next;
+      if (_current->_size >= _n) {
+	_ptr = data(_current);
+	_end = _ptr + _current->_size;
+	return;
+      }
+    }
+    size_type _size = (_n > _block_size) ? _n : _block_size;
+    block* _b = static_cast<block*>(::operator new(sizeof(block) + _size));
+    _b->_next = nullptr;
+    _b->_size = _size;
+    if (_current == nullptr) {
+      _first = _b;
+    } else {
+      _current->_next = _b;
+    }
+    _current = _b;
+    _ptr = data(_b);
+    _end = _ptr + _size;
+  }
+
+  block*      _first;
+  block*      _current;
+  uintptr_t   _ptr;
+  uintptr_t   _end;
+  size_type   _block_size;
+  size_type   _used;
+};
+
+/**
+   \brief Standard allocator taking memory from an arena.
+
+   Containers using this allocator must not outlive the arena nor be
+   used after arena::release(). Memory given back by the container is
+   not reused until the arena is released, containers should
+   therefore be reserved to their final size when possible.
+ */
+template <typename T>
+class arena_allocator
+{
+public:
+  typedef T    value_type;
+
+  template <typename U>
+  struct rebind { typedef arena_allocator<U> other; };
+
+  arena_allocator(arena& _a)
+    : _arena {&_a} { }
+
+  template <typename U>
+  arena_allocator(const arena_allocator<U>& _other)
+    : _arena {_other.get_arena()} { }
+
+  T*
+  allocate(std::size_t _n) {
+    return _arena->allocate_array<T>(_n);
+  }
+
+  void
+  deallocate(T*, std::size_t) { }
+
+  arena*
+  get_arena() const { return _arena; }
+
+  template <typename U>
+  bool
+  operator==(const arena_allocator<U>& _other) const {
+    return _arena == _other.get_arena();
+  }
+
+  template <typename U>
+  bool
+  operator!=(const arena_allocator<U>& _other) const {
+    return _arena != _other.get_arena();
+  }
+
+private:
+  arena*   _arena;
+};
+
+/**
+   \brief A vector allocated in an arena
+ */
+template <typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+
+DEFAULT_NAMESPACE_END
+
+#endif
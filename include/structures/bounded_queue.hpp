@@ -0,0 +1,154 @@
+// bounded_queue.hpp
+// Lock free bounded queue
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+   \file structures/bounded_queue.hpp
+   Contains a lock free, fixed capacity, multi producer multi consumer
+   queue.
+ */
+
+#ifndef LBIO_BOUNDED_QUEUE_HPP
+#define LBIO_BOUNDED_QUEUE_HPP
+
+#include <lbio.h>
+
+#include <atomic>
+#include <vector>
+
+DEFAULT_NAMESPACE_BEGIN
+
+/**
+   \brief A lock free queue with fixed capacity that can be shared by
+   many producers and many consumers.
+
+   \tparam _ContentT  The type of the elements (should be cheap to
+   copy, typically a pointer)
+
+   The implementation follows the well known array based algorithm by
+   D. Vyukov: every cell carries a sequence number telling producers
+   and consumers whether the cell is free or filled for the current
+   <em>lap</em> of the ring, so that each operation requires a single
+   compare and swap on the shared position. The capacity is rounded up
+   to the next power of two. Operations never block, they report
+   whether they succeeded instead (callers decide how to wait).
+ */
+template <typename _ContentT>
+class bounded_queue
+{
+public:
+  typedef _ContentT      content_type;
+  typedef lbio_size_t    size_type;
+
+  explicit bounded_queue(size_type _cap)
+    : _cells(round_capacity(_cap)), _mask {round_capacity(_cap) - 1},
+      _enqueue_pos {0}, _dequeue_pos {0} {
+    for (size_type _i = 0; _i < _cells.size(); ++_i) {
+      _cells[_i]._seq.store(_i, std::memory_order_relaxed);
+    }
+  }
+
+  bounded_queue(const bounded_queue&) = delete;
+  bounded_queue& operator=(const bounded_queue&) = delete;
+
+  size_type
+  capacity() const { return _cells.size(); }
+
+  /**
+     \brief Inserts an element at the back of the queue
+
+     \return \c false if the queue is full
+   */
+  bool
+  try_push(const content_type& _value) {
+    size_type _pos = _enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+      cell& _c = _cells[_pos & _mask];
+      size_type _seq = _c._seq.load(std::memory_order_acquire);
+      intptr_t _diff = (intptr_t)_seq - (intptr_t)_pos;
+      if (_diff == 0) {
+	if (_enqueue_pos.compare_exchange_weak(_pos, _pos + 1,
+					       std::memory_order_relaxed)) {
+	  _c._data = _value;
+	  _c._seq.store(_pos + 1, std::memory_order_release);
+	  return true;
+	}
+      } else if (_diff < 0) {
+	return false;
+      } else {
+	_pos = _enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+     \brief Removes the element at the front of the queue
+
+     \return \c false if the queue is empty
+   */
+  bool
+  try_pop(content_type& _value) {
+    size_type _pos = _dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+      cell& _c = _cells[_pos & _mask];
+      size_type _seq = _c._seq.load(std::memory_order_acquire);
+      intptr_t _diff = (intptr_t)_seq - (intptr_t)(_pos + 1);
+      if (_diff == 0) {
+	if (_dequeue_pos.compare_exchange_weak(_pos, _pos + 1,
+					       std::memory_order_relaxed)) {
+	  _value = _c._data;
+	  _c._seq.store(_pos + _mask + 1, std::memory_order_release);
+	  return true;
+	}
+      } else if (_diff < 0) {
+	return false;
+      } else {
+	_pos = _dequeue_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+private:
+  struct cell
+  {
+    std::atomic<size_type> _seq;
+    content_type           _data;
+
+    cell() : _seq {0}, _data {} { }
+    // only needed to size the vector at construction
+    cell(const cell& other)
+      : _seq {other._seq.load()}, _data {other._data} { }
+  };
+
+  static size_type
+  round_capacity(size_type _cap) {
+    size_type _c = 2;
+    while (_c < _cap) {
+      _c <<= 1;
+    }
+    return _c;
+  }
+
+  std::vector<cell>             _cells;
+  const size_type               _mask;
+  // positions are kept on different cache lines to avoid false sharing
+  alignas(64) std::atomic<size_type> _enqueue_pos;
+  alignas(64) std::atomic<size_type> _dequeue_pos;
+};
+
+DEFAULT_NAMESPACE_END
+
+#endif
@@ -0,0 +1,304 @@
+// count_table.hpp
+// Open addressing hash table of counters
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+   \file structures/count_table.hpp
+   Contains a flat (open addressing) hash table counting occurrences of
+   keys, such as the k-mers of a sequence.
+ */
+
+#ifndef LBIO_COUNT_TABLE_HPP
+#define LBIO_COUNT_TABLE_HPP
+
+#include <lbio.h>
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <vector>
+
+DEFAULT_NAMESPACE_BEGIN
+
+/**
+   \brief A hash table mapping keys to (saturating) counters.
+
+   \tparam _KeyT    The type of the keys (e.g. numeric k-mers)
+   \tparam _HashT   The hash function of the keys
+   \tparam _CountT  The type of the counters, an unsigned integer
+
+   Collisions are resolved with linear probing, keys and counters are
+   kept in two flat arrays (keys are contiguous so that probing scans
+   consecutive memory and can be vectorized) and a slot is empty when
+   its counter is zero, so an entry takes exactly
+   <tt>sizeof(_KeyT) + sizeof(_CountT)</tt> bytes (12 bytes for 64 bits
+   k-mers and 32 bits counters) against the 40 or more bytes of a node
+   of \c std::unordered_map. Counters saturate at their maximum value
+   instead of wrapping around.
+
+   The home slot of a key is given by the most significant bits of its
+   (mixed) hash, so that when the table doubles the keys stored in a
+   range of slots move to the corresponding range of the new table.
+   The rehash exploits this: each thread moves one range of the old
+   table into its own range of the new one, only the few keys whose
+   probe sequence crosses the border of a range are inserted
+   afterwards by a single thread.
+
+   The table is not thread safe, concurrent counting must use one
+   table per thread (see merge()).
+ */
+template <typename _KeyT, typename _HashT = std::hash<_KeyT>,
+	  typename _CountT = uint32_t>
+class count_table
+{
+public:
+  typedef _KeyT          key_type;
+  typedef _CountT        count_type;
+  typedef _HashT         hasher;
+  typedef lbio_size_t    size_type;
+
+  /**
+     \brief Creates an empty table
+
+     \param _expected  The number of distinct keys expected (the table
+     grows anyway if more keys are added)
+     \param _threads   The number of threads used to rehash (0 means
+     one per core)
+   */
+  explicit count_table(size_type _expected = 0, size_type _threads = 0)
+    : _keys {}, _counts {}, _size {0}, _bits {0}, _threads {_threads} {
+    if (_threads == 0) {
+      this->_threads = std::thread::hardware_concurrency();
+    }
+    rehash(slots_for(_expected));
+  }
+
+  size_type
+  size() const { return _size; }
+
+  bool
+  empty() const { return _size == 0; }
+
+  size_type
+  capacity() const { return _counts.size(); }
+
+  double
+  load_factor() const { return (double)_size / capacity(); }
+
+  /**
+     \brief Returns the number of bytes used by the table
+   */
+  size_type
+  size_in_bytes() const {
+    return capacity() * (sizeof(key_type) + sizeof(count_type));
+  }
+
+  /**
+     \brief Adds \c _n occurrences of \c _key
+   */
+  void
+  add(const key_type& _key, count_type _n = 1) {
+    size_type _p = home(_key);
+    while (_counts[_p] != 0) {
+      if (_keys[_p] == _key) {
+	increment(_counts[_p], _n);
+	return;
+      }
+      _p = (_p + 1) & (capacity() - 1);
+    }
+    if (_n == 0) {
+      return;
+    }
+    if ((_size + 1) * 10 > capacity() * 7) {
+      // too full: the key is inserted in the larger table
+      rehash(2 * capacity());
+      place(_key, _n);
+    } else {
+      _keys[_p] = _key;
+      _counts[_p] = _n;
+    }
+    ++_size;
+  }
+
+  /**
+     \brief Returns the counter of \c _key (0 if the key is not in the
+     table)
+   */
+  count_type
+  count(const key_type& _key) const {
+    size_type _p = home(_key);
+    while (_counts[_p] != 0) {
+      if (_keys[_p] == _key) {
+	return _counts[_p];
+      }
+      _p = (_p + 1) & (capacity() - 1);
+    }
+    return 0;
+  }
+
+  /**
+     \brief Calls <tt>_f(key, count)</tt> for each key in the table (in
+     no particular order)
+   */
+  template <typename _FuncT>
+  void
+  for_each(_FuncT _f) const {
+    for (size_type _i = 0; _i < capacity(); ++_i) {
+      if (_counts[_i] != 0) {
+	_f(_keys[_i], _counts[_i]);
+      }
+    }
+  }
+
+  /**
+     \brief Adds all the counters of another table
+   */
+  void
+  merge(const count_table& _other) {
+    reserve(_size + _other.size());
+    _other.for_each([this](const key_type& _key, count_type _n) {
+	add(_key, _n);
+      });
+  }
+
+  /**
+     \brief Makes room for \c _n keys without further rehash
+   */
+  void
+  reserve(size_type _n) {
+    if (slots_for(_n) > capacity()) {
+      rehash(slots_for(_n));
+    }
+  }
+
+  void
+  clear() {
+    _keys.assign(capacity(), key_type());
+    _counts.assign(capacity(), 0);
+    _size = 0;
+  }
+
+private:
+  // rehash with more than one thread only for large tables
+  static const size_type parallel_slots = (size_type)1 << 20;
+
+  // smallest power of two keeping the load factor under 0.7
+  static size_type
+  slots_for(size_type _n) {
+    size_type _slots = 16;
+    while (_slots * 7 < _n * 10) {
+      _slots *= 2;
+    }
+    return _slots;
+  }
+
+  size_type
+  home(const key_type& _key) const {
+    // fibonacci hashing: the top bits of the product depend on all
+    // the bits of the hash
+    uint64_t _h = (uint64_t)hasher()(_key) * 0x9E3779B97F4A7C15ULL;
+    return (size_type)(_h >> (64 - _bits));
+  }
+
+  static void
+  increment(count_type& _c, count_type _n) {
+    const count_type _max = std::numeric_limits<count_type>::max();
+    _c = (_c > _max - _n) ? _max : _c + _n;
+  }
+
+  // inserts a key that is not in the table
+  void
+  place(const key_type& _key, count_type _n) {
+    size_type _p = home(_key);
+    while (_counts[_p] != 0) {
+      _p = (_p + 1) & (capacity() - 1);
+    }
+    _keys[_p] = _key;
+    _counts[_p] = _n;
+  }
+
+  void
+  rehash(size_type _slots) {
+    std::vector<key_type> _old_keys(_slots, key_type());
+    std::vector<count_type> _old_counts(_slots, 0);
+    _old_keys.swap(_keys);
+    _old_counts.swap(_counts);
+    _bits = 0;
+    while (((size_type)1 << _bits) < _slots) {
+      ++_bits;
+    }
+    size_type _old_slots = _old_counts.size();
+    size_type _T = (_old_slots >= parallel_slots && _threads > 1) ? _threads : 1;
+    if (_T == 1) {
+      for (size_type _i = 0; _i < _old_slots; ++_i) {
+	if (_old_counts[_i] != 0) {
+	  place(_old_keys[_i], _old_counts[_i]);
+	}
+      }
+      return;
+    }
+    // thread t moves the t-th range of the old table in the t-th range
+    // of the new table, keys that would leave the range are deferred
+    std::vector< std::vector<size_type> > _deferred(_T);
+    std::vector<std::thread> _workers;
+    for (size_type _t = 0; _t < _T; ++_t) {
+      _workers.push_back(std::thread([this, _t, _T, _slots, _old_slots, &_old_keys,
+				      &_old_counts, &_deferred]() {
+	    size_type _lo = _t * (_slots / _T);
+	    size_type _hi = (_t + 1 == _T) ? _slots : (_t + 1) * (_slots / _T);
+	    size_type _end = (_t + 1 == _T) ? _old_slots : (_t + 1) * (_old_slots / _T);
+	    for (size_type _i = _t * (_old_slots / _T); _i < _end; ++_i) {
+	      if (_old_counts[_i] == 0) {
+		continue;
+	      }
+	      size_type _p = home(_old_keys[_i]);
+	      if (_p < _lo || _p >= _hi) {
+		_deferred[_t].push_back(_i);
+		continue;
+	      }
+	      while (_p < _hi && _counts[_p] != 0) {
+		++_p;
+	      }
+	      if (_p == _hi) {
+		_deferred[_t].push_back(_i);
+		continue;
+	      }
+	      _keys[_p] = _old_keys[_i];
+	      _counts[_p] = _old_counts[_i];
+	    }
+	  }));
+    }
+    for (size_type _t = 0; _t < _T; ++_t) {
+      _workers[_t].join();
+    }
+    for (size_type _t = 0; _t < _T; ++_t) {
+      for (size_type _i : _deferred[_t]) {
+	place(_old_keys[_i], _old_counts[_i]);
+      }
+    }
+  }
+
+  std::vector<key_type>     _keys;
+  std::vector<count_type>   _counts;
+  size_type                 _size;
+  unsigned                  _bits;
+  size_type                 _threads;
+};
+
+DEFAULT_NAMESPACE_END
+
+#endif
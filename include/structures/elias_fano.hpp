@@ -0,0 +1,254 @@
+// elias_fano.hpp
+// Compressed monotone sequence of integers
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+   \file structures/elias_fano.hpp
+   Contains an Elias-Fano encoded sequence of non decreasing integers.
+ */
+
+#ifndef LBIO_ELIAS_FANO_HPP
+#define LBIO_ELIAS_FANO_HPP
+
+#include <lbio.h>
+
+#include <bitset>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+DEFAULT_NAMESPACE_BEGIN
+
+/**
+   \brief A non decreasing sequence of integers stored with the
+   Elias-Fano encoding.
+
+   Each value is split into its \f$ \ell \f$ low bits, stored verbatim
+   in a packed array, and its high part, stored in unary in a bit
+   vector (the i-th value sets the bit <tt>high + i</tt>). With
+   \f$ \ell = \lfloor \log_2 (u/n) \rfloor \f$, where \f$ u \f$ is the
+   largest value and \f$ n \f$ the number of values, the sequence takes
+   less than \f$ 2 + \ell \f$ bits per value; for instance the offsets
+   of \f$ n \f$ reads of 150 bases take about 10 bits per read.
+
+   Access is constant time: the position of one every 256 bits set in
+   the high bit vector is sampled and the bit vector is scanned (with
+   \c popcount) from the closest sample.
+
+   Values can only be appended, the encoding is recomputed (with the
+   best \f$ \ell \f$ for the current values) each time the size reaches
+   a power of two, or earlier if values grow much faster than expected,
+   so appending costs constant amortized time.
+ */
+class elias_fano
+{
+public:
+  typedef lbio_size_t    size_type;
+  typedef uint64_t       value_type;
+
+  elias_fano()
+    : _low {}, _high {}, _samples {}, _size {0}, _low_bits {0}, _last {0} { }
+
+  size_type
+  size() const { return _size; }
+
+  bool
+  empty() const { return _size == 0; }
+
+  /**
+     \brief Returns the last value (0 if the sequence is empty)
+   */
+  value_type
+  back() const { return _last; }
+
+  /**
+     \brief Appends a value, which must not be smaller than the last
+     one
+   */
+  void
+  push_back(value_type _value) {
+    if (_value < _last) {
+      throw std::domain_error("Elias-Fano values must be non decreasing");
+    }
+    if ((_value >> _low_bits) > 2 * _size + 64) {
+      // the high bit vector would become too sparse
+      std::vector<value_type> _values = values();
+      _values.push_back(_value);
+      reencode(_values);
+      return;
+    }
+    encode(_size, _value);
+    ++_size;
+    _last = _value;
+    if (_size >= 64 && (_size & (_size - 1)) == 0 && best_low_bits() != _low_bits) {
+      reencode(values());
+    }
+  }
+
+  /**
+     \brief Returns the i-th value
+   */
+  value_type
+  operator[](size_type _i) const {
+    value_type _high_part = select(_i) - _i;
+    return (_high_part << _low_bits) | get_low(_i);
+  }
+
+  void
+  clear() {
+    _low.clear();
+    _high.clear();
+    _samples.clear();
+    _size = 0;
+    _low_bits = 0;
+    _last = 0;
+  }
+
+  /**
+     \brief Returns the number of bytes used by the encoding
+   */
+  size_type
+  size_in_bytes() const {
+    return (_low.size() + _high.size() + _samples.size()) * sizeof(uint64_t);
+  }
+
+private:
+  static const size_type sample_rate = 256;
+
+  void
+  encode(size_type _i, value_type _value) {
+    size_type _pos = (_value >> _low_bits) + _i;
+    if (_pos / 64 >= _high.size()) {
+      _high.resize(_pos / 64 + 1, 0);
+    }
+    _high[_pos / 64] |= (uint64_t)1 << (_pos % 64);
+    if (_i % sample_rate == 0) {
+      _samples.push_back(_pos);
+    }
+    set_low(_i, _value);
+  }
+
+  // number of low bits minimizing the size, floor(log2(last/size))
+  unsigned
+  best_low_bits() const {
+    unsigned _bits = 0;
+    while (_bits < 63 && (_last / _size) >> (_bits + 1) > 0) {
+      ++_bits;
+    }
+    return _bits;
+  }
+
+  std::vector<value_type>
+  values() const {
+    std::vector<value_type> _values(_size);
+    for (size_type _i = 0; _i < _size; ++_i) {
+      _values[_i] = (*this)[_i];
+    }
+    return _values;
+  }
+
+  // encodes again all the values with the best number of low bits
+  void
+  reencode(const std::vector<value_type>& _values) {
+    clear();
+    _size = _values.size();
+    _last = _values.back();
+    _low_bits = best_low_bits();
+    for (size_type _i = 0; _i < _size; ++_i) {
+      encode(_i, _values[_i]);
+    }
+  }
+
+  void
+  set_low(size_type _i, value_type _value) {
+    if (_low_bits == 0) {
+      return;
+    }
+    size_type _bit = _i * _low_bits;
+    size_type _w = _bit / 64;
+    size_type _offset = _bit % 64;
+    if ((_bit + _low_bits + 63) / 64 > _low.size()) {
+      _low.resize((_bit + _low_bits + 63) / 64, 0);
+    }
+    _value &= ((uint64_t)1 << _low_bits) - 1;
+    _low[_w] |= _value << _offset;
+    if (_offset + _low_bits > 64) {
+      _low[_w + 1] |= _value >> (64 - _offset);
+    }
+  }
+
+  value_type
+  get_low(size_type _i) const {
+    if (_low_bits == 0) {
+      return 0;
+    }
+    size_type _bit = _i * _low_bits;
+    size_type _w = _bit / 64;
+    size_type _offset = _bit % 64;
+    value_type _value = _low[_w] >> _offset;
+    if (_offset + _low_bits > 64) {
+      _value |= _low[_w + 1] << (64 - _offset);
+    }
+    return _value & (((uint64_t)1 << _low_bits) - 1);
+  }
+
+  // position of the i-th bit set in the high bit vector
+  size_type
+  select(size_type _i) const {
+    size_type _start = _samples[_i / sample_rate];
+    size_type _rank = _i % sample_rate;
+    size_type _w = _start / 64;
+    uint64_t _word = _high[_w] & (~(uint64_t)0 << (_start % 64));
+    for (;;) {
+      size_type _count = std::bitset<64>(_word).count();
+      if (_rank < _count) {
+	break;
+      }
+      _rank -= _count;
+      _word = _high[++_w];
+    }
+    // drop the lowest bits set before the one we look for
+    for (; _rank > 0; --_rank) {
+      _word &= _word - 1;
+    }
+    return _w * 64 + lowest_bit(_word);
+  }
+
+  static size_type
+  lowest_bit(uint64_t _word) {
+#ifdef __GNUC__
+    return __builtin_ctzll(_word);
+#else
+    size_type _i = 0;
+    while (!(_word & 1)) {
+      _word >>= 1;
+      ++_i;
+    }
+    return _i;
+#endif
+  }
+
+  std::vector<uint64_t>  _low;
+  std::vector<uint64_t>  _high;
+  std::vector<uint64_t>  _samples;
+  size_type              _size;
+  unsigned               _low_bits;
+  value_type             _last;
+};
+
+DEFAULT_NAMESPACE_END
+
+#endif
@@ -0,0 +1,105 @@
+// char_span.hpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LBIO_CHAR_SPAN_HPP
+#define LBIO_CHAR_SPAN_HPP
+
+#include <lbio.h>
+
+#include <cstring>
+#include <ostream>
+#include <string>
+
+DEFAULT_NAMESPACE_BEGIN
+
+/**
+   \brief A non owning, read only view over a contiguous range of
+   characters (in the spirit of C++17 \c std::string_view).
+
+   The span never copies nor frees the characters it refers to, the
+   caller must guarantee that the underlying memory remains valid for
+   as long as the span is used.
+ */
+struct char_span
+{
+  typedef const char*    const_iterator;
+  typedef lbio_size_t    size_type;
+
+  const char* _data;
+  size_type   _size;
+
+  char_span()
+    : _data {nullptr}, _size {0} { }
+
+  char_span(const char* _d, size_type _n)
+    : _data {_d}, _size {_n} { }
+
+  char_span(const std::string& _s)
+    : _data {_s.data()}, _size {_s.size()} { }
+
+  const char*
+  data() const { return _data; }
+
+  size_type
+  size() const { return _size; }
+
+  bool
+  empty() const { return _size == 0; }
+
+  const_iterator
+  begin() const { return _data; }
+
+  const_iterator
+  end() const { return _data + _size; }
+
+  char
+  operator[](size_type _i) const { return _data[_i]; }
+
+  /**
+     \brief Returns the sub-span starting at \c _pos of (at most) \c _n
+     characters
+   */
+  char_span
+  substr(size_type _pos, size_type _n) const {
+    _pos = (_pos < _size) ? _pos : _size;
+    _n = (_n < _size - _pos) ? _n : _size - _pos;
+    return char_span(_data + _pos, _n);
+  }
+
+  /**
+     \brief Returns an owning copy of the characters in the span
+   */
+  std::string
+  str() const { return std::string(_data, _size); }
+
+  bool
+  operator==(const char_span& other) const {
+    return (_size == other._size) &&
+      (_size == 0 || std::memcmp(_data, other._data, _size) == 0);
+  }
+
+  bool
+  operator!=(const char_span& other) const { return !(*this == other); }
+};
+
+inline std::ostream&
+operator<<(std::ostream& os, const char_span& span) {
+  return os.write(span.data(), span.size());
+}
+
+DEFAULT_NAMESPACE_END
+
+#endif
@@ -0,0 +1,123 @@
+// file_format.hpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LBIO_FILE_FORMAT_HPP
+#define LBIO_FILE_FORMAT_HPP
+
+#include <lbio.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+DEFAULT_NAMESPACE_BEGIN
+
+/**
+   \brief The value stored (in the byte order of the writing machine) by
+   every binary file of the library, see file_preamble
+ */
+const uint32_t file_byte_order_mark = 0x01020304;
+
+/**
+   \brief The alignment (in bytes) of the arrays of the binary files of
+   the library
+ */
+const uint64_t file_page_size = 4096;
+
+/**
+   \brief First fields of the header of the binary files of the library
+   that are used in place through a mapped_file.
+
+   The magic string identifies the kind of file and the version the
+   layout of its header. Values are stored in the byte order of the
+   writing machine, which is recorded by storing file_byte_order_mark:
+   files written with a different byte order are rejected rather than
+   converted. The arrays that follow the header start at page aligned
+   offsets (see page_align()) so that they can be mapped and accessed in
+   place.
+ */
+struct file_preamble
+{
+  /**
+     \brief Eight characters (not null terminated)
+   */
+  char     magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+
+  /**
+     \brief Fills the preamble of a file to be written
+   */
+  void
+  set(const char* _magic, uint32_t _version) {
+    memcpy(magic, _magic, sizeof(magic));
+    version = _version;
+    byte_order = file_byte_order_mark;
+  }
+
+  bool
+  has_magic(const char* _magic) const {
+    return memcmp(magic, _magic, sizeof(magic)) == 0;
+  }
+
+  /**
+     \brief Checks the magic string, the version and the byte order of a
+     file that has been read
+   */
+  bool
+  matches(const char* _magic, uint32_t _version) const {
+    return has_magic(_magic) && version == _version &&
+      byte_order == file_byte_order_mark;
+  }
+};
+
+/**
+   \brief Rounds an offset up to a multiple of file_page_size
+ */
+inline uint64_t
+page_align(uint64_t _offset) {
+  return ((_offset + file_page_size - 1) / file_page_size) * file_page_size;
+}
+
+/**
+   \brief Checks that \c _count elements of \c _element bytes starting at
+   \c _offset are within a file of \c _size bytes (with no overflow
+   whatever the values read from a header)
+ */
+inline bool
+array_fits(uint64_t _offset, uint64_t _count, uint64_t _element, uint64_t _size) {
+  return _offset <= _size && _count <= (_size - _offset) / _element;
+}
+
+/**
+   \brief Writes the zeros that move a stream from offset \c _from to the
+   (larger) offset \c _to
+ */
+inline void
+write_padding(std::ostream& _os, uint64_t _from, uint64_t _to) {
+  static const std::vector< char > zeros(file_page_size, 0);
+  while (_from < _to) {
+    uint64_t n = std::min(_to - _from, (uint64_t)zeros.size());
+    _os.write(zeros.data(), n);
+    _from += n;
+  }
+}
+
+DEFAULT_NAMESPACE_END
+
+#endif
@@ -0,0 +1,172 @@
+// mapped_file.hpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LBIO_MAPPED_FILE_HPP
+#define LBIO_MAPPED_FILE_HPP
+
+#include <lbio.h>
+
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+DEFAULT_NAMESPACE_BEGIN
+
+/**
+   \brief Read only, memory mapped view of a whole file.
+
+   The file is mapped with \c mmap so that its content can be accessed
+   as a contiguous array of bytes without copying it into user space
+   buffers; pages are loaded lazily by the kernel and are shared (via
+   the page cache) among all processes mapping the same file.
+
+   The class owns the mapping (it is moveable but not copyable) and
+   releases it when destroyed. Empty files are accepted: they are
+   reported as open with a \c nullptr data and zero size.
+ */
+class mapped_file
+{
+public:
+  typedef lbio_size_t size_type;
+
+  /**
+     \brief Access pattern hint passed to the kernel (\c madvise)
+   */
+  enum access_hint { normal, sequential, random };
+
+  mapped_file()
+    : _data {nullptr}, _size {0}, _open {false} { }
+
+  explicit mapped_file(const std::string& _path, access_hint _hint = normal)
+    : _data {nullptr}, _size {0}, _open {false} {
+    open(_path, _hint);
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  mapped_file(mapped_file&& other)
+    : _data {other._data}, _size {other._size}, _open {other._open} {
+    other._data = nullptr;
+    other._size = 0;
+    other._open = false;
+  }
+
+  mapped_file&
+  operator=(mapped_file&& other) {
+    if (this != &other) {
+      close();
+      _data = other._data;
+      _size = other._size;
+      _open = other._open;
+      other._data = nullptr;
+      other._size = 0;
+      other._open = false;
+    }
+    return *this;
+  }
+
+  ~mapped_file() {
+    close();
+  }
+
+  /**
+     \brief Maps the file at \c _path, any previous mapping is released.
+
+     \return \c true if the file could be opened and mapped
+   */
+  bool
+  open(const std::string& _path, access_hint _hint = normal) {
+    close();
+    int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      return false;
+    }
+    _size = static_cast<size_type>(st.st_size);
+    if (_size > 0) {
+      void* addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+	::close(fd);
+	_size = 0;
+	return false;
+      }
+      _data = static_cast<const char*>(addr);
+      advise(_hint);
+    }
+    // the mapping remains valid after the descriptor is closed
+    ::close(fd);
+    _open = true;
+    return true;
+  }
+
+  /**
+     \brief Unmaps the file (if mapped)
+   */
+  void
+  close() {
+    if (_data != nullptr) {
+      munmap(const_cast<char*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+  }
+
+  /**
+     \brief Changes the access pattern hint for the whole mapping
+   */
+  void
+  advise(access_hint _hint) const {
+    if (_data == nullptr) {
+      return;
+    }
+    int adv = (_hint == sequential) ? MADV_SEQUENTIAL :
+      ((_hint == random) ? MADV_RANDOM : MADV_NORMAL);
+    madvise(const_cast<char*>(_data), _size, adv);
+  }
+
+  bool
+  is_open() const { return _open; }
+
+  const char*
+  data() const { return _data; }
+
+  size_type
+  size() const { return _size; }
+
+  const char*
+  begin() const { return _data; }
+
+  const char*
+  end() const { return _data + _size; }
+
+private:
+  const char* _data;
+  size_type   _size;
+  bool        _open;
+};
+
+DEFAULT_NAMESPACE_END
+
+#endif
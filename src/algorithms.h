@@ -9,7 +9,10 @@
 #include "algorithms/ScoredPosition.hpp"
 #include "algorithms/aligndef.hpp"
 
+#include "algorithms/KmerPositionIndex.hpp"
 #include "algorithms/spectrum.hpp"
+#include "algorithms/KmerCounter.hpp"
+#include "algorithms/ExternalKmerCounter.hpp"
 #include "algorithms/dstats.hpp"
 
 #include "algorithms/kmerscore.hpp"
@@ -0,0 +1,399 @@
+#include "ExternalKmerCounter.hpp"
+
+#include <core/KMerIterator.hpp>
+
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+/******************** SUPPORT FUNCTIONS *********************/
+
+static const char SpectrumMagic[] = "LBIOKSPC";
+// smallest buffer (in k-mers) of a partition during the first pass
+static const size_t MinBufferSize = 4096;
+// one partition for every 64MB of budget
+static const size_t PartitionMemory = (size_t)64 << 20;
+
+// One entry of a sorted run of a partition larger than the budget
+struct SpectrumRunEntry {
+  uint64_t kmer;
+  uint64_t count;
+};
+
+// Writes the sorted k-mers and their counters of a spectrum file, the
+// counters are kept in a separate file and appended by finish()
+class SpectrumWriter {
+ private:
+  ofstream& keys;
+  ofstream& counts;
+  uint64_t written;
+
+ public:
+  SpectrumWriter(ofstream& keys, ofstream& counts)
+    : keys(keys), counts(counts), written(0)
+  {
+  }
+
+  void emit(uint64_t kmer, uint64_t count) {
+    uint32_t c = (uint32_t)min(count, (uint64_t)numeric_limits<uint32_t>::max());
+    this->keys.write((const char*)&kmer, sizeof(kmer));
+    this->counts.write((const char*)&c, sizeof(c));
+    this->written++;
+  }
+
+  uint64_t getWritten() const {
+    return this->written;
+  }
+};
+
+// Sorts a chunk of k-mers and calls f(kmer, count) for each distinct one
+template<class F>
+static void countSorted(vector< uint64_t >& chunk, F f) {
+  sort(chunk.begin(), chunk.end());
+  size_t i = 0;
+  while (i < chunk.size()) {
+    size_t j = i + 1;
+    while (j < chunk.size() && chunk[j] == chunk[i]) {
+      ++j;
+    }
+    f(chunk[i], (uint64_t)(j - i));
+    i = j;
+  }
+}
+
+static bool readChunk(ifstream& in, vector< uint64_t >& chunk, size_t n) {
+  chunk.resize(n);
+  in.read((char*)chunk.data(), n * sizeof(uint64_t));
+  return (size_t)in.gcount() == n * sizeof(uint64_t);
+}
+
+/**************** CONSTRUCTORS AND DESTRUCTOR ***************/
+
+ExternalKmerCounter::ExternalKmerCounter(size_t k, const string& workDir, size_t memory,
+					 size_t partitions)
+  : k(k), workDir(workDir), memory(memory), partitionBits(0), bufferSize(0),
+    buffers(), spills(), spilled(), tempFiles(), totalCount(0), failed(false)
+{
+  if (k == 0 || k > 32) {
+    throw domain_error("k-mer length must be in [1, 32]");
+  }
+  if (!this->workDir.empty() && this->workDir[this->workDir.size() - 1] != '/') {
+    this->workDir += '/';
+  }
+  size_t P = (partitions == 0) ? max((size_t)16, memory / PartitionMemory) : partitions;
+  // partitions are given by (at most 8 of) the first bases of a k-mer
+  while (((size_t)1 << this->partitionBits) < P && this->partitionBits < min(2 * k, (size_t)16)) {
+    this->partitionBits++;
+  }
+  P = getPartitionCount();
+  this->bufferSize = max(MinBufferSize, memory / (P * sizeof(uint64_t)));
+  this->buffers.resize(P);
+  this->spills.assign(P, (ofstream*)NULL);
+  this->spilled.assign(P, 0);
+}
+
+ExternalKmerCounter::~ExternalKmerCounter() {
+  removeTempFiles();
+}
+
+/*********************** COUNT METHODS **********************/
+
+bool ExternalKmerCounter::add(const Sequence& sequence) {
+  forEachKMer(sequence, this->k, [this](uint64_t kmer, size_t) {
+      push(kmer);
+    });
+  return !this->failed;
+}
+
+bool ExternalKmerCounter::add(const char* bases, size_t length) {
+  KMerIterator<const char*> it(bases, length, this->k);
+  while (it.next()) {
+    push(it.getForward());
+  }
+  return !this->failed;
+}
+
+bool ExternalKmerCounter::writeSpectrum(const string& filePath) {
+  // end of the first pass: the buffers are released before counting
+  for (size_t p = 0; p < this->buffers.size(); ++p) {
+    spill(p);
+    vector< uint64_t >().swap(this->buffers[p]);
+    if (this->spills[p] != NULL) {
+      this->spills[p]->close();
+      delete this->spills[p];
+      this->spills[p] = NULL;
+    }
+  }
+  ofstream out(filePath, ofstream::binary | ofstream::out);
+  string countsPath = tempFileName("counts");
+  ofstream countsOut(countsPath, ofstream::binary | ofstream::out);
+  if (!out || !countsOut) {
+    cerr << "[ERROR] - Unable to write " << filePath << endl;
+    this->failed = true;
+  }
+  KmerSpectrumHeader header;
+  memset(&header, 0, sizeof(header));
+  header.preamble.set(SpectrumMagic, ExternalKmerCounter::FormatVersion);
+  header.k = this->k;
+  header.totalCount = this->totalCount;
+  // the header is written last, its page is filled with zeros
+  header.keysOffset = lbio::page_align(sizeof(header));
+  lbio::write_padding(out, 0, header.keysOffset);
+
+  SpectrumWriter writer(out, countsOut);
+  const size_t chunkSize = max(MinBufferSize, this->memory / sizeof(uint64_t));
+  vector< uint64_t > chunk;
+  // second pass: partitions are ranges, they are counted in order
+  for (size_t p = 0; p < this->spilled.size() && !this->failed; ++p) {
+    uint64_t n = this->spilled[p];
+    if (n == 0) {
+      continue;
+    }
+    ifstream in(tempFileName("part" + to_string(p)), ifstream::binary | ifstream::in);
+    if (n <= chunkSize) {
+      if (!readChunk(in, chunk, n)) {
+	this->failed = true;
+	break;
+      }
+      countSorted(chunk, [&writer](uint64_t kmer, uint64_t c) {
+	  writer.emit(kmer, c);
+	});
+      continue;
+    }
+    // the partition does not fit in memory: sorted runs are merged
+    vector< ifstream* > runs;
+    for (uint64_t done = 0; done < n && !this->failed; done += chunkSize) {
+      if (!readChunk(in, chunk, min((uint64_t)chunkSize, n - done))) {
+	this->failed = true;
+	break;
+      }
+      string runPath = tempFileName("run" + to_string(p) + "_" + to_string(runs.size()));
+      ofstream run(runPath, ofstream::binary | ofstream::out);
+      countSorted(chunk, [&run](uint64_t kmer, uint64_t c) {
+	  SpectrumRunEntry e = { kmer, c };
+	  run.write((const char*)&e, sizeof(e));
+	});
+      run.close();
+      this->failed = this->failed || !run;
+      runs.push_back(new ifstream(runPath, ifstream::binary | ifstream::in));
+    }
+    vector< uint64_t >().swap(chunk);
+    typedef pair< SpectrumRunEntry, size_t > Head;
+    auto greater = [](const Head& a, const Head& b) {
+      return a.first.kmer > b.first.kmer;
+    };
+    priority_queue< Head, vector< Head >, decltype(greater) > heads(greater);
+    for (size_t r = 0; r < runs.size(); ++r) {
+      SpectrumRunEntry e;
+      if (runs[r]->read((char*)&e, sizeof(e))) {
+	heads.push(make_pair(e, r));
+      }
+    }
+    while (!heads.empty()) {
+      Head h = heads.top();
+      heads.pop();
+      SpectrumRunEntry e;
+      if (runs[h.second]->read((char*)&e, sizeof(e))) {
+	heads.push(make_pair(e, h.second));
+      }
+      // equal k-mers of different runs are summed
+      while (!heads.empty() && heads.top().first.kmer == h.first.kmer) {
+	Head g = heads.top();
+	heads.pop();
+	h.first.count += g.first.count;
+	if (runs[g.second]->read((char*)&e, sizeof(e))) {
+	  heads.push(make_pair(e, g.second));
+	}
+      }
+      writer.emit(h.first.kmer, h.first.count);
+    }
+    for (size_t r = 0; r < runs.size(); ++r) {
+      delete runs[r];
+    }
+  }
+  vector< uint64_t >().swap(chunk);
+
+  // the counters follow the k-mers
+  countsOut.close();
+  header.kmerCount = writer.getWritten();
+  header.countsOffset = header.keysOffset + header.kmerCount * sizeof(uint64_t);
+  if (header.kmerCount > 0) {
+    ifstream countsIn(countsPath, ifstream::binary | ifstream::in);
+    out << countsIn.rdbuf();
+  }
+  out.seekp(0);
+  out.write((const char*)&header, sizeof(header));
+  out.close();
+  bool ok = !this->failed && out;
+  if (!ok) {
+    cerr << "[ERROR] - Unable to write the spectrum " << filePath << endl;
+  }
+  // the counter is ready for new k-mers
+  removeTempFiles();
+  this->spilled.assign(this->spilled.size(), 0);
+  this->totalCount = 0;
+  this->failed = false;
+  return ok;
+}
+
+/*********************** QUERY METHODS **********************/
+
+size_t ExternalKmerCounter::getK() const {
+  return this->k;
+}
+
+size_t ExternalKmerCounter::getMemory() const {
+  return this->memory;
+}
+
+size_t ExternalKmerCounter::getPartitionCount() const {
+  return (size_t)1 << this->partitionBits;
+}
+
+uint64_t ExternalKmerCounter::getTotalCount() const {
+  return this->totalCount;
+}
+
+/********************** UTILITY METHODS *********************/
+
+void ExternalKmerCounter::push(uint64_t kmer) {
+  size_t p = (this->partitionBits == 0) ? 0 : (size_t)(kmer >> (2 * this->k - this->partitionBits));
+  vector< uint64_t >& buffer = this->buffers[p];
+  if (buffer.capacity() == 0) {
+    buffer.reserve(this->bufferSize);
+  }
+  buffer.push_back(kmer);
+  this->totalCount++;
+  if (buffer.size() >= this->bufferSize) {
+    spill(p);
+  }
+}
+
+bool ExternalKmerCounter::spill(size_t p) {
+  vector< uint64_t >& buffer = this->buffers[p];
+  if (buffer.empty()) {
+    return true;
+  }
+  if (this->spills[p] == NULL) {
+    this->spills[p] = new ofstream(tempFileName("part" + to_string(p)),
+				   ofstream::binary | ofstream::out);
+  }
+  this->spills[p]->write((const char*)buffer.data(), buffer.size() * sizeof(uint64_t));
+  if (!*(this->spills[p]) && !this->failed) {
+    cerr << "[ERROR] - Unable to write temporary files in " << this->workDir << endl;
+    this->failed = true;
+  }
+  this->spilled[p] += buffer.size();
+  buffer.clear();
+  return !this->failed;
+}
+
+string ExternalKmerCounter::tempFileName(const string& name) {
+  // files of different counters (and processes) do not clash
+  string path = this->workDir + "lbio_kmers_" + to_string(getpid()) + "_" +
+    to_string((uintptr_t)this) + "_" + name + ".tmp";
+  if (find(this->tempFiles.begin(), this->tempFiles.end(), path) == this->tempFiles.end()) {
+    this->tempFiles.push_back(path);
+  }
+  return path;
+}
+
+void ExternalKmerCounter::removeTempFiles() {
+  for (size_t p = 0; p < this->spills.size(); ++p) {
+    delete this->spills[p];
+    this->spills[p] = NULL;
+  }
+  for (size_t i = 0; i < this->tempFiles.size(); ++i) {
+    std::remove(this->tempFiles[i].c_str());
+  }
+  this->tempFiles.clear();
+}
+
+/********************* SPECTRUM FILE ************************/
+
+KmerSpectrumFile::KmerSpectrumFile()
+  : file(), keys(NULL), counts(NULL)
+{
+  memset(&this->header, 0, sizeof(this->header));
+}
+
+KmerSpectrumFile::KmerSpectrumFile(const string& filePath)
+  : KmerSpectrumFile()
+{
+  open(filePath);
+}
+
+bool KmerSpectrumFile::open(const string& filePath) {
+  close();
+  lbio::mapped_file f;
+  if (!f.open(filePath, lbio::mapped_file::random)) {
+    cerr << "[ERROR] - Unable to map " << filePath << endl;
+    return false;
+  }
+  KmerSpectrumHeader h;
+  if (f.size() < sizeof(h)) {
+    cerr << "[ERROR] - " << filePath << " is not a spectrum file" << endl;
+    return false;
+  }
+  memcpy(&h, f.data(), sizeof(h));
+  if (!h.preamble.matches(SpectrumMagic, ExternalKmerCounter::FormatVersion) ||
+      h.keysOffset % sizeof(uint64_t) != 0 ||
+      h.countsOffset != h.keysOffset + h.kmerCount * sizeof(uint64_t) ||
+      h.countsOffset + h.kmerCount * sizeof(uint32_t) > f.size()) {
+    cerr << "[ERROR] - " << filePath << " is not a valid spectrum file" << endl;
+    return false;
+  }
+  this->header = h;
+  this->keys = (const uint64_t*)(f.data() + h.keysOffset);
+  this->counts = (const uint32_t*)(f.data() + h.countsOffset);
+  this->file = std::move(f);
+  return true;
+}
+
+void KmerSpectrumFile::close() {
+  this->file.close();
+  memset(&this->header, 0, sizeof(this->header));
+  this->keys = NULL;
+  this->counts = NULL;
+}
+
+bool KmerSpectrumFile::isOpen() const {
+  return this->file.is_open();
+}
+
+size_t KmerSpectrumFile::getK() const {
+  return this->header.k;
+}
+
+uint64_t KmerSpectrumFile::size() const {
+  return this->header.kmerCount;
+}
+
+uint64_t KmerSpectrumFile::getTotalCount() const {
+  return this->header.totalCount;
+}
+
+uint64_t KmerSpectrumFile::getKmer(uint64_t i) const {
+  return this->keys[i];
+}
+
+uint32_t KmerSpectrumFile::getCount(uint64_t i) const {
+  return this->counts[i];
+}
+
+uint32_t KmerSpectrumFile::count(uint64_t kmer) const {
+  const uint64_t* end = this->keys + size();
+  const uint64_t* it = std::lower_bound(this->keys, end, kmer);
+  return (it != end && *it == kmer) ? this->counts[it - this->keys] : 0;
+}
+
+/************************************************************/
@@ -0,0 +1,224 @@
+#ifndef EXTERNAL_KMER_COUNTER_H
+#define EXTERNAL_KMER_COUNTER_H
+
+#include <core/Sequence.h>
+
+#include <util/file_format.hpp>
+#include <util/mapped_file.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Header of a binary spectrum file.
+ *
+ * The header is followed (at the page aligned offset \c keysOffset)
+ * by the \c kmerCount numeric k-mers (\c uint64_t, in increasing
+ * order) and then (at \c countsOffset) by their counters
+ * (\c uint32_t, in the same order), so that the file can be mapped
+ * and searched in place.
+ *
+ * \sa ExternalKmerCounter::writeSpectrum()
+ * \sa KmerSpectrumFile
+ */
+struct KmerSpectrumHeader {
+  /**
+   * \brief Magic string \c LBIOKSPC, version and byte order
+   */
+  lbio::file_preamble preamble;
+  uint64_t k;
+  /**
+   * \brief The number of distinct k-mers
+   */
+  uint64_t kmerCount;
+  /**
+   * \brief The number of k-mers counted (the sum of all the counters
+   * before saturation)
+   */
+  uint64_t totalCount;
+  uint64_t keysOffset;
+  uint64_t countsOffset;
+};
+
+/**
+ * \brief Counts k-mers of inputs that do not fit in memory.
+ *
+ * Counting is performed in two passes:
+ * -# k-mers are streamed (with add()) into one buffer for each
+ * partition, partitions are ranges of numeric k-mers (the partition
+ * is given by the first bases of the k-mer), full buffers are
+ * appended to one file per partition in the working directory;
+ * -# writeSpectrum() loads one partition at a time, sorts and counts
+ * its k-mers, and appends them to the spectrum file; since partitions
+ * are ranges the output is sorted without merging partitions.
+ *
+ * Memory never exceeds (about) the given budget: the buffers of the
+ * first pass share the budget and, during the second pass, partitions
+ * larger than the budget are counted in sorted runs (written to the
+ * working directory) that are then merged.
+ *
+ * Numeric k-mers are the forward codes of KMerIterator (\f$ k \leq 32 \f$),
+ * k-mers containing bases other than \c A, \c C, \c G and \c T are
+ * skipped.
+ *
+ * \code
+ * ExternalKmerCounter counter(31, "/tmp/", 4UL << 30);
+ * while (...) {
+ *   counter.add(read);
+ * }
+ * counter.writeSpectrum("reads.ksp");
+ * KmerSpectrumFile spectrum("reads.ksp");
+ * \endcode
+ *
+ * \sa KmerSpectrumFile
+ */
+class ExternalKmerCounter {
+ public:
+  static const uint32_t FormatVersion = 1;
+  static const size_t DefaultMemory = (size_t)1 << 30;
+
+ private:
+  size_t k;
+  std::string workDir;
+  size_t memory;
+  size_t partitionBits;
+  size_t bufferSize;
+  std::vector< std::vector< uint64_t > > buffers;
+  std::vector< std::ofstream* > spills;
+  std::vector< uint64_t > spilled;
+  std::vector< std::string > tempFiles;
+  uint64_t totalCount;
+  bool failed;
+
+ public:
+  // ---------------------------------------------------------
+  //                CONSTRUCTORS AND DESTRUCTOR
+  // ---------------------------------------------------------
+  /**
+   * \brief Creates an empty counter
+   *
+   * \param k The length of the k-mers (at most 32)
+   * \param workDir The directory of the temporary files
+   * \param memory The memory budget in bytes
+   * \param partitions The number of partitions, rounded to a power of
+   * two (0 chooses one partition for every 64MB of budget, at least
+   * 16)
+   * \throw std::domain_error if \c k is not in [1, 32]
+   */
+  ExternalKmerCounter(size_t k, const std::string& workDir,
+		      size_t memory = DefaultMemory, size_t partitions = 0);
+  /**
+   * \brief Removes the temporary files (if any)
+   */
+  ~ExternalKmerCounter();
+
+  // ---------------------------------------------------------
+  //                      COUNT METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Adds the k-mers of a sequence
+   *
+   * \return \c false if a temporary file could not be written
+   */
+  bool add(const Sequence& sequence);
+  /**
+   * \brief Adds the k-mers of \c length characters
+   */
+  bool add(const char* bases, size_t length);
+  /**
+   * \brief Counts all the k-mers added so far and writes the spectrum
+   * file (see KmerSpectrumHeader), the counter is left empty
+   *
+   * \param filePath The path of the output file
+   * \return \c true if the spectrum has been written
+   */
+  bool writeSpectrum(const std::string& filePath);
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  size_t getK() const;
+  size_t getMemory() const;
+  size_t getPartitionCount() const;
+  /**
+   * \brief Returns the number of k-mers added since the last
+   * writeSpectrum()
+   */
+  uint64_t getTotalCount() const;
+
+ private:
+  // ---------------------------------------------------------
+  //                     UTILITY METHODS
+  // ---------------------------------------------------------
+  void push(uint64_t kmer);
+  bool spill(size_t p);
+  std::string tempFileName(const std::string& name);
+  void removeTempFiles();
+};
+
+/**
+ * \brief Read only, memory mapped spectrum file.
+ *
+ * Counters are searched (binary search) directly in the mapping, the
+ * spectrum is never loaded in memory.
+ *
+ * \sa ExternalKmerCounter
+ */
+class KmerSpectrumFile {
+ private:
+  lbio::mapped_file file;
+  KmerSpectrumHeader header;
+  const uint64_t* keys;
+  const uint32_t* counts;
+
+ public:
+  KmerSpectrumFile();
+  /**
+   * \brief Maps a spectrum file
+   *
+   * \sa open()
+   */
+  explicit KmerSpectrumFile(const std::string& filePath);
+
+  /**
+   * \brief Maps a spectrum file written by
+   * ExternalKmerCounter::writeSpectrum()
+   *
+   * \return \c false if the file cannot be mapped or is not a valid
+   * spectrum file
+   */
+  bool open(const std::string& filePath);
+  void close();
+  bool isOpen() const;
+
+  size_t getK() const;
+  /**
+   * \brief Returns the number of distinct k-mers
+   */
+  uint64_t size() const;
+  uint64_t getTotalCount() const;
+  /**
+   * \brief Returns the i-th k-mer (in increasing order)
+   */
+  uint64_t getKmer(uint64_t i) const;
+  uint32_t getCount(uint64_t i) const;
+  /**
+   * \brief Returns the counter of a k-mer (0 if the k-mer is not in
+   * the spectrum)
+   */
+  uint32_t count(uint64_t kmer) const;
+  /**
+   * \brief Calls <tt>f(kmer, count)</tt> for each k-mer (in
+   * increasing order)
+   */
+  template<class F>
+  void forEach(F f) const {
+    for (uint64_t i = 0; i < size(); ++i) {
+      f(this->keys[i], this->counts[i]);
+    }
+  }
+};
+
+#endif
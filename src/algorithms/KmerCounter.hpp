@@ -0,0 +1,303 @@
+#ifndef KMER_COUNTER_H
+#define KMER_COUNTER_H
+
+#include <core/KMerIterator.hpp>
+#include <core/NumericKMer.hpp>
+#include <core/Sequence.h>
+
+#include <structures/count_table.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+   \brief Multi threaded k-mer counter.
+
+   K-mers are partitioned by their hash into \f$ P \f$ partitions (as the
+   sub-maps of HybridIndex, whose key is taken modulo a constant), each
+   partition is a KmerCountTable. Counting proceeds in rounds made of two
+   parallel phases, with no lock nor atomic operation:
+   -# the input is cut into slices (pieces of long sequences, overlapping by
+   \f$ k - 1 \f$ bases, or whole short sequences such as reads) and each
+   thread scans its slices, appending each k-mer to its own buffer for the
+   partition of the k-mer;
+   -# each thread counts the buffers of the partitions it owns (partition
+   \f$ p \f$ belongs to thread \f$ p \bmod T \f$), so each table is only
+   modified by one thread.
+
+   A round ends once the slices hold 4 slices per thread worth of bases, so
+   the buffers of a thread hold about \f$ 4S \f$ k-mers of \f$ 8W \f$ bytes
+   each, where \f$ S \f$ is the slice length (with the default \f$ S = 2^{20}
+   \f$ and \f$ W = 1 \f$ this is 32MB per thread); buffers are reused by the
+   next round. Once counted, the partitions
+   form one spectrum that can be queried with getCount() or forEach(), or
+   merged into a single table with merge().
+
+   \code
+   PartitionedKmerCounter<> counter(21, 8);
+   counter.count(reference);
+   counter.count(reads);
+   uint32_t c = counter.getCount(code);
+   \endcode
+
+   \tparam W The number of words of the k-mer codes (see seq::KMerWord)
+ */
+template<size_t W = 1>
+class PartitionedKmerCounter {
+public:
+  typedef typename seq::KMerWord<W>::type CodeType;
+  // same type as KmerCountTable<W> (see spectrum.hpp)
+  typedef lbio::count_table< CodeType, seq::KMerHash<W> > TableType;
+  typedef typename TableType::count_type CountType;
+
+  static const size_t DefaultSliceBases = (size_t)1 << 20;
+
+private:
+  struct Slice {
+    const Sequence* sequence;
+    size_t begin;
+    size_t length;
+  };
+
+  size_t k;
+  size_t threads;
+  size_t partitions;
+  std::vector< TableType > tables;
+  // buffer of thread t for partition p is buckets[t * partitions + p]
+  std::vector< std::vector< CodeType > > buckets;
+  std::vector< Slice > slices;
+  size_t sliceBases;
+  size_t pendingBases;
+
+public:
+  /**
+     \brief Creates an empty counter
+
+     \param k The length of the k-mers (at most \f$ 32W \f$)
+     \param threads The number of threads (0 means one per core)
+     \param partitions The number of partitions, rounded to a power of two
+     (0 chooses 8 partitions per thread)
+     \param sliceBases The length of the slices of long sequences, it
+     bounds the memory of the buffers (0 chooses DefaultSliceBases)
+   */
+  PartitionedKmerCounter(size_t k, size_t threads = 0, size_t partitions = 0,
+			 size_t sliceBases = 0);
+
+  /**
+     \brief Counts the k-mers of a (long) sequence
+   */
+  void count(const Sequence& sequence);
+  /**
+     \brief Counts the k-mers of a set of sequences (e.g. reads), \c S must
+     be a Sequence type
+   */
+  template<class S>
+  void count(const std::vector<S>& sequences);
+
+  /**
+     \brief Returns the number of occurrences of a k-mer
+   */
+  CountType getCount(const CodeType& kmer) const;
+  /**
+     \brief Returns the number of distinct k-mers
+   */
+  size_t size() const;
+  size_t getK() const;
+  size_t getThreadCount() const;
+  size_t getPartitionCount() const;
+  const TableType& getPartition(size_t p) const;
+  /**
+     \brief Calls <tt>f(kmer, count)</tt> for each distinct k-mer
+   */
+  template<class F>
+  void forEach(F f) const;
+  /**
+     \brief Returns all the counts in a single table
+   */
+  TableType merge() const;
+
+private:
+  size_t partitionOf(const CodeType& kmer) const;
+  void addSlice(const Sequence& sequence, size_t begin, size_t length);
+  void addSequence(const Sequence& sequence);
+  void flush();
+  template<class F>
+  void runParallel(F f);
+};
+
+/************************ CONSTRUCTORS **********************/
+
+template<size_t W>
+const size_t PartitionedKmerCounter<W>::DefaultSliceBases;
+
+template<size_t W>
+PartitionedKmerCounter<W>::PartitionedKmerCounter(size_t k, size_t threads, size_t partitions,
+						  size_t sliceBases)
+  : k(k), threads(threads), partitions(1), tables(), buckets(), slices(),
+    sliceBases((sliceBases == 0) ? DefaultSliceBases : sliceBases), pendingBases(0)
+{
+  if (this->threads == 0) {
+    this->threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  size_t P = (partitions == 0) ? 8 * this->threads : partitions;
+  while (this->partitions < P) {
+    this->partitions *= 2;
+  }
+  // each table is filled by one thread, so it rehashes sequentially
+  this->tables.assign(this->partitions, TableType(0, 1));
+  this->buckets.resize(this->threads * this->partitions);
+}
+
+/*********************** COUNT METHODS **********************/
+
+template<size_t W>
+void PartitionedKmerCounter<W>::count(const Sequence& sequence) {
+  addSequence(sequence);
+  flush();
+}
+
+template<size_t W>
+template<class S>
+void PartitionedKmerCounter<W>::count(const std::vector<S>& sequences) {
+  for (size_t i = 0; i < sequences.size(); ++i) {
+    addSequence(sequences[i]);
+  }
+  flush();
+}
+
+/*********************** QUERY METHODS **********************/
+
+template<size_t W>
+typename PartitionedKmerCounter<W>::CountType
+PartitionedKmerCounter<W>::getCount(const CodeType& kmer) const {
+  return this->tables[partitionOf(kmer)].count(kmer);
+}
+
+template<size_t W>
+size_t PartitionedKmerCounter<W>::size() const {
+  size_t total = 0;
+  for (size_t p = 0; p < this->partitions; ++p) {
+    total += this->tables[p].size();
+  }
+  return total;
+}
+
+template<size_t W>
+size_t PartitionedKmerCounter<W>::getK() const {
+  return this->k;
+}
+
+template<size_t W>
+size_t PartitionedKmerCounter<W>::getThreadCount() const {
+  return this->threads;
+}
+
+template<size_t W>
+size_t PartitionedKmerCounter<W>::getPartitionCount() const {
+  return this->partitions;
+}
+
+template<size_t W>
+const typename PartitionedKmerCounter<W>::TableType&
+PartitionedKmerCounter<W>::getPartition(size_t p) const {
+  return this->tables[p];
+}
+
+template<size_t W>
+template<class F>
+void PartitionedKmerCounter<W>::forEach(F f) const {
+  for (size_t p = 0; p < this->partitions; ++p) {
+    this->tables[p].for_each(f);
+  }
+}
+
+template<size_t W>
+typename PartitionedKmerCounter<W>::TableType PartitionedKmerCounter<W>::merge() const {
+  TableType merged(size(), this->threads);
+  for (size_t p = 0; p < this->partitions; ++p) {
+    merged.merge(this->tables[p]);
+  }
+  return merged;
+}
+
+/********************** UTILITY METHODS *********************/
+
+template<size_t W>
+size_t PartitionedKmerCounter<W>::partitionOf(const CodeType& kmer) const {
+  return seq::KMerWord<W>::hash(kmer) & (this->partitions - 1);
+}
+
+template<size_t W>
+void PartitionedKmerCounter<W>::addSlice(const Sequence& sequence, size_t begin, size_t length) {
+  Slice slice = { &sequence, begin, length };
+  this->slices.push_back(slice);
+  this->pendingBases += length;
+  // a round buffers (about) 4 slices per thread
+  if (this->pendingBases >= 4 * this->threads * this->sliceBases) {
+    flush();
+  }
+}
+
+template<size_t W>
+void PartitionedKmerCounter<W>::addSequence(const Sequence& sequence) {
+  size_t n = sequence.getSequenceLength();
+  // consecutive slices overlap by k - 1 bases so that no k-mer is lost
+  for (size_t begin = 0; begin + this->k <= n; begin += this->sliceBases) {
+    addSlice(sequence, begin, std::min(this->sliceBases + this->k - 1, n - begin));
+  }
+}
+
+template<size_t W>
+void PartitionedKmerCounter<W>::flush() {
+  if (this->slices.empty()) {
+    return;
+  }
+  const size_t T = this->threads;
+  const size_t P = this->partitions;
+  // phase 1: k-mers are distributed to the buffers of each thread
+  runParallel([this, T, P](size_t t) {
+      std::vector< CodeType >* own = &this->buckets[t * P];
+      for (size_t i = t; i < this->slices.size(); i += T) {
+	const Slice& slice = this->slices[i];
+	forEachKMer<W>(*slice.sequence, slice.begin, slice.length, this->k,
+		       [this, own](const CodeType& kmer, size_t) {
+			 own[partitionOf(kmer)].push_back(kmer);
+		       });
+      }
+    });
+  // phase 2: each partition is counted by its owner
+  runParallel([this, T, P](size_t t) {
+      for (size_t p = t; p < P; p += T) {
+	for (size_t u = 0; u < T; ++u) {
+	  std::vector< CodeType >& bucket = this->buckets[u * P + p];
+	  for (size_t i = 0; i < bucket.size(); ++i) {
+	    this->tables[p].add(bucket[i]);
+	  }
+	  bucket.clear();
+	}
+      }
+    });
+  this->slices.clear();
+  this->pendingBases = 0;
+}
+
+template<size_t W>
+template<class F>
+void PartitionedKmerCounter<W>::runParallel(F f) {
+  if (this->threads == 1) {
+    f(0);
+    return;
+  }
+  std::vector< std::thread > workers;
+  for (size_t t = 0; t < this->threads; ++t) {
+    workers.push_back(std::thread(f, t));
+  }
+  for (size_t t = 0; t < this->threads; ++t) {
+    workers[t].join();
+  }
+}
+
+/************************************************************/
+
+#endif
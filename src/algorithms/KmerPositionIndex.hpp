@@ -0,0 +1,561 @@
+#ifndef KMER_POSITION_INDEX_H
+#define KMER_POSITION_INDEX_H
+
+#include <core/KMerIterator.hpp>
+#include <core/Sequence.h>
+
+#include <util/file_format.hpp>
+#include <util/mapped_file.hpp>
+
+#include <string.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+   \brief Identifies the reference file an index has been built from.
+
+   The values are chosen by the writer of the index (0 if unknown): the
+   size and the modification time allow a cheap check that the file has
+   not changed, the checksum a check of its whole content.
+
+   \sa KmerPositionIndex::writeToFile()
+ */
+struct KmerIndexReference {
+  /**
+     \brief The size (in bytes) of the reference file
+   */
+  uint64_t size;
+  /**
+     \brief The modification time (in seconds since the epoch) of the
+     reference file
+   */
+  uint64_t modified;
+  /**
+     \brief A checksum of the content of the reference file
+   */
+  uint64_t checksum;
+};
+
+/**
+   \brief Header of the binary file of a KmerPositionIndex.
+
+   All the fields have a fixed size, each array of the index follows the
+   header at its own page aligned offset and is stored as in memory, so
+   that the file can be mapped and used in place.
+
+   \sa KmerPositionIndex::writeToFile()
+ */
+struct KmerIndexHeader {
+  /**
+     \brief Magic string \c LBIOKIDX, version and byte order
+   */
+  lbio::file_preamble preamble;
+  uint64_t k;
+  /**
+     \brief The size in bytes of positions and offsets
+   */
+  uint64_t positionSize;
+  uint64_t bucketBits;
+  uint64_t keyCount;
+  uint64_t positionCount;
+  /**
+     \brief The reference the index has been built from
+   */
+  KmerIndexReference reference;
+  uint64_t directoryOffset;
+  uint64_t keysOffset;
+  uint64_t offsetsOffset;
+  uint64_t positionsOffset;
+};
+
+/**
+   \brief Immutable index of the positions of the k-mers of a reference.
+
+   The index is stored in compressed sparse row (CSR) form: the distinct
+   numeric k-mers are kept sorted in one array (\c keys), the positions of
+   all the k-mers are kept in one flat array (\c positions) where the
+   positions of the i-th key are those in
+   <tt>[offsets[i], offsets[i+1])</tt>, in increasing order. A k-mer takes
+   \f$ 8 + \mathrm{sizeof}(P) \f$ bytes plus \c sizeof(P) bytes for each
+   of its occurrences, against a node of an \c unordered_map plus one node
+   of a \c std::list per occurrence.
+
+   Keys are split into buckets by their first bases and a directory gives
+   the first key of each bucket, so that a lookup is a binary search among
+   the (few) keys of a bucket.
+
+   The index is built with a parallel counting sort on the buckets:
+   - each thread counts the k-mers of its slice of the reference for each
+   bucket (the counters of a thread are one \c P per bucket, at most
+   \f$ 2^{24} \f$ of them);
+   - each thread moves its k-mers to the bucket regions (prefix sums of the
+   counters give to each thread a disjoint sub-region);
+   - buckets are sorted independently, then keys and offsets are written.
+
+   As in kmersMapping(), the position of a k-mer is the position
+   following its last base, k-mers containing bases other than \c A,
+   \c C, \c G and \c T are not indexed.
+
+   The index can be saved with writeToFile() and used later, without
+   building it again, with mapFile(): the arrays are then read in place
+   from the mapped file and pages are loaded only when accessed (and are
+   shared, through the page cache, by all the processes mapping the same
+   index).
+
+   \tparam P The type of the positions, the reference must be shorter than
+   the largest value of \c P (\c uint32_t allows references of 4G bases)
+ */
+template<class P = uint32_t>
+class KmerPositionIndex {
+public:
+  typedef P PositionType;
+
+  static const uint32_t FormatVersion = 2;
+
+  /**
+     \brief The positions of one k-mer (a view on the index)
+   */
+  class Positions {
+  private:
+    const P* first;
+    const P* last;
+  public:
+    Positions(const P* first = NULL, const P* last = NULL) : first(first), last(last) { }
+    const P* begin() const { return this->first; }
+    const P* end() const { return this->last; }
+    size_t size() const { return this->last - this->first; }
+    bool empty() const { return this->first == this->last; }
+    P front() const { return *(this->first); }
+    P operator[](size_t i) const { return this->first[i]; }
+  };
+
+private:
+  size_t k;
+  size_t bucketBits;
+  size_t keyCount;
+  size_t positionCount;
+  KmerIndexReference reference;
+  // arrays of an index built in memory
+  std::vector< uint64_t > keys;
+  std::vector< P > offsets;
+  std::vector< P > positions;
+  // keys of bucket b are in [directory[b], directory[b+1])
+  std::vector< P > directory;
+  // arrays in use (either the vectors above or the mapped file)
+  const uint64_t* keysData;
+  const P* offsetsData;
+  const P* positionsData;
+  const P* directoryData;
+  lbio::mapped_file mapping;
+
+public:
+  KmerPositionIndex();
+  /**
+     \brief Builds the index of the k-mers of a reference
+
+     \sa build()
+   */
+  KmerPositionIndex(const Sequence& ref, size_t k, size_t threads = 1);
+
+  /**
+     \brief Builds the index, previous content is discarded
+
+     \param ref The reference
+     \param k The length of the k-mers (at most 32)
+     \param threads The number of threads (0 means one per core)
+     \return \c false if the reference is too long for positions of type \c P
+   */
+  bool build(const Sequence& ref, size_t k, size_t threads = 1);
+
+  /**
+     \brief Writes the index to a binary file (see KmerIndexHeader)
+
+     \param fileName The path of the file
+     \param reference Stored in the header to identify the reference
+     (see getReference())
+     \return \c true if the file has been written
+   */
+  bool writeToFile(const std::string& fileName,
+		   const KmerIndexReference& reference = KmerIndexReference()) const;
+  /**
+     \brief Maps (read only) an index written by writeToFile(), the
+     previous content is discarded
+
+     \return \c false if the file cannot be mapped or it is not a valid
+     index file with positions of type \c P (the index is left empty)
+   */
+  bool mapFile(const std::string& fileName);
+  /**
+     \brief Checks whether the index is used in place from a mapped file
+   */
+  bool isMapped() const;
+  /**
+     \brief Returns the reference stored in the file (all zeros for
+     indexes built in memory)
+   */
+  const KmerIndexReference& getReference() const;
+
+  /**
+     \brief Returns the positions of a k-mer (empty if the k-mer does not
+     occur in the reference)
+   */
+  Positions getPositions(uint64_t kmer) const;
+  /**
+     \brief Returns the number of occurrences of a k-mer
+   */
+  size_t count(uint64_t kmer) const;
+  size_t getK() const;
+  /**
+     \brief Returns the number of distinct k-mers
+   */
+  size_t size() const;
+  bool empty() const;
+  /**
+     \brief Returns the number of indexed positions
+   */
+  size_t getPositionCount() const;
+  /**
+     \brief Returns the memory (in bytes) used by the index
+   */
+  size_t getByteCount() const;
+
+private:
+  void attach();
+  size_t bucketOf(uint64_t kmer) const;
+  template<class F>
+  static void runParallel(size_t T, F f);
+};
+
+/************************ CONSTRUCTORS **********************/
+
+template<class P>
+KmerPositionIndex<P>::KmerPositionIndex()
+  : k(0), bucketBits(0), keyCount(0), positionCount(0), reference(),
+    keys(), offsets(1, 0), positions(), directory(2, 0), mapping()
+{
+  attach();
+}
+
+template<class P>
+KmerPositionIndex<P>::KmerPositionIndex(const Sequence& ref, size_t k, size_t threads)
+  : KmerPositionIndex()
+{
+  build(ref, k, threads);
+}
+
+/************************ BUILD METHOD **********************/
+
+template<class P>
+bool KmerPositionIndex<P>::build(const Sequence& ref, size_t k, size_t threads) {
+  *this = KmerPositionIndex();
+  this->k = k;
+  size_t n = ref.getSequenceLength();
+  if (n >= (size_t)std::numeric_limits<P>::max()) {
+    std::cerr << "[ERROR] - Reference too long for the position type of the index" << std::endl;
+    return false;
+  }
+  if (k == 0 || n < k) {
+    attach();
+    return true;
+  }
+  size_t N = n - k + 1;
+  size_t T = (threads == 0) ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+  T = std::max((size_t)1, std::min(T, N / 4096 + 1));
+  // about 16 k-mers per bucket (at most 2^24 buckets)
+  while (this->bucketBits < 2 * k && this->bucketBits < 24 &&
+	 ((size_t)16 << this->bucketBits) < N) {
+    this->bucketBits++;
+  }
+  const size_t B = (size_t)1 << this->bucketBits;
+  // thread t scans the k-mers starting in [t * N / T, (t + 1) * N / T)
+  std::vector< size_t > sliceBegin(T + 1);
+  for (size_t t = 0; t <= T; ++t) {
+    sliceBegin[t] = t * N / T;
+  }
+  // counters and slots are smaller than N, so they fit the position type
+  std::vector< P > slots(T * B, 0);
+  runParallel(T, [&](size_t t) {
+      P* count = &slots[t * B];
+      size_t length = sliceBegin[t + 1] - sliceBegin[t] + k - 1;
+      forEachKMer(ref, sliceBegin[t], length, k, [this, count](uint64_t kmer, size_t) {
+	  count[bucketOf(kmer)]++;
+	});
+    });
+  // slots[t * B + b] becomes the first slot of thread t in bucket b
+  std::vector< P > bucketBegin(B + 1, 0);
+  size_t total = 0;
+  for (size_t b = 0; b < B; ++b) {
+    bucketBegin[b] = (P)total;
+    for (size_t t = 0; t < T; ++t) {
+      size_t c = slots[t * B + b];
+      slots[t * B + b] = (P)total;
+      total += c;
+    }
+  }
+  bucketBegin[B] = (P)total;
+  std::vector< uint64_t > kmers(total);
+  this->positions.resize(total);
+  runParallel(T, [&](size_t t) {
+      P* next = &slots[t * B];
+      size_t begin = sliceBegin[t];
+      size_t length = sliceBegin[t + 1] - begin + k - 1;
+      forEachKMer(ref, begin, length, k, [&, next, begin](uint64_t kmer, size_t i) {
+	  size_t s = next[bucketOf(kmer)]++;
+	  kmers[s] = kmer;
+	  this->positions[s] = (P)(begin + i + k);
+	});
+    });
+  std::vector< P >().swap(slots);
+  // buckets are sorted independently, distinct keys are counted
+  std::vector< size_t > distinct(B + 1, 0);
+  runParallel(T, [&](size_t t) {
+      std::vector< std::pair< uint64_t, P > > entries;
+      for (size_t b = t; b < B; b += T) {
+	size_t lo = bucketBegin[b];
+	size_t hi = bucketBegin[b + 1];
+	entries.resize(hi - lo);
+	for (size_t i = lo; i < hi; ++i) {
+	  entries[i - lo] = std::make_pair(kmers[i], this->positions[i]);
+	}
+	std::sort(entries.begin(), entries.end());
+	for (size_t i = lo; i < hi; ++i) {
+	  kmers[i] = entries[i - lo].first;
+	  this->positions[i] = entries[i - lo].second;
+	  distinct[b] += (i == lo || kmers[i] != kmers[i - 1]);
+	}
+      }
+    });
+  this->directory.assign(B + 1, 0);
+  size_t D = 0;
+  for (size_t b = 0; b < B; ++b) {
+    this->directory[b] = (P)D;
+    D += distinct[b];
+  }
+  this->directory[B] = (P)D;
+  this->keys.resize(D);
+  this->offsets.resize(D + 1);
+  runParallel(T, [&](size_t t) {
+      for (size_t b = t; b < B; b += T) {
+	size_t d = this->directory[b];
+	for (size_t i = bucketBegin[b]; i < bucketBegin[b + 1]; ++i) {
+	  if (i == bucketBegin[b] || kmers[i] != kmers[i - 1]) {
+	    this->keys[d] = kmers[i];
+	    this->offsets[d] = (P)i;
+	    d++;
+	  }
+	}
+      }
+    });
+  this->offsets[D] = (P)total;
+  attach();
+  return true;
+}
+
+/************************ I/O METHODS ***********************/
+
+template<class P>
+bool KmerPositionIndex<P>::writeToFile(const std::string& fileName,
+				       const KmerIndexReference& reference) const {
+  std::ofstream ofs(fileName, std::ofstream::binary | std::ofstream::out);
+  KmerIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  header.preamble.set("LBIOKIDX", FormatVersion);
+  header.k = this->k;
+  header.positionSize = sizeof(P);
+  header.bucketBits = this->bucketBits;
+  header.keyCount = this->keyCount;
+  header.positionCount = this->positionCount;
+  header.reference = reference;
+  const char* arrays[4] = {
+    (const char*)this->directoryData, (const char*)this->keysData,
+    (const char*)this->offsetsData, (const char*)this->positionsData
+  };
+  uint64_t bytes[4] = {
+    (((uint64_t)1 << this->bucketBits) + 1) * sizeof(P), this->keyCount * sizeof(uint64_t),
+    (this->keyCount + 1) * sizeof(P), this->positionCount * sizeof(P)
+  };
+  uint64_t* offsets[4] = {
+    &header.directoryOffset, &header.keysOffset, &header.offsetsOffset, &header.positionsOffset
+  };
+  uint64_t end = sizeof(header);
+  for (size_t i = 0; i < 4; ++i) {
+    *(offsets[i]) = lbio::page_align(end);
+    end = *(offsets[i]) + bytes[i];
+  }
+  ofs.write((const char*)&header, sizeof(header));
+  uint64_t written = sizeof(header);
+  for (size_t i = 0; i < 4; ++i) {
+    lbio::write_padding(ofs, written, *(offsets[i]));
+    ofs.write(arrays[i], bytes[i]);
+    written = *(offsets[i]) + bytes[i];
+  }
+  ofs.close();
+  if (!ofs) {
+    std::cerr << "[ERROR] - Unable to write the index " << fileName << std::endl;
+    return false;
+  }
+  return true;
+}
+
+template<class P>
+bool KmerPositionIndex<P>::mapFile(const std::string& fileName) {
+  // the index is left empty on errors
+  *this = KmerPositionIndex();
+  lbio::mapped_file file;
+  if (!file.open(fileName, lbio::mapped_file::random)) {
+    std::cerr << "[ERROR] - Unable to map " << fileName << std::endl;
+    return false;
+  }
+  KmerIndexHeader header;
+  if (file.size() < sizeof(header)) {
+    std::cerr << "[ERROR] - " << fileName << " is not a k-mer index file" << std::endl;
+    return false;
+  }
+  memcpy(&header, file.data(), sizeof(header));
+  uint64_t buckets = (header.bucketBits <= 24) ? ((uint64_t)1 << header.bucketBits) : 0;
+  if (!header.preamble.matches("LBIOKIDX", FormatVersion) ||
+      header.positionSize != sizeof(P) || header.k == 0 || header.k > 32 ||
+      buckets == 0 || header.bucketBits > 2 * header.k ||
+      header.directoryOffset % sizeof(uint64_t) != 0 || header.keysOffset % sizeof(uint64_t) != 0 ||
+      header.offsetsOffset % sizeof(uint64_t) != 0 || header.positionsOffset % sizeof(uint64_t) != 0 ||
+      header.keyCount >= file.size() ||
+      !lbio::array_fits(header.directoryOffset, buckets + 1, sizeof(P), file.size()) ||
+      !lbio::array_fits(header.keysOffset, header.keyCount, sizeof(uint64_t), file.size()) ||
+      !lbio::array_fits(header.offsetsOffset, header.keyCount + 1, sizeof(P), file.size()) ||
+      !lbio::array_fits(header.positionsOffset, header.positionCount, sizeof(P), file.size())) {
+    std::cerr << "[ERROR] - " << fileName << " is not a valid k-mer index file" << std::endl;
+    return false;
+  }
+  const P* dir = (const P*)(file.data() + header.directoryOffset);
+  const P* offs = (const P*)(file.data() + header.offsetsOffset);
+  // lookups trust the directory and the offsets: both must be monotone
+  // and end at the number of keys and of positions respectively
+  bool valid = (dir[0] == 0 && dir[buckets] == header.keyCount &&
+		offs[0] == 0 && offs[header.keyCount] == header.positionCount);
+  for (uint64_t b = 0; b < buckets && valid; ++b) {
+    valid = (dir[b] <= dir[b + 1]);
+  }
+  for (uint64_t i = 0; i < header.keyCount && valid; ++i) {
+    valid = (offs[i] <= offs[i + 1]);
+  }
+  if (!valid) {
+    std::cerr << "[ERROR] - " << fileName << " is corrupted" << std::endl;
+    return false;
+  }
+  // the arrays are used in place, they are never written while mapped
+  this->k = header.k;
+  this->bucketBits = header.bucketBits;
+  this->keyCount = header.keyCount;
+  this->positionCount = header.positionCount;
+  this->reference = header.reference;
+  this->directoryData = dir;
+  this->keysData = (const uint64_t*)(file.data() + header.keysOffset);
+  this->offsetsData = offs;
+  this->positionsData = (const P*)(file.data() + header.positionsOffset);
+  this->mapping = std::move(file);
+  return true;
+}
+
+template<class P>
+bool KmerPositionIndex<P>::isMapped() const {
+  return this->mapping.is_open();
+}
+
+template<class P>
+const KmerIndexReference& KmerPositionIndex<P>::getReference() const {
+  return this->reference;
+}
+
+/*********************** QUERY METHODS **********************/
+
+template<class P>
+typename KmerPositionIndex<P>::Positions
+KmerPositionIndex<P>::getPositions(uint64_t kmer) const {
+  size_t b = bucketOf(kmer);
+  const uint64_t* first = this->keysData + this->directoryData[b];
+  const uint64_t* last = this->keysData + this->directoryData[b + 1];
+  const uint64_t* it = std::lower_bound(first, last, kmer);
+  if (it == last || *it != kmer) {
+    return Positions();
+  }
+  size_t i = it - this->keysData;
+  return Positions(this->positionsData + this->offsetsData[i],
+		   this->positionsData + this->offsetsData[i + 1]);
+}
+
+template<class P>
+size_t KmerPositionIndex<P>::count(uint64_t kmer) const {
+  return getPositions(kmer).size();
+}
+
+template<class P>
+size_t KmerPositionIndex<P>::getK() const {
+  return this->k;
+}
+
+template<class P>
+size_t KmerPositionIndex<P>::size() const {
+  return this->keyCount;
+}
+
+template<class P>
+bool KmerPositionIndex<P>::empty() const {
+  return this->keyCount == 0;
+}
+
+template<class P>
+size_t KmerPositionIndex<P>::getPositionCount() const {
+  return this->positionCount;
+}
+
+template<class P>
+size_t KmerPositionIndex<P>::getByteCount() const {
+  size_t buckets = (size_t)1 << this->bucketBits;
+  return this->keyCount * sizeof(uint64_t) +
+    (this->keyCount + 1 + this->positionCount + buckets + 1) * sizeof(P);
+}
+
+/********************** UTILITY METHODS *********************/
+
+template<class P>
+void KmerPositionIndex<P>::attach() {
+  this->keyCount = this->keys.size();
+  this->positionCount = this->positions.size();
+  this->keysData = this->keys.data();
+  this->offsetsData = this->offsets.data();
+  this->positionsData = this->positions.data();
+  this->directoryData = this->directory.data();
+}
+
+template<class P>
+size_t KmerPositionIndex<P>::bucketOf(uint64_t kmer) const {
+  return (this->bucketBits == 0) ? 0 : (size_t)(kmer >> (2 * this->k - this->bucketBits));
+}
+
+template<class P>
+template<class F>
+void KmerPositionIndex<P>::runParallel(size_t T, F f) {
+  if (T == 1) {
+    f(0);
+    return;
+  }
+  std::vector< std::thread > workers;
+  for (size_t t = 0; t < T; ++t) {
+    workers.push_back(std::thread(f, t));
+  }
+  for (size_t t = 0; t < T; ++t) {
+    workers[t].join();
+  }
+}
+
+/************************************************************/
+
+#endif
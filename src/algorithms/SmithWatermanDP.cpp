@@ -1,5 +1,7 @@
 #include "SmithWatermanDP.hpp"
 
+#include <vector>
+
 /***************** CONSTRUCTOR(S)/DESTRUCTOR ****************/
 
 SmithWatermanDP::SmithWatermanDP(const char* s1, size_t n1, const char* s2, size_t n2) 
@@ -64,7 +66,8 @@ void SmithWatermanDP::computeMatrix() {
       this->resetBtMatrix();
     }
   }
-  // compute the score matrix
+  // compute the score matrix (first row and column are zero)
+  initMatrix();
   for (size_t i = 1; i < n; i++ ) {
     for (size_t j = 1; j < m; j++ ) {
       computeEntry(i,j);
@@ -145,6 +148,59 @@ void SmithWatermanDP::printBacktrackMatrix() const {
   }
 }
 
+std::string SmithWatermanDP::getCigar(const MatrixPoint2D& p, size_t& start) const {
+  start = 0;
+  if (this->btMatrix == NULL) {
+    return "";
+  }
+  // operations are collected backward and reversed at the end
+  std::vector< std::pair< char, size_t > > ops;
+  size_t i = p.i;
+  size_t j = p.j;
+  if (i + 1 < n) {
+    ops.push_back(std::make_pair('S', n - 1 - i));
+  }
+  while (i > 0 && j > 0 && matrix[i][j] > 0) {
+    char op;
+    switch (btMatrix[i][j]) {
+    case Match:
+    case Substitution:
+      op = 'M';
+      --i;
+      --j;
+      break;
+    case Deletion:
+      op = 'D';
+      --j;
+      break;
+    case Insertion:
+      op = 'I';
+      --i;
+      break;
+    default:
+      // unset entries (should not happen) end the alignment
+      op = 0;
+    }
+    if (op == 0) {
+      break;
+    }
+    if (!ops.empty() && ops.back().first == op) {
+      ops.back().second++;
+    } else {
+      ops.push_back(std::make_pair(op, 1));
+    }
+  }
+  if (i > 0) {
+    ops.push_back(std::make_pair('S', i));
+  }
+  start = j;
+  std::string cigar;
+  for (std::vector< std::pair< char, size_t > >::reverse_iterator it = ops.rbegin();
+       it != ops.rend(); ++it) {
+    cigar += std::to_string(it->second) + it->first;
+  }
+  return cigar;
+}
 
 /******************* PRIVATE UTIL METHODS *******************/
 
@@ -226,14 +282,14 @@ BacktrackOperation SmithWatermanDP::getBtForPosition(size_t i, size_t j) const {
    */
   // match or substitution
   if (matrix[i][j] == (matrix[i-1][j-1] + sim[(int)x[i-1]][(int)y[j-1]])) {
-    if (x[i-1] == y[i-1]) {
+    if (x[i-1] == y[j-1]) {
       return Match;
     } else {
       return Substitution;
     }
   }
   // deletion
-  if (matrix[i][j] == matrix[i][j-i]){
+  if (matrix[i][j] == matrix[i][j-1] - gapPenalty){
     return Deletion;
   }
   // insertion
@@ -120,6 +120,26 @@ public:
   void disableBacktrack();
   bool isBacktrackEnabled() const;
   void printBacktrackMatrix() const;
+  /**
+   * \brief Returns the CIGAR string of the local alignment ending
+   * at the given position
+   *
+   * The alignment is followed backward (using the backtrack matrix)
+   * until an entry with zero score is found. Bases of the first
+   * sequence (the read) outside the alignment are reported as soft
+   * clips, so that the CIGAR string covers the whole read as
+   * required by the SAM format. Insertions and deletions are with
+   * respect to the second sequence (the reference).
+   *
+   * \param p The last entry of the alignment (e.g. getGlobalBest())
+   * \param start Set to the (0-based) position of the second sequence
+   * where the alignment begins
+   * \return The CIGAR string or an empty string if backtrack was not
+   * enabled when the matrix was computed
+   *
+   * \sa enableBacktrack()
+   */
+  std::string getCigar(const MatrixPoint2D& p, size_t& start) const;
   
 private:
   // ---------------------------------------------------------
@@ -9,7 +9,7 @@ namespace bio {
     std::vector<Position<int>> aligns;
     size_t n = reads.size();
     for (size_t i = 0; i < n; ++i) {
-      Read r = reads[i];
+      const Read& r = reads[i];
       size_t bestAlign = -1;
       SmithWatermanDP sw(r.getBases().c_str(), r.getBases().size(), ref.c_str(), ref.size());
       sw.computeMatrix();
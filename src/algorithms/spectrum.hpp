@@ -2,6 +2,11 @@
 #define SPECTRUM_H
 
 #include <core/Sequence.h>
+#include <core/KMerIterator.hpp>
+
+#include <structures/count_table.hpp>
+
+#include "KmerPositionIndex.hpp"
 
 #include <unordered_map>
 #include <list>
@@ -13,6 +18,9 @@
    \file spectrum.hpp
    \brief Contains several helper functions to work with <i>spectrum</i> of a
    sequence.
+
+   All the functions scan the k-mers with a KMerIterator: k-mers containing
+   symbols other than A, C, G and T (e.g. N) are skipped.
  */
 
 
@@ -47,6 +55,37 @@
  */
 IntMap spectrumAsIntMap(const Sequence& ref, size_t k);
 
+/**
+   \brief Counts of the k-mers of (at most) \f$ 32W \f$ bases, stored in a
+   flat open addressing table (see lbio::count_table)
+ */
+template<size_t W = 1>
+using KmerCountTable = lbio::count_table< typename seq::KMerWord<W>::type, seq::KMerHash<W> >;
+
+/**
+   \fn spectrumAsCountTable(const Sequence& ref, size_t k);
+   \brief Computes the \f$ k \f$ spectrum of the given Sequence into a
+   KmerCountTable.
+
+   The result is the same of spectrumAsIntMap() (or spectrumAsWideMap() when
+   \c W is greater than 1), but each distinct k-mer takes 12 bytes (plus the
+   free slots, at most 30% of the table) instead of a node of an
+   `unordered_map`, and no allocation is made except when the table grows.
+   Counters saturate at \f$ 2^{32} - 1 \f$.
+
+   \param ref The reference as a Sequence type on which compute the spectrum
+   \param k The size (<i>i.e.</i> number of symbols) of the k-mers
+   \return The table of [kmer, count] pairs
+ */
+template<size_t W = 1>
+KmerCountTable<W> spectrumAsCountTable(const Sequence& ref, size_t k) {
+  KmerCountTable<W> table;
+  forEachKMer<W>(ref, k, [&table](const typename seq::KMerWord<W>::type& kmer, size_t) {
+      table.add(kmer);
+    });
+  return table;
+}
+
 /**
    \fn void spectrumAsArray(const Sequence& ref, size_t k, uint64_t* v);
    \brief Computes the \f$ k\f$ spectrum of the given sequence.
@@ -64,7 +103,16 @@ IntMap spectrumAsIntMap(const Sequence& ref, size_t k);
 void spectrumAsArray(const Sequence& ref, size_t k, uint64_t* v);
 
 /**
-   \fn kmersMapping(const Sequence& ref, size_t k);
+   \brief Defines a type for indexing numeric k-mers in a sequence.
+
+   Numeric k-mers are here represented in their `uint64_t` form, the index
+   gives the (sorted) positions where each k-mer maps as 32 bits values (see
+   KmerPositionIndex).
+ */
+typedef KmerPositionIndex< uint32_t > NumericKmerIndex;
+
+/**
+   \fn kmersMapping(const Sequence& ref, size_t k, size_t T = 1);
    \brief Computes the mapping for all k-mers in a Sequence
 
    The function uses the numeric version of a k-mer where the sequence of k
@@ -75,34 +123,52 @@ void spectrumAsArray(const Sequence& ref, size_t k, uint64_t* v);
    used to represent a single nucleotide, this function does not allow k-mers
    with \f$ k > 32 \f$.
 
-   The algorithms linearly scans the k-mers of the sequence a keep tracks of the
-   positions where each k-mer was observed. Since it uses an `urdoreed_map` to
-   keep such index, the overall asymptotic complexity of this function is   
-   \f[
-   T = O(N T_{map} T_{vec})
-   \f]
-   where \f$ N \f$ is the length of the input sequence, \f$ T_{map} \f$ is
-   the time needed to access (<i>i.e.</i> retrieve, modify and store) an element
-   from the `unordered_map` and \f$ T_{vec} \f$ is the time needed to add an
-   element to a `vector`.
+   The index is built with a counting sort of the k-mers (see
+   KmerPositionIndex) in \f$ O(N \log(N / B)) \f$ time, where \f$ N \f$ is
+   the length of the input sequence and \f$ B \f$ the number of buckets of the
+   sort, using \c T threads.
 
    \param ref The reference as a Sequence type on which perform the mapping
    \param k The size (<i>i.e.</i> number of symbols) of the k-mers
+   \param T The number of threads
+
+   \return the index containing, for each of the k-mer in the reference sequence,
+   the positions (following the last base of the k-mer) where that k-mer was
+   observed
+ */
+NumericKmerIndex kmersMapping(const Sequence& ref, size_t k, size_t T = 1);
 
-   \return a `unordered_map` containing, for each of the k-mer in the reference sequence,
-   a `vector` of positions where that k-mer was observed
+/**
+   \brief Map from k-mers of (at most) \f$ 32W \f$ bases to their count
+ */
+template<size_t W>
+using WideIntMap = std::unordered_map< typename seq::KMerWord<W>::type, uint64_t, seq::KMerHash<W> >;
+
+/**
+   \fn spectrumAsWideMap(const Sequence& ref, size_t k);
+   \brief Computes the \f$ k \f$ spectrum of the given Sequence for
+   \f$ k \le 32W \f$.
 
+   Same as spectrumAsIntMap() but k-mers are encoded with \c W words (see
+   seq::KMerWord), e.g. <tt>spectrumAsWideMap<2>(ref, 55)</tt>.
  */
-NumericKmerIndex kmersMapping(const Sequence& ref, size_t k);
+template<size_t W>
+WideIntMap<W> spectrumAsWideMap(const Sequence& ref, size_t k) {
+  WideIntMap<W> index;
+  forEachKMer<W>(ref, k, [&index](const typename seq::KMerWord<W>::type& kmer, size_t) {
+      index[kmer]++;
+    });
+  return index;
+}
 
 
 
 /**
-   \fn extractKmersMapPosition(const Sequence& seq, NumericKmerIndex index, size_t k);
+   \fn extractKmersMapPosition(const Sequence& seq, const NumericKmerIndex& index, size_t k);
    
    \brief Computes (the first) mapping position of each kmers in the input
    sequence, against the index provided as parameter
  */
-KmersMap extractKmersMapPosition(const Sequence& seq, NumericKmerIndex index, size_t k);
+KmersMap extractKmersMapPosition(const Sequence& seq, const NumericKmerIndex& index, size_t k);
 
 #endif
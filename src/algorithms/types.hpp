@@ -37,16 +37,6 @@ typedef std::vector< std::size_t > KmersMap;
  */
 typedef double KmerScoreType;
 
-/**
-   \brief Defines a type for indexing numeric k-mers in a sequence.
-   
-   Numeric k-mers are here represented in their `uint64_t` form so to be suitable
-   for key of maps, the value part is a `std::list` of `size_t` elements that are
-   used to indicate the position(s) where the k-mer maps.
-
- */
-typedef std::unordered_map< NumericKmer, std::list< std::size_t > > NumericKmerIndex;
-
 /**
    \brief Map taking `uint64_t` as both key and value.
  */
@@ -30,8 +30,8 @@ edaf_task(std::map<std::string, std::string> params) {
    while ( (it_1 != it_end) and (it_2 != it_end) ) {
      FastqRead r1 {*it_1};
      FastqRead r2 {*it_2};
-     std::string s1 = r1.getBases();
-     std::string s2 = r2.getBases();
+     const std::string& s1 = r1.getBases();
+     const std::string& s2 = r2.getBases();
      lbio_size_t d = lbio::hamming_distance(s1.cbegin(), s1.cend(), s2.cbegin());
      lbio_size_t e = edit.compute(s1, s1.size(), s2, s2.size());
      double D2 = lbio::D2_star<std::string>(k, s1.cbegin(), s1.cend(),
@@ -29,7 +29,8 @@ int runTask(OPTIONS& opts) {
       taskSelectedMsg = "Smith-Waterman alignment";
       string ref = opts.genomeFile; 
       string reads = opts.readsFile; 
-      alignFastqReadsSimpleSW(reads, ref, std::cout, 2, 8);      
+      string out = opts.alignOutputFile;
+      alignFastqReadsSimpleSW(reads, ref, std::cout, 2, 8, out);
       break;
     }
   case 2: // k-spectrum calculation
@@ -37,7 +38,8 @@ int runTask(OPTIONS& opts) {
       taskSelectedMsg = "k-spectrum";
       size_t k = opts.kmerSize;
       string ref = opts.genomeFile;
-      taskComputeKSpectrum(k, ref);
+      size_t nThreads = opts.threadsNumber;
+      taskComputeKSpectrum(k, ref, nThreads);
       break;
     }
   case 3:
@@ -49,7 +51,7 @@ int runTask(OPTIONS& opts) {
       string ref = opts.genomeFile;
       string reads = opts.readsFile;
       string out = opts.alignOutputFile;
-      taskMapReadsKmers(ref, reads, k, out);
+      taskMapReadsKmers(ref, reads, k, out, opts.verifyIndex);
       break;
     }
   case 4:
@@ -61,7 +63,7 @@ int runTask(OPTIONS& opts) {
       string reads = opts.readsFile;
       string out = opts.alignOutputFile;
       size_t nThreads = opts.threadsNumber;
-      taskKmerScoreReads(ref, reads, k, out, nThreads);
+      taskKmerScoreReads(ref, reads, k, out, nThreads, opts.verifyIndex);
       break;
     }
   case 5: 
@@ -71,7 +73,8 @@ int runTask(OPTIONS& opts) {
       string reads = opts.readsFile;
       string w_dir = opts.outputDir;
       string prefix = opts.prefixFile;
-      task_read_statistics(reads, w_dir, prefix);
+      size_t nThreads = opts.threadsNumber;
+      task_read_statistics(reads, w_dir, prefix, nThreads);
       break;
     }
   case 6: // generate
@@ -95,6 +98,28 @@ int runTask(OPTIONS& opts) {
       edaf_task(gen_opts);
       break;
     }
+  case 8: // k-mer counting in external memory
+    {
+      taskSelectedMsg = "k-count";
+      size_t k = opts.kmerSize;
+      string reads = opts.readsFile;
+      string out = opts.alignOutputFile;
+      if (out.empty()) {
+	out = opts.outputDir + opts.prefixFile + "spectrum.bin";
+      }
+      taskCountKmersExternal(k, reads, out, opts.outputDir, opts.memoryLimit);
+      break;
+    }
+  case 9: // persisted k-mer index of the reference
+    {
+      taskSelectedMsg = "k-mer index";
+      size_t k = opts.kmerSize;
+      string ref = opts.genomeFile;
+      string out = opts.alignOutputFile;
+      size_t nThreads = opts.threadsNumber;
+      taskBuildKmerIndex(k, ref, out, nThreads);
+      break;
+    }
   default:
     std::cout << "Unrecognized operation" << std::endl;
     return 1;
@@ -5,6 +5,7 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 #include <map>
 
@@ -21,7 +22,9 @@ const std::vector<std::string> tVec =
     std::string("kscore"),
     std::string("readstats"),
     std::string("generate"),
-    std::string("edaf")
+    std::string("edaf"),
+    std::string("kcount"),
+    std::string("index")
   };
 
 
@@ -69,6 +72,17 @@ AlignAlgorithm parseAlgorithmType(const char* optval) {
   }
 }
 
+// returns 0 unless optval is a positive number of MB (that fits in bytes)
+size_t parseMemoryLimit(const char* optval) {
+  char* end = NULL;
+  unsigned long long v = strtoull(optval, &end, 10);
+  if (optval[0] == '-' || end == optval || *end != '\0' ||
+      v > (std::numeric_limits<size_t>::max() >> 20)) {
+    return 0;
+  }
+  return (size_t)v;
+}
+
 // TO BE MOVED IN A PROPER TIME/STRING UTIL PLACE
 
 template <typename Num, int Digits>
@@ -137,7 +151,7 @@ remove_punctuation_and_spaces(const std::string& in) {
 
 // END UTIL FUNCTIONS
 
-const char* shortOptions = "hvC:ntg:G:f:r:R:F:o:d:X:p:c:A:k:T:";
+const char* shortOptions = "hvC:ntg:G:f:r:R:F:o:d:X:p:c:A:k:VM:T:";
 const struct option longOptions[] = 
   {
     { "help", 0, NULL, 'h' },
@@ -158,7 +172,10 @@ const struct option longOptions[] =
     { "genome-copies", 1, NULL, 'c' },
     { "algorithm-type", 1, NULL, 'A' },
     { "kmer-size", 1, NULL, 'k' },
-    { "threads", 1, NULL, 'T' }
+    { "verify-index", 0, NULL, 'V' },
+    { "memory", 1, NULL, 'M' },
+    { "threads", 1, NULL, 'T' },
+    { NULL, 0, NULL, 0 }
   };
 
 options::options() {
@@ -188,8 +205,10 @@ options::options() {
   align = true;
   alignAlgorithm = CPU_DP;
   kmerSize = 15;
+  verifyIndex = false;
 
   threadsNumber = 1;
+  memoryLimit = 1024;
 
   
 }
@@ -259,6 +278,16 @@ void options::parseInputArgs(int argc, char** argv) {
     case 'k':
       this->kmerSize = atoi(optarg);
       break;
+    case 'V':
+      this->verifyIndex = true;
+      break;
+    case 'M':
+      this->memoryLimit = parseMemoryLimit(optarg);
+      if (this->memoryLimit == 0) {
+	cerr << "[ERROR] - Invalid memory budget (MB): " << optarg << endl;
+	printUsage(cerr, argv[0], 1);
+      }
+      break;
     case 'T':
       this->threadsNumber = atoi(optarg);
     default:
@@ -289,5 +318,6 @@ void options::printOptions(ostream& os) {
   os << "Algorithm:  " << this->alignAlgorithm << '\n';
   os << "K-Mer size: " << this->kmerSize << '\n';
   os << "-- RUNTIME --" << '\n';
-  os << "Threads:    " << this->threadsNumber;
+  os << "Threads:    " << this->threadsNumber << '\n';
+  os << "Memory:     " << this->memoryLimit << " MB";
 }
@@ -112,6 +112,11 @@ struct options {
    * \brief Length of a k-mer (when k-mers are used)
    */
   size_t kmerSize;
+  /**
+   * \brief Compares the checksum of the whole reference before using
+   * a stored k-mer index (otherwise only size and modification time)
+   */
+  bool verifyIndex;
 
   // ---------------------------------------------------------
   //                   RUNTIME INFORMATIONS
@@ -120,6 +125,11 @@ struct options {
    * \brief Number of threads started (if applicable)
    */
   size_t threadsNumber;
+  /**
+   * \brief Memory budget (in MB) of tasks working in external
+   * memory
+   */
+  size_t memoryLimit;
 
   // ---------------------------------------------------------
   //                   PARSING OPERATIONS
@@ -1,14 +1,22 @@
 #include <cmath>
+#include <cstring>
 #include <vector>
 #include <fstream>
+#include <sstream>
 #include <iterator>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <unordered_map>
 #include <ctime>
 #include <algorithm>
 #include <random>
 
+#include <sys/stat.h>
+
 #include <util/io_helper.hpp>
+#include <util/mapped_file.hpp>
 // 2D matrix
 #include <structures/matrix.hpp>
 // prob utilities
@@ -21,6 +29,7 @@
 #include "tasks.hpp"
 #include <core/core.h>
 #include "../io.h"
+#include "../io/BamFormat.hpp"
 #include "../algorithms.h"
 
 
@@ -45,23 +54,148 @@ size_t bytesRemainingToTheEnd(std::ifstream& ifs) {
   return (totalLength - ifs.tellg());
 }
 
+// Returns the name of a read (or reference) from its header line
+std::string headerToName(const std::string& header) {
+  size_t begin = (!header.empty() && (header[0] == '@' || header[0] == '>')) ? 1 : 0;
+  size_t end = header.find_first_of(" \t\r\n", begin);
+  return header.substr(begin, (end == std::string::npos) ? std::string::npos : end - begin);
+}
+
+// Checksum of the bytes of a file (FNV-1a like, one word at a time), used
+// to check that a k-mer index file was built from a reference file
+static uint64_t fileChecksum(const std::string& path) {
+  lbio::mapped_file file(path, lbio::mapped_file::sequential);
+  uint64_t h = 14695981039346656037ULL;
+  size_t words = file.size() / sizeof(uint64_t);
+  for (size_t i = 0; i < words; ++i) {
+    uint64_t w;
+    memcpy(&w, file.data() + i * sizeof(uint64_t), sizeof(w));
+    h = (h ^ w) * 1099511628211ULL;
+  }
+  for (size_t i = words * sizeof(uint64_t); i < file.size(); ++i) {
+    h = (h ^ (uint8_t)file.data()[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+// Size and modification time of a reference file (and the checksum of its
+// content when requested), stored in the k-mer index built from it
+static KmerIndexReference fileReference(const std::string& path, bool withChecksum) {
+  KmerIndexReference reference = KmerIndexReference();
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0) {
+    reference.size = st.st_size;
+    reference.modified = st.st_mtime;
+  }
+  if (withChecksum) {
+    reference.checksum = fileChecksum(path);
+  }
+  return reference;
+}
+
+// Path of the k-mer index of a reference written by the index task (next
+// to the reference, as the .fai of faidx)
+std::string kmerIndexPath(const std::string& reference, size_t k) {
+  return reference + ".k" + std::to_string(k) + ".kidx";
+}
+
+// Maps the index of the reference written by the index task when it exists
+// and matches the reference file (same size and modification time, and the
+// same content when 'verify' is set), otherwise loads the reference and
+// builds the index using T threads
+void loadKmerIndex(const std::string& reference, size_t k, size_t T, NumericKmerIndex& index,
+		   bool verify) {
+  std::string indexPath = kmerIndexPath(reference, k);
+  if (std::ifstream(indexPath).good()) {
+    std::cout << "Mapping index (" << indexPath << ")...";
+    std::cout.flush();
+    KmerIndexReference current = fileReference(reference, verify);
+    if (index.mapFile(indexPath) && index.getK() == k &&
+	index.getReference().size == current.size &&
+	index.getReference().modified == current.modified &&
+	(!verify || index.getReference().checksum == current.checksum)) {
+      std::cout << " Ok! (" << index.size() << " k-mers)" << std::endl;
+      return;
+    }
+    std::cout << " Index does not match the reference" << std::endl;
+  }
+  std::cout << "Loading reference (" << reference << ")...";
+  std::cout.flush(); // in case of stuck code we see at which point
+  FastFormat refFast(reference);
+  Reference ref = refFast.toReference();
+  std::cout << " Done (" << ref.getSequenceLength() << " bases)" << std::endl;
+  std::cout << "Index creation...";
+  std::cout.flush();
+  index = kmersMapping(ref, k, T);
+  std::cout << " Ok!" << std::endl;
+}
+
+// When 'records' is not NULL the backtrack is enabled and a BAM record
+// (with CIGAR) is created for each read
 void alignSmithWaterman(std::vector<Read>* reads, const Reference* ref, 
-			std::vector<ScoredPosition<int,int> >* aligns, int indexOffset) {
+			std::vector<ScoredPosition<int,int> >* aligns, int indexOffset,
+			std::vector<lbiobam::BamAlignment>* records) {
   int nReads = reads->size();
   string refBases((char*)ref->getSequence());
   std::cout << "Aligning " << nReads << " reads" << std::endl;
   for (int i = 0; i < nReads; ++i) {    
-    SmithWatermanDP sw((*reads)[i].getBases(), refBases);
+    // the bases must outlive the DP object (it keeps a pointer)
+    const string& bases = (*reads)[i].getBases();
+    SmithWatermanDP sw(bases, refBases);
+    if (records != NULL) {
+      sw.enableBacktrack();
+    }
     sw.computeMatrix();
     MatrixPoint2D maxP = sw.getGlobalBest();
-    aligns->push_back(ScoredPosition<int, int>((i + indexOffset),maxP.j, sw.getScoreAt(maxP)));
+    int score = sw.getScoreAt(maxP);
+    aligns->push_back(ScoredPosition<int, int>((i + indexOffset),maxP.j, score));
+    if (records != NULL) {
+      lbiobam::BamAlignment record;
+      record.qname = headerToName((*reads)[i].getHeader());
+      record.seq = bases;
+      record.qual = (*reads)[i].getQualities();
+      if (record.qual.size() != bases.size()) {
+	record.qual.clear();
+      }
+      if (score > 0) {
+	size_t start = 0;
+	record.tid = 0;
+	record.cigar = sw.getCigar(maxP, start);
+	record.pos = start;
+	record.score = score;
+      } else {
+	record.flag = lbiobam::BamAlignment::Unmapped;
+	record.mapq = 0;
+      }
+      records->push_back(record);
+    }
+  }
+}
+
+// Writes the alignments of all threads (in order) to a BAM file
+void writeAlignmentsBam(const string& bamPath, const string& refName, uint64_t refLength,
+			const std::vector<std::vector<lbiobam::BamAlignment>*>& records,
+			uint64_t nThreads) {
+  lbiobam::BamFormat bam;
+  bam.open(bamPath, lbiobam::BamOpenWrite);
+  bam.setThreads(nThreads);
+  std::vector<lbiobam::BamReferenceInfo> refs;
+  refs.push_back(lbiobam::BamReferenceInfo(refName, refLength));
+  bam.setBamHeader(refs);
+  bam.writeBamHeader();
+  for (std::vector<lbiobam::BamAlignment>* v : records) {
+    for (const lbiobam::BamAlignment& a : *v) {
+      bam.writeAlignment(a);
+    }
   }
+  bam.close();
 }
 
 
 
 std::vector<ScoredPosition<int, int> > alignFastqReadsSimpleSW(const string& readsPath, const string& referencePath, 
-							       std::ostream& output, uint64_t nThreads, size_t nReads) {
+							       std::ostream& output, uint64_t nThreads, size_t nReads,
+							       const string& bamPath) {
   
   std::cout << "-- Smith Waterman alignment --" << std::endl;
   std::cout.flush();
@@ -81,6 +215,8 @@ std::vector<ScoredPosition<int, int> > alignFastqReadsSimpleSW(const string& rea
   // list of all threads (use later for joining)  
   std::vector<std::thread> threads;
   std::vector<std::vector<ScoredPosition<int,int> >*> threadAligns;
+  std::vector<std::vector<Read>*> threadReads;
+  std::vector<std::vector<lbiobam::BamAlignment>*> threadRecords;
 
   // read input reference...
   std::cout << "    Loading reference..." << std::endl;
@@ -109,7 +245,15 @@ std::vector<ScoredPosition<int, int> > alignFastqReadsSimpleSW(const string& rea
       // create the aligns vector for the next starting thread
       std::vector<ScoredPosition<int,int> >* alignsVector = new std::vector<ScoredPosition< int,int > >();
       threadAligns.push_back(alignsVector);
-      threads.push_back(std::thread(alignSmithWaterman, reads, &ref, alignsVector, t * readsPerThread));
+      threadReads.push_back(reads);
+      // BAM records (with CIGAR) are built only when requested
+      std::vector<lbiobam::BamAlignment>* recordsVector = NULL;
+      if (!bamPath.empty()) {
+	recordsVector = new std::vector<lbiobam::BamAlignment>();
+	threadRecords.push_back(recordsVector);
+      }
+      threads.push_back(std::thread(alignSmithWaterman, reads, &ref, alignsVector, t * readsPerThread,
+				    recordsVector));
     }
 
 
@@ -137,6 +281,18 @@ std::vector<ScoredPosition<int, int> > alignFastqReadsSimpleSW(const string& rea
     aligns.insert(aligns.end(), v->begin(), v->end());
     delete v;
   }
+  for (std::vector<Read>* v : threadReads) {
+    delete v;
+  }
+
+  if (!bamPath.empty()) {
+    writeAlignmentsBam(bamPath, headerToName(fast.getHeader()), ref.getSequenceLength(),
+		       threadRecords, T);
+    for (std::vector<lbiobam::BamAlignment>* v : threadRecords) {
+      delete v;
+    }
+    return aligns;
+  }
   
 
   output << "*** Alignments: " << std::endl;
@@ -148,17 +304,75 @@ std::vector<ScoredPosition<int, int> > alignFastqReadsSimpleSW(const string& rea
 }
 
 /**************************** K-SPECTRUM FUNCTIONS ****************************/
-void taskComputeKSpectrum(size_t k, const string& referenceFile) {
+void taskComputeKSpectrum(size_t k, const string& referenceFile, size_t T) {
   FastFormat fast;
   fast.loadFromFile(referenceFile);
   Reference ref = (Reference) fast;
-  std::unordered_map< uint64_t, uint64_t > index = spectrumAsIntMap(ref, k);
-  for (std::pair< uint64_t, uint64_t > p : index) {
-    std::cout << seq::NumericKMer(p.first, k) << " " << p.second << std::endl;
+  PartitionedKmerCounter<> index(k, (T > 1) ? T : 1);
+  index.count(ref);
+  index.forEach([k](uint64_t kmer, uint32_t count) {
+      std::cout << seq::NumericKMer(kmer, k) << " " << count << "\n";
+    });
+  std::cout.flush();
+}
+
+void taskCountKmersExternal(size_t k, const string& input, const string& out,
+			    const string& workDir, size_t memoryMB) {
+  ExternalKmerCounter counter(k, workDir, memoryMB << 20);
+  // first pass: k-mers are streamed to the partition files
+  CompressedInputStream in(input);
+  if (!in.is_open()) {
+    std::cerr << "[ERROR] - Unable to open " << input << std::endl;
+    return;
   }
+  bool ok = true;
+  if (in.peek() == '>') {
+    in.close();
+    FastaStreamReader reader(input);
+    std::string name, bases;
+    while (ok && reader.nextRecord(name, bases)) {
+      ok = counter.add(bases.data(), bases.size());
+    }
+  } else {
+    FastqRead r;
+    while (ok && in >> r) {
+      ok = counter.add(r.getBases().data(), r.getBases().size());
+    }
+    in.close();
+  }
+  uint64_t total = counter.getTotalCount();
+  // second pass: partitions are counted and merged
+  if (!ok || !counter.writeSpectrum(out)) {
+    return;
+  }
+  KmerSpectrumFile spectrum(out);
+  std::cout << "K-mers:          " << total << "\n";
+  std::cout << "Distinct k-mers: " << spectrum.size() << "\n";
+  std::cout << "Spectrum file:   " << out << std::endl;
 }
 
-void taskMapReadsKmers(const string& reference, const string& reads, size_t k, const string& out) {
+void taskBuildKmerIndex(size_t k, const string& reference, const string& out, size_t T) {
+  string indexPath = out.empty() ? kmerIndexPath(reference, k) : out;
+  time_t beginTime, endTime;
+  std::cout << "Loading reference (" << reference << ")...";
+  std::cout.flush();
+  FastFormat refFast(reference);
+  Reference ref = refFast.toReference();
+  std::cout << " Done (" << ref.getSequenceLength() << " bases)" << std::endl;
+  std::cout << "Index creation...";
+  std::cout.flush();
+  time(&beginTime);
+  NumericKmerIndex index = kmersMapping(ref, k, (T > 1) ? T : 1);
+  time(&endTime);
+  std::cout << " Ok! (" << difftime(endTime, beginTime) << " sec, "
+	    << index.size() << " k-mers)" << std::endl;
+  if (index.writeToFile(indexPath, fileReference(reference, true))) {
+    std::cout << "Index file:   " << indexPath << std::endl;
+  }
+}
+
+void taskMapReadsKmers(const string& reference, const string& reads, size_t k, const string& out,
+		       bool verifyIndex) {
   std::cout << "-------------------- Reads Mapping --------------------" << std::endl;
   // open files
   std::ofstream outFileStream;
@@ -166,34 +380,28 @@ void taskMapReadsKmers(const string& reference, const string& reads, size_t k, c
     outFileStream.open(out, std::ios::out);
   }
   std::ostream& outStream = (out.empty()) ? std::cout : outFileStream;
-  FastFormat refFast;
-  std::cout << "Loading reference (" << reference << ")...";
-  std::cout.flush();
-  refFast.loadFromFile(reference);
-  std::cout << " Ok!" << std::endl;
-  Reference ref = refFast.toReference();
-  
   std::ifstream readsStream(reads, std::ios::in);
 
-  // compute index for the reference
-  std::cout << "Index creation...";
-  std::cout.flush();
-  NumericKmerIndex index = kmersMapping(ref, k);
-  std::cout << " Ok!" << std::endl;
+  // map (or compute) the index for the reference
+  NumericKmerIndex index;
+  loadKmerIndex(reference, k, 1, index, verifyIndex);
   // scan reads and find mappings
   size_t read_index = 0;
   size_t kmer_index = 0;
   std::cout << "Reads mapping...";
   std::cout.flush();
-  while(!readsStream.eof()) {
-    FastqRead r;
-    readsStream >> r;
-    list< KMer > kmers = r.getKMerList(k);
+  // k-mers of each read are views allocated in the arena, which is
+  // released (in constant time) before the next read is loaded
+  lbio::arena kmersArena;
+  FastqRead r;
+  while(readsStream >> r) {
+    kmersArena.release();
+    KMerSpanList kmers = r.getKMerList(k, kmersArena);
     kmer_index = 0;
-    for (KMer kmer : kmers) {
-      seq::NumericKMer nkmer(kmer);
-      std::unordered_map< uint64_t, std::list< size_t > >::const_iterator it = index.find((uint64_t)nkmer);
-      outStream << read_index << ":" << kmer_index << " "  << ((it == index.end()) ? (int64_t)(-1) :  (int64_t)it->second.front() ) << std::endl;
+    for (const lbio::char_span& kmer : kmers) {
+      uint64_t nkmer = seq::NumericKMer::fromChars(kmer.data(), kmer.size());
+      NumericKmerIndex::Positions p = index.getPositions(nkmer);
+      outStream << read_index << ":" << kmer_index << " "  << (p.empty() ? (int64_t)(-1) :  (int64_t)p.front() ) << std::endl;
       kmer_index++;
     }
     read_index++;
@@ -207,7 +415,8 @@ void taskMapReadsKmers(const string& reference, const string& reads, size_t k, c
 // *****************************************************************************
 // Computes for each reads of the input set the kmerscore and the number of errors
 // (see algorithms/kmerscore) against the reference sequence
-void taskKmerScoreReads(const string& reference, const string& reads, size_t k, const string& out, size_t T) {
+void taskKmerScoreReads(const string& reference, const string& reads, size_t k, const string& out, size_t T,
+			bool verifyIndex) {
   // if 0 or other wrong values are set for T, then set it to 1 (i.e. single thread)
   T = (T > 1) ? T : 1;
 
@@ -219,46 +428,84 @@ void taskKmerScoreReads(const string& reference, const string& reads, size_t k,
   std::ostream& outStream = (out.empty()) ? std::cout : outFileStream;
   time_t beginTime, endTime;
 
-  // "split" input file into T threads (if multithreaded is required)
-  if (T > 1) {
-  }
-  
   std::cout << "-------------------- Reads Mapping --------------------" << std::endl;
-  // open files 
-  std::cout << "Loading reference (" << reference << ")...";
-  std::cout.flush(); // in case of stuck code we see at which point
-  FastFormat refFast(reference);  
-  Reference ref = refFast.toReference();
-  std::cout << " Done (" << ref.getSequenceLength() << " bases)" << std::endl;
-
-  // open a stream for reading reads file
-  std::ifstream readsStream(reads, std::ios::in);
-
-  // compute the index for the reference
-  std::cout << "Index creation...";
-  std::cout.flush();
+  // map (or compute) the index for the reference
   time(&beginTime);
-  NumericKmerIndex index = kmersMapping(ref, k);
+  NumericKmerIndex index;
+  loadKmerIndex(reference, k, T, index, verifyIndex);
   time(&endTime);  
-  std::cout << " Ok! (" << difftime(endTime, beginTime) << " sec)" << std::endl;
+  std::cout << "Index ready (" << difftime(endTime, beginTime) << " sec)" << std::endl;
   std::cout << "Calculating scores...";
   std::cout.flush();
   size_t M = 0;
   time(&beginTime);
-  while(!readsStream.eof()) {
+  if (T > 1) {
+    // the file is split in ranges (of about 16MB, at least 4 per
+    // thread) that are parsed and scored in parallel, threads take the
+    // ranges in file order and write the scores of a range as soon as
+    // all the previous ranges have been written, so the output follows
+    // the order of the input file and at most T ranges are buffered
+    size_t ranges = std::max(4 * T, (size_t)(fileReference(reads, false).size >> 24) + 1);
+    FastqParallelReader reader(reads, ranges);
+    std::atomic< size_t > nextRange(0);
+    std::mutex outMutex;
+    std::condition_variable outTurn;
+    size_t written = 0;
+    std::vector< std::thread > workers;
+    for (size_t t = 0; t < T; ++t) {
+      workers.push_back(std::thread([&reader, ranges, &nextRange, &outMutex, &outTurn, &written,
+				     &outStream, &M, &index, k]() {
+	    std::ostringstream buffer;
+	    for (size_t b = nextRange++; b < ranges; b = nextRange++) {
+	      buffer.str("");
+	      size_t scored = 0;
+	      reader.forEachRecordInBlock(b, [&](size_t, const FastqRecordView& v) {
+		  if (v.bases.empty()) {
+		    return;
+		  }
+		  // the record is scored in place, no read is materialized
+		  ReadRecord r(v.header, v.bases, v.qualities);
+		  KmersMap map = extractKmersMapPosition(r, index, k);
+		  std::vector< uint64_t > scoreVector = kmerScoreVector(map, k);
+		  KmerScoreType score = scoreForVector(scoreVector, k);
+		  size_t errors = kmerErrorCount(map, k);
+		  buffer << score << " " << errors << "\n";
+		  scored++;
+		});
+	      {
+		std::unique_lock< std::mutex > lock(outMutex);
+		outTurn.wait(lock, [&written, b]() { return written == b; });
+		outStream << buffer.str();
+		M += scored;
+		written = b + 1;
+	      }
+	      outTurn.notify_all();
+	    }
+	  }));
+    }
+    for (std::thread& w : workers) {
+      w.join();
+    }
+    outStream.flush();
+  } else {
+    // open a stream for reading reads file
+    std::ifstream readsStream(reads, std::ios::in);
+    // the same read is reloaded each time so that its strings keep
+    // their capacity
     FastqRead r;
-    readsStream >> r;
-    if (r.getSequenceLength() == 0) {
-      continue;
+    while(readsStream >> r) {
+      if (r.getSequenceLength() == 0) {
+	continue;
+      }
+      KmersMap map = extractKmersMapPosition(r, index, k);
+      std::vector< uint64_t > scoreVector = kmerScoreVector(map, k);
+      KmerScoreType score = scoreForVector(scoreVector, k);
+      size_t errors = kmerErrorCount(map, k);
+      outStream << score << " " << errors << std::endl;
+      M++;
     }
-    KmersMap map = extractKmersMapPosition(r, index, k);
-    std::vector< uint64_t > scoreVector = kmerScoreVector(map, k);
-    KmerScoreType score = scoreForVector(scoreVector, k);
-    size_t errors = kmerErrorCount(map, k);
-    outStream << score << " " << errors << std::endl;
-    M++;
+    readsStream.close();
   }
-  readsStream.close();
   time(&endTime);
   double elapsed = difftime(endTime, beginTime);
   double rate = M / elapsed;
@@ -268,7 +515,7 @@ void taskKmerScoreReads(const string& reference, const string& reads, size_t k,
 
 void
 task_read_statistics(const std::string& reads, const string& w_dir,
-		     const string& prefix) {
+		     const string& prefix, size_t T) {
 
   using BaseQualPair = std::pair<char,int>;
   using IntIntMap = std::map<int,int>;
@@ -278,22 +525,30 @@ task_read_statistics(const std::string& reads, const string& w_dir,
   //IntIntMap qualities;
   //  CharIntMap bases;
   
-  lbio_size_t total_pair = 0;
-  // for each read in the stream
-  std::ifstream ifs(reads, std::ifstream::in);
-  for (std::istream_iterator<FastqRead> it(ifs);
-       it != std::istream_iterator<FastqRead>(); ++it) {
-    FastqRead read {*it};
-    lengths[read.length()]++;
-    lbio_size_t read_len = read.length();
-    std::string bs = read.getBases();
-    std::string qs = read.getQualities();
-    for (lbio_size_t i = 0; i < read_len; ++i) {
-      base_qual_freq[std::make_pair(bs[i], static_cast<int>(qs[i]-33))]++;
-      total_pair++;
-    }    
+  // the blocks of the file are scanned by T workers, each one
+  // collecting its own partial statistics that are merged at the end;
+  // records are views of the mapped file, bases and qualities are
+  // never copied
+  FastqParallelReader reader(reads, T);
+  size_t workers = reader.getThreadCount();
+  std::vector< IntIntMap > partial_lengths(workers);
+  std::vector< std::map<BaseQualPair,lbio_size_t> > partial_freq(workers);
+  reader.forEachRecord([&partial_lengths, &partial_freq](size_t t, const FastqRecordView& read) {
+      lbio_size_t read_len = read.bases.size();
+      partial_lengths[t][read_len]++;
+      lbio_size_t pairs = std::min(read_len, read.qualities.size());
+      for (lbio_size_t i = 0; i < pairs; ++i) {
+	partial_freq[t][std::make_pair(read.bases[i], static_cast<int>(read.qualities[i]-33))]++;
+      }
+    });
+  for (size_t t = 0; t < workers; ++t) {
+    for (auto key : partial_lengths[t]) {
+      lengths[key.first] += key.second;
+    }
+    for (auto pair : partial_freq[t]) {
+      base_qual_freq[pair.first] += pair.second;
+    }
   }
-  ifs.close();
 
   // save length stat file
   // [len]\t[count]
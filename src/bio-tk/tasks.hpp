@@ -13,7 +13,7 @@
  * on the input received from the command line.
  */
 
-/**  \fn alignFastqReadsSimpleSW(const string& readsPath, const string& referencePath, std::ostream& output, uint64_t nThreads = 1, size_t nReads = -1);
+/**  \fn alignFastqReadsSimpleSW(const string& readsPath, const string& referencePath, std::ostream& output, uint64_t nThreads = 1, size_t nReads = -1, const string& bamPath = "");
   \brief Aligns reads contained in a fastq file against a regerence contained in
   a fast file.
 
@@ -39,28 +39,68 @@
   \param nThreads The number of threads used to align (can be omitted, default is 1)
   \param nReads The number of reads, can be omitted in which case this number is
   estimated when creating reads blocks (see above).
+  \param bamPath When not empty the alignments (with the CIGAR obtained from the
+  backtrack) are written to this BAM file (SAM if the extension is \c .sam)
+  instead of the plain text output, compression uses \c nThreads threads.
 */
-std::vector<ScoredPosition<int,int> > alignFastqReadsSimpleSW(const string& readsPath, const string& referencePath, std::ostream& output, uint64_t nThreads = 1, size_t nReads = -1);
+std::vector<ScoredPosition<int,int> > alignFastqReadsSimpleSW(const string& readsPath, const string& referencePath, std::ostream& output, uint64_t nThreads = 1, size_t nReads = -1, const string& bamPath = "");
 
 /**
-   \fn taskComputeKSpectrum(size_t k, const string& referenceFile);
-   \brief Computes the \f$ k \f$ spectrum of the input reference file.
+   \fn taskComputeKSpectrum(size_t k, const string& referenceFile, size_t T = 1);
+   \brief Computes the \f$ k \f$ spectrum of the input reference file
+   using \c T threads (see PartitionedKmerCounter).
  */
-void taskComputeKSpectrum(size_t k, const string& referenceFile);
+void taskComputeKSpectrum(size_t k, const string& referenceFile, size_t T = 1);
 
 /**
-   \fn taskMapReadsKmers(const string& reference, const string& reads, size_t k, const string& out = "", size_t nThreads = 1);
+   \fn taskCountKmersExternal(size_t k, const string& input, const string& out, const string& workDir, size_t memoryMB);
+   \brief Counts the k-mers of a (possibly compressed) fasta or fastq file
+   within \c memoryMB MB of memory (see ExternalKmerCounter).
+
+   Temporary files are written in \c workDir, the sorted spectrum is written
+   to \c out and can be mapped with KmerSpectrumFile.
+ */
+void taskCountKmersExternal(size_t k, const string& input, const string& out,
+			    const string& workDir, size_t memoryMB);
+
+/**
+   \fn taskBuildKmerIndex(size_t k, const string& reference, const string& out = "", size_t T = 1);
+   \brief Builds the k-mer index of the reference (see KmerPositionIndex) using
+   \c T threads and writes it to \c out.
+
+   When \c out is empty the index is written next to the reference (as
+   <tt>reference.k<k>.kidx</tt>), where it is found and mapped by
+   taskMapReadsKmers() and taskKmerScoreReads() instead of building the index
+   again. The header of the file stores the size, the modification time and a
+   checksum of the reference file, an index of a reference that has changed is
+   ignored (see \c verifyIndex of taskMapReadsKmers()).
+ */
+void taskBuildKmerIndex(size_t k, const string& reference, const string& out = "", size_t T = 1);
+
+/**
+   \fn taskMapReadsKmers(const string& reference, const string& reads, size_t k, const string& out = "", bool verifyIndex = false);
    \brief For each read in the input set, maps its kmers against the given reference.
 
    This function takes as input file name for reference sequence and reads set, the size
    of kmers \f$ k \$f and a (possibly empty) `string` representing the output path.
    First it creates a _map_g
+
+   An index written by taskBuildKmerIndex() is used when the size and the
+   modification time of the reference match, when \c verifyIndex is set the
+   checksum of the whole reference is compared as well.
  */
-void taskMapReadsKmers(const string& reference, const string& reads, size_t k, const string& out = "");
+void taskMapReadsKmers(const string& reference, const string& reads, size_t k, const string& out = "",
+		       bool verifyIndex = false);
 
-void taskKmerScoreReads(const string& reference, const string& reads, size_t k, const string& out = "", size_t nThreads = 1);
+void taskKmerScoreReads(const string& reference, const string& reads, size_t k, const string& out = "", size_t nThreads = 1,
+			bool verifyIndex = false);
 
-void task_read_statistics(const std::string& reads, const string& w_dir, const string& prefix);
+/**
+   Writes the length and the (base, quality) frequencies of the reads,
+   the file is scanned by \c T threads (see FastqParallelReader).
+ */
+void task_read_statistics(const std::string& reads, const string& w_dir, const string& prefix,
+			  size_t T = 1);
 
 void
 task_generate(std::map<std::string,std::string> gen_params);
@@ -0,0 +1,417 @@
+#include <core/BaseEncoder.hpp>
+#include <core/DNAAlphabet2Bits.hpp>
+#include <core/DNACompressedSymbol.h>
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE_ENCODER_X86
+#include <immintrin.h>
+#endif
+
+/******************** SUPPORT FUNCTIONS *********************/
+
+// Instruction sets, in increasing order
+enum SimdLevel { SCALAR = 0, SSE41 = 1, AVX2 = 2 };
+
+static int detectSimdLevel() {
+#ifdef BASE_ENCODER_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return SSE41;
+  }
+#endif
+  return SCALAR;
+}
+
+static int simdLevel() {
+  static int level = detectSimdLevel();
+  return level;
+}
+
+// Scalar conversion tables, built from the symbol classes so that
+// all the kernels agree with them
+struct EncodingTables {
+  uint8_t code2[256];
+  uint8_t ambiguous2[256];
+  uint8_t code4[256];
+  char symbols2[4];
+  char symbols4[16];
+  EncodingTables() {
+    for (size_t c = 0; c < 256; ++c) {
+      code2[c] = (uint8_t)DNAAlphabet2Bits::charToInt((char)c);
+      ambiguous2[c] = (DNAAlphabet2Bits::intToChar(code2[c]) != (char)(c & 0xDF));
+      code4[c] = DNACompressedSymbol::IupacToNumber((char)c);
+    }
+    for (uint8_t i = 0; i < 4; ++i) {
+      symbols2[i] = DNAAlphabet2Bits::intToChar(i);
+    }
+    for (uint8_t i = 0; i < 16; ++i) {
+      symbols4[i] = DNACompressedSymbol::NumberToIupac(i);
+    }
+  }
+};
+
+static const EncodingTables& tables() {
+  static EncodingTables t;
+  return t;
+}
+
+// Position of the least significant bit set
+static size_t lowestBit(uint64_t x) {
+#ifdef __GNUC__
+  return __builtin_ctzll(x);
+#else
+  size_t i = 0;
+  while (!(x & 1)) {
+    x >>= 1;
+    ++i;
+  }
+  return i;
+#endif
+}
+
+// The scalar kernels start from base 'begin' (multiple of the bases
+// per byte) so that they can complete the work of the vector ones
+
+static void encode2BitsScalar(const char* bases, size_t begin, size_t n, uint8_t* packed,
+			      uint64_t* ambiguous) {
+  const EncodingTables& t = tables();
+  for (size_t i = begin; i < n; ++i) {
+    uint8_t c = (uint8_t)bases[i];
+    if ((i & 0x03) == 0) {
+      packed[i >> 2] = 0;
+    }
+    packed[i >> 2] |= t.code2[c] << (2 * (3 - (i & 0x03)));
+    if (ambiguous != NULL && t.ambiguous2[c]) {
+      ambiguous[i >> 6] |= (uint64_t)1 << (i & 63);
+    }
+  }
+}
+
+static void decode2BitsScalar(const uint8_t* packed, size_t begin, size_t n, char* bases) {
+  const EncodingTables& t = tables();
+  for (size_t i = begin; i < n; ++i) {
+    bases[i] = t.symbols2[(packed[i >> 2] >> (2 * (3 - (i & 0x03)))) & 0x03];
+  }
+}
+
+static void encode4BitsScalar(const char* bases, size_t begin, size_t n, uint8_t* packed) {
+  const EncodingTables& t = tables();
+  for (size_t i = begin; i < n; ++i) {
+    uint8_t code = t.code4[(uint8_t)bases[i]];
+    if ((i & 0x01) == 0) {
+      packed[i >> 1] = code << 4;
+    } else {
+      packed[i >> 1] |= code;
+    }
+  }
+}
+
+static void decode4BitsScalar(const uint8_t* packed, size_t begin, size_t n, char* bases) {
+  const EncodingTables& t = tables();
+  for (size_t i = begin; i < n; ++i) {
+    bases[i] = t.symbols4[(packed[i >> 1] >> (4 * (1 - (i & 0x01)))) & 0x0F];
+  }
+}
+
+#ifdef BASE_ENCODER_X86
+
+// 2 bits codes of A, C, G and T indexed by the low nibble of the
+// character (the same for upper and lower case)
+#define CODE2_BY_NIBBLE 0, 0, 0, 1, 3, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0
+// 4 bits codes of the (upper case) characters 0x40-0x4F and 0x50-0x5F
+#define CODE4_BY_NIBBLE_4X 0, 1, 14, 2, 13, 0, 0, 4, 11, 0, 0, 12, 0, 3, 15, 0
+#define CODE4_BY_NIBBLE_5X 0, 0, 5, 6, 8, 0, 7, 9, 0, 10, 0, 0, 0, 0, 0, 0
+#define SYMBOLS4 '-', 'A', 'C', 'M', 'G', 'R', 'S', 'V', 'T', 'W', 'Y', 'H', 'K', 'D', 'B', 'N'
+#define SYMBOLS2 'A', 'C', 'G', 'T', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+
+// ---------------------------- SSE4.1 ---------------------------------
+
+__attribute__((target("sse4.1")))
+static size_t encode2BitsSSE(const char* bases, size_t n, uint8_t* packed, uint64_t* ambiguous) {
+  const __m128i codes = _mm_setr_epi8(CODE2_BY_NIBBLE);
+  const __m128i upper = _mm_set1_epi8((char)0xDF);
+  const __m128i low = _mm_set1_epi8(0x0F);
+  const __m128i a = _mm_set1_epi8('A'), c = _mm_set1_epi8('C');
+  const __m128i g = _mm_set1_epi8('G'), t = _mm_set1_epi8('T');
+  // b0*4 + b1 (16 bits), then (b0*4 + b1)*16 + b2*4 + b3 (32 bits)
+  const __m128i pairWeights = _mm_setr_epi8(4, 1, 4, 1, 4, 1, 4, 1, 4, 1, 4, 1, 4, 1, 4, 1);
+  const __m128i quadWeights = _mm_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1);
+  const __m128i gather = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+				       -1, -1, -1, -1, -1, -1, -1, -1);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(bases + i));
+    __m128i u = _mm_and_si128(x, upper);
+    __m128i valid = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(u, a), _mm_cmpeq_epi8(u, c)),
+				 _mm_or_si128(_mm_cmpeq_epi8(u, g), _mm_cmpeq_epi8(u, t)));
+    __m128i code = _mm_and_si128(_mm_shuffle_epi8(codes, _mm_and_si128(x, low)), valid);
+    __m128i quads = _mm_madd_epi16(_mm_maddubs_epi16(code, pairWeights), quadWeights);
+    uint32_t out = (uint32_t)_mm_cvtsi128_si32(_mm_shuffle_epi8(quads, gather));
+    memcpy(packed + i / 4, &out, sizeof(out));
+    if (ambiguous != NULL) {
+      uint64_t flags = (~(uint32_t)_mm_movemask_epi8(valid)) & 0xFFFF;
+      ambiguous[i >> 6] |= flags << (i & 63);
+    }
+  }
+  return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t decode2BitsSSE(const uint8_t* packed, size_t n, char* bases) {
+  const __m128i symbols = _mm_setr_epi8(SYMBOLS2);
+  const __m128i spread = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+  const __m128i two = _mm_set1_epi8(0x03);
+  // lanes taking the code shifted by 6, 4, 2 and 0 bits
+  const __m128i first = _mm_set1_epi32(0x000000FF);
+  const __m128i second = _mm_set1_epi32(0x0000FF00);
+  const __m128i third = _mm_set1_epi32(0x00FF0000);
+  const __m128i fourth = _mm_set1_epi32((int)0xFF000000);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint32_t in;
+    memcpy(&in, packed + i / 4, sizeof(in));
+    __m128i x = _mm_shuffle_epi8(_mm_cvtsi32_si128((int)in), spread);
+    __m128i code = _mm_or_si128(
+      _mm_or_si128(_mm_and_si128(_mm_srli_epi16(x, 6), first),
+		   _mm_and_si128(_mm_srli_epi16(x, 4), second)),
+      _mm_or_si128(_mm_and_si128(_mm_srli_epi16(x, 2), third),
+		   _mm_and_si128(x, fourth)));
+    code = _mm_and_si128(code, two);
+    _mm_storeu_si128((__m128i*)(bases + i), _mm_shuffle_epi8(symbols, code));
+  }
+  return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t encode4BitsSSE(const char* bases, size_t n, uint8_t* packed) {
+  const __m128i codes4x = _mm_setr_epi8(CODE4_BY_NIBBLE_4X);
+  const __m128i codes5x = _mm_setr_epi8(CODE4_BY_NIBBLE_5X);
+  const __m128i upper = _mm_set1_epi8((char)0xDF);
+  const __m128i low = _mm_set1_epi8(0x0F);
+  const __m128i high = _mm_set1_epi8((char)0xF0);
+  const __m128i row4x = _mm_set1_epi8(0x40), row5x = _mm_set1_epi8(0x50);
+  const __m128i pairWeights = _mm_setr_epi8(16, 1, 16, 1, 16, 1, 16, 1,
+					    16, 1, 16, 1, 16, 1, 16, 1);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_and_si128(_mm_loadu_si128((const __m128i*)(bases + i)), upper);
+    __m128i nibble = _mm_and_si128(x, low);
+    __m128i row = _mm_and_si128(x, high);
+    __m128i code = _mm_or_si128(
+      _mm_and_si128(_mm_shuffle_epi8(codes4x, nibble), _mm_cmpeq_epi8(row, row4x)),
+      _mm_and_si128(_mm_shuffle_epi8(codes5x, nibble), _mm_cmpeq_epi8(row, row5x)));
+    __m128i pairs = _mm_maddubs_epi16(code, pairWeights);
+    _mm_storel_epi64((__m128i*)(packed + i / 2), _mm_packus_epi16(pairs, pairs));
+  }
+  return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t decode4BitsSSE(const uint8_t* packed, size_t n, char* bases) {
+  const __m128i symbols = _mm_setr_epi8(SYMBOLS4);
+  const __m128i low = _mm_set1_epi8(0x0F);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadl_epi64((const __m128i*)(packed + i / 2));
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), low);
+    __m128i lo = _mm_and_si128(x, low);
+    // the high nibble holds the first base of each byte
+    __m128i code = _mm_unpacklo_epi8(hi, lo);
+    _mm_storeu_si128((__m128i*)(bases + i), _mm_shuffle_epi8(symbols, code));
+  }
+  return i;
+}
+
+// ----------------------------- AVX2 ----------------------------------
+
+__attribute__((target("avx2")))
+static size_t encode2BitsAVX2(const char* bases, size_t n, uint8_t* packed, uint64_t* ambiguous) {
+  const __m256i codes = _mm256_setr_epi8(CODE2_BY_NIBBLE, CODE2_BY_NIBBLE);
+  const __m256i upper = _mm256_set1_epi8((char)0xDF);
+  const __m256i low = _mm256_set1_epi8(0x0F);
+  const __m256i a = _mm256_set1_epi8('A'), c = _mm256_set1_epi8('C');
+  const __m256i g = _mm256_set1_epi8('G'), t = _mm256_set1_epi8('T');
+  const __m256i pairWeights = _mm256_set1_epi16(0x0104);
+  const __m256i quadWeights = _mm256_set1_epi32(0x00010010);
+  const __m256i gather = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+					  -1, -1, -1, -1, -1, -1, -1, -1,
+					  0, 4, 8, 12, -1, -1, -1, -1,
+					  -1, -1, -1, -1, -1, -1, -1, -1);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(bases + i));
+    __m256i u = _mm256_and_si256(x, upper);
+    __m256i valid = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(u, a), _mm256_cmpeq_epi8(u, c)),
+      _mm256_or_si256(_mm256_cmpeq_epi8(u, g), _mm256_cmpeq_epi8(u, t)));
+    __m256i code = _mm256_and_si256(_mm256_shuffle_epi8(codes, _mm256_and_si256(x, low)), valid);
+    __m256i quads = _mm256_madd_epi16(_mm256_maddubs_epi16(code, pairWeights), quadWeights);
+    __m256i bytes = _mm256_shuffle_epi8(quads, gather);
+    // four bytes from each 128 bits lane
+    uint32_t out[2];
+    out[0] = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(bytes));
+    out[1] = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+    memcpy(packed + i / 4, out, sizeof(out));
+    if (ambiguous != NULL) {
+      uint64_t flags = ~(uint32_t)_mm256_movemask_epi8(valid);
+      ambiguous[i >> 6] |= (flags & 0xFFFFFFFF) << (i & 63);
+    }
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t decode2BitsAVX2(const uint8_t* packed, size_t n, char* bases) {
+  const __m256i symbols = _mm256_setr_epi8(SYMBOLS2, SYMBOLS2);
+  // every lane holds the 8 input bytes, the first lane expands bytes
+  // 0-3 and the second bytes 4-7
+  const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+					  4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+  const __m256i two = _mm256_set1_epi8(0x03);
+  const __m256i first = _mm256_set1_epi32(0x000000FF);
+  const __m256i second = _mm256_set1_epi32(0x0000FF00);
+  const __m256i third = _mm256_set1_epi32(0x00FF0000);
+  const __m256i fourth = _mm256_set1_epi32((int)0xFF000000);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    int64_t in;
+    memcpy(&in, packed + i / 4, sizeof(in));
+    __m256i x = _mm256_shuffle_epi8(_mm256_set1_epi64x(in), spread);
+    __m256i code = _mm256_or_si256(
+      _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(x, 6), first),
+		      _mm256_and_si256(_mm256_srli_epi16(x, 4), second)),
+      _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(x, 2), third),
+		      _mm256_and_si256(x, fourth)));
+    code = _mm256_and_si256(code, two);
+    _mm256_storeu_si256((__m256i*)(bases + i), _mm256_shuffle_epi8(symbols, code));
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t encode4BitsAVX2(const char* bases, size_t n, uint8_t* packed) {
+  const __m256i codes4x = _mm256_setr_epi8(CODE4_BY_NIBBLE_4X, CODE4_BY_NIBBLE_4X);
+  const __m256i codes5x = _mm256_setr_epi8(CODE4_BY_NIBBLE_5X, CODE4_BY_NIBBLE_5X);
+  const __m256i upper = _mm256_set1_epi8((char)0xDF);
+  const __m256i low = _mm256_set1_epi8(0x0F);
+  const __m256i high = _mm256_set1_epi8((char)0xF0);
+  const __m256i row4x = _mm256_set1_epi8(0x40), row5x = _mm256_set1_epi8(0x50);
+  const __m256i pairWeights = _mm256_set1_epi16(0x0110);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i x = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(bases + i)), upper);
+    __m256i nibble = _mm256_and_si256(x, low);
+    __m256i row = _mm256_and_si256(x, high);
+    __m256i code = _mm256_or_si256(
+      _mm256_and_si256(_mm256_shuffle_epi8(codes4x, nibble), _mm256_cmpeq_epi8(row, row4x)),
+      _mm256_and_si256(_mm256_shuffle_epi8(codes5x, nibble), _mm256_cmpeq_epi8(row, row5x)));
+    __m256i pairs = _mm256_maddubs_epi16(code, pairWeights);
+    // packing works within lanes, the two low quadwords are joined
+    __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs, pairs), 0xD8);
+    _mm_storeu_si128((__m128i*)(packed + i / 2), _mm256_castsi256_si128(bytes));
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t decode4BitsAVX2(const uint8_t* packed, size_t n, char* bases) {
+  const __m256i symbols = _mm256_setr_epi8(SYMBOLS4, SYMBOLS4);
+  const __m128i low = _mm_set1_epi8(0x0F);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(packed + i / 2));
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), low);
+    __m128i lo = _mm_and_si128(x, low);
+    __m256i code = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(hi, lo)),
+					   _mm_unpackhi_epi8(hi, lo), 1);
+    _mm256_storeu_si256((__m256i*)(bases + i), _mm256_shuffle_epi8(symbols, code));
+  }
+  return i;
+}
+
+#endif
+
+/********************* STATIC METHODS ***********************/
+
+void BaseEncoder::encode2Bits(const char* bases, size_t n, uint8_t* packed,
+			      uint64_t* ambiguous) {
+  if (ambiguous != NULL) {
+    memset(ambiguous, 0, ((n + 63) / 64) * sizeof(uint64_t));
+  }
+  size_t done = 0;
+#ifdef BASE_ENCODER_X86
+  if (simdLevel() >= AVX2) {
+    done = encode2BitsAVX2(bases, n, packed, ambiguous);
+  } else if (simdLevel() >= SSE41) {
+    done = encode2BitsSSE(bases, n, packed, ambiguous);
+  }
+#endif
+  encode2BitsScalar(bases, done, n, packed, ambiguous);
+}
+
+void BaseEncoder::decode2Bits(const uint8_t* packed, size_t n, char* bases,
+			      const uint64_t* ambiguous) {
+  size_t done = 0;
+#ifdef BASE_ENCODER_X86
+  if (simdLevel() >= AVX2) {
+    done = decode2BitsAVX2(packed, n, bases);
+  } else if (simdLevel() >= SSE41) {
+    done = decode2BitsSSE(packed, n, bases);
+  }
+#endif
+  decode2BitsScalar(packed, done, n, bases);
+  if (ambiguous != NULL) {
+    for (size_t w = 0; w < (n + 63) / 64; ++w) {
+      uint64_t flags = ambiguous[w];
+      // flags past the last base (if any) are ignored
+      if (64 * w + 64 > n) {
+	flags &= ((uint64_t)1 << (n % 64)) - 1;
+      }
+      for (; flags != 0; flags &= flags - 1) {
+	bases[64 * w + lowestBit(flags)] = 'N';
+      }
+    }
+  }
+}
+
+void BaseEncoder::encode4Bits(const char* bases, size_t n, uint8_t* packed) {
+  size_t done = 0;
+#ifdef BASE_ENCODER_X86
+  if (simdLevel() >= AVX2) {
+    done = encode4BitsAVX2(bases, n, packed);
+  } else if (simdLevel() >= SSE41) {
+    done = encode4BitsSSE(bases, n, packed);
+  }
+#endif
+  encode4BitsScalar(bases, done, n, packed);
+}
+
+void BaseEncoder::decode4Bits(const uint8_t* packed, size_t n, char* bases) {
+  size_t done = 0;
+#ifdef BASE_ENCODER_X86
+  if (simdLevel() >= AVX2) {
+    done = decode4BitsAVX2(packed, n, bases);
+  } else if (simdLevel() >= SSE41) {
+    done = decode4BitsSSE(packed, n, bases);
+  }
+#endif
+  decode4BitsScalar(packed, done, n, bases);
+}
+
+std::string BaseEncoder::getInstructionSet() {
+  switch (simdLevel()) {
+  case AVX2:
+    return "avx2";
+  case SSE41:
+    return "sse4.1";
+  default:
+    return "scalar";
+  }
+}
+
+/************************************************************/
@@ -0,0 +1,89 @@
+#include <core/CompressedReadRange.h>
+#include <core/DNACompressedSymbol.h>
+
+#include <algorithm>
+
+/*********************** CONSTRUCTORS ***********************/
+
+CompressedReadRange::CompressedReadRange(const CompressedReadSet& set, size_t first, size_t count)
+  : set(&set)
+{
+  this->first = std::min(first, set.getReadCount());
+  this->count = std::min(count, set.getReadCount() - this->first);
+}
+
+/********************** QUERY METHODS ***********************/
+
+const CompressedReadSet& CompressedReadRange::getSet() const {
+  return *this->set;
+}
+
+size_t CompressedReadRange::getFirst() const {
+  return this->first;
+}
+
+size_t CompressedReadRange::size() const {
+  return this->count;
+}
+
+bool CompressedReadRange::empty() const {
+  return this->count == 0;
+}
+
+CompressedReadRange CompressedReadRange::subRange(size_t first, size_t count) const {
+  first = std::min(first, this->count);
+  return CompressedReadRange(*this->set, this->first + first,
+			     std::min(count, this->count - first));
+}
+
+std::vector< CompressedReadRange > CompressedReadRange::split(size_t parts) const {
+  std::vector< CompressedReadRange > ranges;
+  parts = std::max((size_t)1, std::min(parts, this->count));
+  size_t begin = 0;
+  for (size_t p = 0; p < parts; ++p) {
+    // the first (count % parts) ranges get one more read
+    size_t n = this->count / parts + ((p < this->count % parts) ? 1 : 0);
+    ranges.push_back(subRange(begin, n));
+    begin += n;
+  }
+  return ranges;
+}
+
+void CompressedReadRange::decode(size_t i, char* bases) const {
+  size_t length = this->set->getReadLength();
+  // symbols are unpacked in place and then translated
+  unpack(i, (uint8_t*)bases);
+  for (size_t j = 0; j < length; ++j) {
+    bases[j] = DNACompressedSymbol::NumberToIupac((uint8_t)bases[j]);
+  }
+}
+
+void CompressedReadRange::unpack(size_t i, uint8_t* symbols) const {
+  size_t length = this->set->getReadLength();
+  this->set->unpack((this->first + i) * length, length, symbols);
+}
+
+/******************** READ ITERATOR *************************/
+
+CompressedReadIterator::CompressedReadIterator(const CompressedReadRange& range, char* buffer)
+  : range(range), buffer(buffer), position(0)
+{
+}
+
+bool CompressedReadIterator::next() {
+  if (this->position >= this->range.size()) {
+    return false;
+  }
+  this->range.decode(this->position++, this->buffer);
+  return true;
+}
+
+size_t CompressedReadIterator::getIndex() const {
+  return this->range.getFirst() + this->position - 1;
+}
+
+lbio::char_span CompressedReadIterator::getBases() const {
+  return lbio::char_span(this->buffer, this->range.getSet().getReadLength());
+}
+
+/************************************************************/
@@ -1,12 +1,45 @@
 #include <core/CompressedReadSet.h>
+#include <core/CompressedReadRange.h>
+#include <core/BaseEncoder.hpp>
 
 #include <math.h>
 #include <string.h>
 
 #include <iostream>
 #include <fstream>
+#include <utility>
 using namespace std;
 
+/******************** SUPPORT FUNCTIONS *********************/
+
+static const char FormatMagic[] = "LBIORSET";
+// a block holds (about) 1MB of sequence
+static const uint64_t BlockBits = 8 * (1 << 20);
+
+// FNV-1a like checksum, one word at a time
+static uint64_t blockChecksum(const uint64_t* words, size_t count) {
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < count; ++i) {
+    h = (h ^ words[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+// Computes the words of each block of reads, checksums included
+static vector< CompressedReadSetBlock > buildBlocks(const uint64_t* words, uint64_t readCount,
+						    uint64_t readBits, uint64_t blockReads) {
+  vector< CompressedReadSetBlock > blocks;
+  for (uint64_t first = 0; first < readCount; first += blockReads) {
+    uint64_t last = min(readCount, first + blockReads);
+    CompressedReadSetBlock block;
+    block.firstWord = (first * readBits) / 64;
+    block.wordCount = (last * readBits + 63) / 64 - block.firstWord;
+    block.checksum = blockChecksum(words + block.firstWord, block.wordCount);
+    blocks.push_back(block);
+  }
+  return blocks;
+}
+
 /***************** STATIC INITIALIZATIONS *******************/
 
 int CompressedReadSet::BaseBitLength = 4;
@@ -15,7 +48,8 @@ int CompressedReadSet::DefaultReadSize = 48;
 
 /********************** CONSTRUCTORS ************************/
 
-CompressedReadSet::CompressedReadSet() {
+CompressedReadSet::CompressedReadSet()
+  : blocks(0), blockCount(0), blockReads(0) {
   this->readCount = 0;
   this->readLength = CompressedReadSet::DefaultReadSize;
   this->elSize = CompressedReadSet::BaseBitLength;
@@ -23,7 +57,8 @@ CompressedReadSet::CompressedReadSet() {
   init();
 }
 
-CompressedReadSet::CompressedReadSet(size_t readSize) {
+CompressedReadSet::CompressedReadSet(size_t readSize)
+  : blocks(0), blockCount(0), blockReads(0) {
  this->readCount = 0;
   this->readLength = readSize;
   this->elSize = CompressedReadSet::BaseBitLength;
@@ -31,54 +66,54 @@ CompressedReadSet::CompressedReadSet(size_t readSize) {
   init();
 }
 
-CompressedReadSet::CompressedReadSet(const Read* reads, size_t n) {
-  this->readCount = n;
-  if (this->readCount > 0) {
-    this->elSize = CompressedReadSet::BaseBitLength;
+CompressedReadSet::CompressedReadSet(const Read* reads, size_t n)
+  : blocks(0), blockCount(0), blockReads(0) {
+  this->readCount = 0;
+  this->readLength = CompressedReadSet::DefaultReadSize;
+  this->elSize = CompressedReadSet::BaseBitLength;
+  this->n = 0;
+  if (n > 0) {
     size_t m = (size_t) ceil( 8.0 / ((double)elSize) );
     this->readLength = (size_t) m * ceil((double)reads[0].length() / (double)m);
-    this->n = this->readCount * this->readLength;
-    init();
-    memset(this->seq, 0, realSize);
-    size_t k = 0;
-    for (size_t i = 0; i < this->readCount; i++) {
-      for (size_t j = 0; j < this->readLength; j++) {
-	this->setElementAt(k++, DNACompressedSymbol::IupacToNumber(reads[i].getBases()[j]));
-      }
-    }
   }
+  init();
+  append(reads, n);
 }
 
-CompressedReadSet::CompressedReadSet(const vector<Read>& reads) {
-  this->readCount = reads.size();
-  if (this->readCount > 0) {
-    this->elSize = CompressedReadSet::BaseBitLength;
-    size_t m = (size_t) ceil( 8.0 / ((double)elSize) );
-    this->readLength = (size_t) m * ceil((double)reads[0].length() / (double)m);
-    this->n = this->readCount * this->readLength;
-    init();
-    memset(this->seq, 0, realSize);
-    // here copy content of 'reads' in sequence
-    size_t k = 0;
-    for (size_t i = 0; i < this->readCount; i++) {
-      for (size_t j = 0; j < this->readLength; j++) {
-	this->setElementAt(k++, DNACompressedSymbol::IupacToNumber(reads[i].getBases()[j]));
-      }
-    }
-  }
+CompressedReadSet::CompressedReadSet(const vector<Read>& reads)
+  : CompressedReadSet(reads.data(), reads.size()) {
 }
 
 CompressedReadSet::CompressedReadSet(const CompressedReadSet& other) 
-  : CompressedSequence(other) {
+  : CompressedSequence(other), blocks(0), blockCount(0), blockReads(0) {
   this->readCount = other.readCount;
   this->readLength = other.readLength;
 }
 
 CompressedReadSet::~CompressedReadSet() {
-  if (this->seq) {
+  // the mapped sequence is released by the mapping itself
+  if (this->seq && !isMapped()) {
     delete[] this->seq;
-    this->seq = 0;
   }
+  this->seq = 0;
+}
+
+/************************ OPERATORS *************************/
+
+CompressedReadSet& CompressedReadSet::operator=(const CompressedReadSet& other) {
+  if (this != &other) {
+    if (isMapped()) {
+      this->seq = 0;
+      this->realSize = this->capacity = 0;
+    }
+    CompressedSequence::operator=(other);
+    this->mapping.close();
+    this->blocks = 0;
+    this->blockCount = this->blockReads = 0;
+    this->readCount = other.readCount;
+    this->readLength = other.readLength;
+  }
+  return *this;
 }
 
 /******************* GET AND SET METHODS ********************/
@@ -87,6 +122,14 @@ size_t CompressedReadSet::getReadCount() const {
   return this->readCount;
 }
 
+size_t CompressedReadSet::getReadLength() const {
+  return this->readLength;
+}
+
+CompressedReadRange CompressedReadSet::getRange(size_t start, size_t count) const {
+  return CompressedReadRange(*this, start, count);
+}
+
 uint8_t* CompressedReadSet::getReads(size_t start, size_t count) const {
   if ( start >= this->readCount ) {
     return 0;
@@ -97,69 +140,236 @@ uint8_t* CompressedReadSet::getReads(size_t start, size_t count) const {
   size_t N = count * readRealSize;
   retSeq = new uint8_t[N];
   memset(retSeq, 0, N * sizeof(uint8_t));
-  memcpy(retSeq, &(this->seq[readRealSize*start]), m * readRealSize * sizeof(uint8_t));
+  getPackedBytes(readRealSize * start, m * readRealSize, retSeq);
   return retSeq;
 }
 
 /********************* MODIFY METHODS ***********************/
 
 CompressedReadSet& CompressedReadSet::append(const Read& read) {
-  // adjust sequence size and read count
-  this->readCount++;
-  this->n += this->readLength;
-  this->resize(this->n);
-  int k = readLength * ( readCount - 1 );
-  for (size_t j = 0; j < this->readLength; ++j) {
-    this->setElementAt(k++, DNACompressedSymbol::IupacToNumber(read.getBases()[j]));
+  return append(&read, 1);
+}
+
+CompressedReadSet& CompressedReadSet::append(const vector<Read>& reads) {
+  if (reads.empty()) {
+    return *this;
+  }
+  return append(reads.data(), reads.size());
+}
+
+CompressedReadSet& CompressedReadSet::append(const Read* reads, size_t count) {
+  detach();
+  size_t k = this->readLength * this->readCount;
+  this->readCount += count;
+  // new elements are zero, reads shorter than readLength are padded
+  this->resize(this->readLength * this->readCount);
+  vector<uint8_t> buffer;
+  for (size_t i = 0; i < count; ++i) {
+    encodeRead(reads[i], k, buffer);
+    k += this->readLength;
   }
   return *this;
 }
 
-CompressedReadSet& CompressedReadSet::append(const vector<Read>& reads) {
-  size_t oldReadCount = this->readCount;
-  this->readCount+= reads.size();
-  this->n = this->readLength * this->readCount;
-  this->resize(this->n);
-  
-  int k = readLength * oldReadCount;
-  for (size_t i = 0; i < reads.size(); i++ ) {
-    for (size_t j = 0; j < this->readLength; ++j) {
-      this->setElementAt(k++, DNACompressedSymbol::IupacToNumber(reads[i].getBases()[j]));
+void CompressedReadSet::reserve(size_t readCount) {
+  detach();
+  CompressedSequence::reserve(readCount * this->readLength);
+}
+
+void CompressedReadSet::encodeRead(const Read& read, size_t position, vector<uint8_t>& buffer) {
+  const string& bases = read.getBases();
+  size_t length = min(bases.size(), this->readLength);
+  if (this->elSize == 4 && position % 2 == 0) {
+    // the read starts on a byte boundary: bases are encoded in bulk
+    buffer.resize((length + 1) / 2);
+    BaseEncoder::encode4Bits(bases.data(), length, buffer.data());
+    setPackedBytes(position / 2, length / 2, buffer.data());
+    if (length % 2 == 1) {
+      setElementAt(position + length - 1, buffer.back() >> 4);
+    }
+  } else {
+    for (size_t j = 0; j < length; ++j) {
+      setElementAt(position + j, DNACompressedSymbol::IupacToNumber(bases[j]));
     }
   }
-  return *this;
 }
 
 /*********************** I/O METHODS ************************/
 
 void CompressedReadSet::writeToFile(const string& fileName) const {
   ofstream ofs(fileName,ofstream::binary | ofstream::out);
-  // write the real size of the array and size of an element
-  ofs.write((char*)&(this->realSize), sizeof(size_t));
-  ofs.write((char*)&(this->elSize), sizeof(size_t));
-  ofs.write((char*)&(this->readCount), sizeof(size_t));
-  ofs.write((char*)&(this->readLength), sizeof(size_t));
-  // write the data
-  ofs.write( (char*)this->seq, sizeof(uint8_t) * realSize );
+  CompressedReadSetHeader header;
+  memset(&header, 0, sizeof(header));
+  header.preamble.set(FormatMagic, CompressedReadSet::FormatVersion);
+  header.elementSize = this->elSize;
+  header.readCount = this->readCount;
+  header.readLength = this->readLength;
+  header.wordCount = getWordCount();
+  header.dataOffset = lbio::page_align(sizeof(header));
+  uint64_t readBits = this->readLength * this->elSize;
+  header.blockReads = max((uint64_t)1, BlockBits / max((uint64_t)1, readBits));
+  vector< CompressedReadSetBlock > index =
+    buildBlocks(this->seq, this->readCount, readBits, header.blockReads);
+  header.blockCount = index.size();
+  header.indexOffset = header.dataOffset + header.wordCount * sizeof(uint64_t);
+  // write the header padded to the first page
+  ofs.write((char*)&header, sizeof(header));
+  lbio::write_padding(ofs, sizeof(header), header.dataOffset);
+  // write the data (as in memory) and the block index
+  ofs.write((char*)this->seq, header.wordCount * sizeof(uint64_t));
+  ofs.write((char*)index.data(), index.size() * sizeof(CompressedReadSetBlock));
 }
 
-CompressedReadSet& CompressedReadSet::loadFromFile(const string& fileName) {
+bool CompressedReadSet::loadFromFile(const string& fileName) {
+  // release current content, the set is left empty on errors
+  *this = CompressedReadSet(this->readLength);
   ifstream ifs(fileName, ofstream::binary | ofstream::in);
-  // delete old sequence (if any)
-  if (this->seq) {
-    delete[] seq;
-    seq = 0;
-  }
-  // load size information
-  ifs.read((char*)&this->realSize, sizeof(size_t));
-  ifs.read((char*)&this->elSize, sizeof(size_t));
-  ifs.read((char*)&this->readCount, sizeof(size_t));
-  ifs.read((char*)&this->readLength, sizeof(size_t));
+  if (!ifs) {
+    cerr << "[ERROR] - Unable to open " << fileName << endl;
+    return false;
+  }
+  CompressedReadSetHeader header;
+  memset(&header, 0, sizeof(header));
+  ifs.read((char*)&header, sizeof(header));
+  if (!header.preamble.has_magic(FormatMagic)) {
+    // files without header start with the size information
+    size_t info[4] = { 0, 0, 0, 0 };
+    ifs.clear();
+    ifs.seekg(0);
+    ifs.read((char*)info, sizeof(info));
+    if (!ifs || (info[1] != 1 && info[1] != 2 && info[1] != 4 && info[1] != 8) ||
+	info[0] != (info[2] * info[3] * info[1] + 7) / 8) {
+      cerr << "[ERROR] - " << fileName << " is not a read set file" << endl;
+      return false;
+    }
+    this->elSize = info[1];
+    this->readCount = info[2];
+    this->readLength = info[3];
+    this->n = this->readCount * this->readLength;
+    delete[] this->seq;
+    init();
+    // load data
+    readPacked(ifs, info[0]);
+    if (!ifs) {
+      cerr << "[ERROR] - " << fileName << " is truncated" << endl;
+      *this = CompressedReadSet(this->readLength);
+      return false;
+    }
+    return true;
+  }
+  uint64_t words = (header.readCount * header.readLength * header.elementSize + 63) / 64;
+  if (!header.preamble.matches(FormatMagic, CompressedReadSet::FormatVersion)) {
+    cerr << "[ERROR] - Unsupported version or byte order of " << fileName << endl;
+    return false;
+  }
+  if ((header.elementSize != 1 && header.elementSize != 2 &&
+       header.elementSize != 4 && header.elementSize != 8) || header.wordCount != words) {
+    cerr << "[ERROR] - " << fileName << " is not a valid read set file" << endl;
+    return false;
+  }
+  this->elSize = header.elementSize;
+  this->readCount = header.readCount;
+  this->readLength = header.readLength;
   this->n = this->readCount * this->readLength;
+  delete[] this->seq;
   init();
-  // load data
-  ifs.read((char*)this->seq, this->realSize);
-  return *this;
+  memset(this->seq, 0, this->realSize);
+  ifs.seekg(header.dataOffset);
+  ifs.read((char*)this->seq, header.wordCount * sizeof(uint64_t));
+  vector< CompressedReadSetBlock > index(header.blockCount);
+  ifs.seekg(header.indexOffset);
+  ifs.read((char*)index.data(), index.size() * sizeof(CompressedReadSetBlock));
+  if (!ifs) {
+    cerr << "[ERROR] - " << fileName << " is truncated" << endl;
+    *this = CompressedReadSet(this->readLength);
+    return false;
+  }
+  for (size_t b = 0; b < index.size(); ++b) {
+    if (index[b].firstWord + index[b].wordCount > getWordCount() ||
+	blockChecksum(this->seq + index[b].firstWord, index[b].wordCount) != index[b].checksum) {
+      cerr << "[ERROR] - Block " << b << " of " << fileName << " is corrupted" << endl;
+      *this = CompressedReadSet(this->readLength);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CompressedReadSet::mapFile(const string& fileName) {
+  // release current content, the set is left empty on errors
+  *this = CompressedReadSet(this->readLength);
+  lbio::mapped_file file;
+  if (!file.open(fileName, lbio::mapped_file::random)) {
+    cerr << "[ERROR] - Unable to map " << fileName << endl;
+    return false;
+  }
+  CompressedReadSetHeader header;
+  if (file.size() < sizeof(header)) {
+    cerr << "[ERROR] - " << fileName << " is not a read set file" << endl;
+    return false;
+  }
+  memcpy(&header, file.data(), sizeof(header));
+  uint64_t words = (header.readCount * header.readLength * header.elementSize + 63) / 64;
+  if (!header.preamble.matches(FormatMagic, CompressedReadSet::FormatVersion) ||
+      (header.elementSize != 1 && header.elementSize != 2 &&
+       header.elementSize != 4 && header.elementSize != 8) ||
+      header.wordCount != words || header.dataOffset % sizeof(uint64_t) != 0 ||
+      header.dataOffset + header.wordCount * sizeof(uint64_t) > file.size() ||
+      header.indexOffset % sizeof(uint64_t) != 0 ||
+      header.indexOffset + header.blockCount * sizeof(CompressedReadSetBlock) > file.size()) {
+    cerr << "[ERROR] - " << fileName << " is not a valid read set file" << endl;
+    return false;
+  }
+  // the sequence is used in place, it is never written while mapped
+  delete[] this->seq;
+  this->seq = (header.wordCount > 0) ?
+    (uint64_t*)(file.data() + header.dataOffset) : 0;
+  this->elSize = header.elementSize;
+  this->mask = 0xFF >> (8 - this->elSize);
+  this->readCount = header.readCount;
+  this->readLength = header.readLength;
+  this->n = this->readCount * this->readLength;
+  this->realSize = header.wordCount * sizeof(uint64_t);
+  this->capacity = header.wordCount;
+  this->blocks = (const CompressedReadSetBlock*)(file.data() + header.indexOffset);
+  this->blockCount = header.blockCount;
+  this->blockReads = header.blockReads;
+  this->mapping = std::move(file);
+  return true;
+}
+
+bool CompressedReadSet::isMapped() const {
+  return this->mapping.is_open();
+}
+
+bool CompressedReadSet::verifyReads(size_t start, size_t count) const {
+  if (!isMapped() || count == 0 || this->blockReads == 0) {
+    return true;
+  }
+  size_t last = min(this->readCount, start + count);
+  for (size_t b = start / this->blockReads; b < this->blockCount && b * this->blockReads < last; ++b) {
+    const CompressedReadSetBlock& block = this->blocks[b];
+    if (block.firstWord + block.wordCount > getWordCount() ||
+	blockChecksum(this->seq + block.firstWord, block.wordCount) != block.checksum) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/********************* UTILITY METHODS **********************/
+
+void CompressedReadSet::detach() {
+  if (!isMapped()) {
+    return;
+  }
+  uint64_t* copy = new uint64_t[max((size_t)1, getWordCount())];
+  memcpy(copy, this->seq, this->realSize);
+  this->seq = copy;
+  this->capacity = max((size_t)1, getWordCount());
+  this->mapping.close();
+  this->blocks = 0;
+  this->blockCount = this->blockReads = 0;
 }
 
 /************************************************************/
@@ -1,5 +1,6 @@
 #include <core/CompressedSequence.h>
 
+#include <bitset>
 #include <iostream>
 #include <fstream>
 using namespace std;
@@ -7,6 +8,28 @@ using namespace std;
 #include <math.h>
 #include <string.h>
 
+/******************** SUPPORT FUNCTIONS *********************/
+
+// Number of bits in a word of the internal sequence
+static const size_t WordBits = 64;
+
+// Number of words needed to store the given number of bits
+static size_t wordsForBits(size_t bits) {
+  return (bits + WordBits - 1) / WordBits;
+}
+
+// Number of differing elements in the xor of two words, each element
+// is folded on its least significant bit before counting
+static size_t countElements(uint64_t x, size_t elSize, uint8_t mask) {
+  for (size_t s = elSize / 2; s > 0; s /= 2) {
+    x |= x >> s;
+  }
+  // the least significant bit of every element (e.g. 0x5555... for
+  // 2 bits elements)
+  uint64_t low = ~(uint64_t)0 / mask;
+  return bitset<64>(x & low).count();
+}
+
 /**************** CONSTRUCTOR(S) DESTRUCTOR *****************/
 
 CompressedSequence::CompressedSequence() {
@@ -14,6 +37,7 @@ CompressedSequence::CompressedSequence() {
   this->elSize = 0;
   this->mask = 0;
   this->realSize = 0;
+  this->capacity = 0;
   this->seq = 0;
 }
 
@@ -24,12 +48,30 @@ CompressedSequence::CompressedSequence(size_t n, size_t elSize) {
   memset(this->seq, 0, this->realSize);
 }
 
+CompressedSequence::CompressedSequence(const uint8_t* raw, size_t n, size_t elSize) {
+  this->n = n;
+  this->elSize = elSize;
+  init();
+  size_t bytes = getPackedByteCount();
+  size_t words = getWordCount();
+  for (size_t w = 0; w < words; ++w) {
+    uint64_t word = 0;
+    for (size_t b = 0; b < 8; ++b) {
+      size_t k = 8 * w + b;
+      word = (word << 8) | ((k < bytes) ? raw[k] : 0);
+    }
+    this->seq[w] = word;
+  }
+  clearPadding();
+}
+
 CompressedSequence::CompressedSequence(const CompressedSequence& s) {
   this->n = s.n;
   this->elSize = s.elSize;
   this->mask = s.mask;
   this->realSize = s.realSize;
-  this->seq = new uint8_t[realSize];
+  this->capacity = getWordCount();
+  this->seq = new uint64_t[this->capacity];
   memcpy( this->seq, s.seq, this->realSize * sizeof(uint8_t));
 }
 
@@ -47,35 +89,245 @@ size_t CompressedSequence::getElementCount() const {
   return this->n;
 }
 
+// elements are stored starting from the most significant bits of
+// each word (i.e. the first element of a word is in its high bits)
 uint8_t CompressedSequence::getElementAt(size_t i) const {
-  return (seq[(i >> 1)] >> elSize*(1 - (i & 0x01))) & mask;
+  size_t perWord = WordBits / elSize;
+  size_t shift = elSize * (perWord - 1 - (i % perWord));
+  return (uint8_t)((seq[i / perWord] >> shift) & mask);
 }
 
 void CompressedSequence::setElementAt(size_t i, uint8_t e) {
-  seq[(i >> 1)] |=  (mask & e) << elSize*(1 - (i & 0x01));
+  size_t perWord = WordBits / elSize;
+  size_t shift = elSize * (perWord - 1 - (i % perWord));
+  uint64_t m = (uint64_t)mask << shift;
+  seq[i / perWord] = (seq[i / perWord] & ~m) | (((uint64_t)(mask & e)) << shift);
 }
 
-const uint8_t* CompressedSequence::getRawSequence() const {
+const uint64_t* CompressedSequence::getRawSequence() const {
   return this->seq;
 }
 
+size_t CompressedSequence::getWordCount() const {
+  return this->realSize / sizeof(uint64_t);
+}
+
+size_t CompressedSequence::getCapacity() const {
+  return (this->elSize > 0) ? this->capacity * (WordBits / this->elSize) : 0;
+}
+
+size_t CompressedSequence::getPackedByteCount() const {
+  return (this->n * this->elSize + 7) / 8;
+}
+
+void CompressedSequence::getPackedBytes(size_t first, size_t count, uint8_t* out) const {
+  size_t bytes = getPackedByteCount();
+  for (size_t k = 0; k < count; ++k) {
+    size_t b = first + k;
+    out[k] = (b < bytes) ? (uint8_t)(seq[b / 8] >> (8 * (7 - b % 8))) : 0;
+  }
+}
+
+void CompressedSequence::setPackedBytes(size_t first, size_t count, const uint8_t* bytes) {
+  size_t k = 0;
+  while (k < count) {
+    size_t b = first + k;
+    if (b % 8 == 0 && k + 8 <= count) {
+      // a whole word at once
+      uint64_t word = 0;
+      for (size_t j = 0; j < 8; ++j) {
+	word = (word << 8) | bytes[k + j];
+      }
+      seq[b / 8] = word;
+      k += 8;
+    } else {
+      size_t shift = 8 * (7 - b % 8);
+      seq[b / 8] = (seq[b / 8] & ~((uint64_t)0xFF << shift)) | ((uint64_t)bytes[k] << shift);
+      ++k;
+    }
+  }
+}
+
+uint64_t CompressedSequence::getWindow(size_t i, size_t k) const {
+  if (k == 0) {
+    return 0;
+  }
+  return loadBits(i * elSize) >> (WordBits - k * elSize);
+}
+
+void CompressedSequence::unpack(size_t begin, size_t count, uint8_t* out) const {
+  size_t perWord = WordBits / elSize;
+  size_t i = begin;
+  size_t end = begin + count;
+  while (i < end) {
+    // unpack what is left of the current word from a local copy
+    size_t offset = i % perWord;
+    size_t last = min(end, i - offset + perWord);
+    uint64_t word = seq[i / perWord] << (offset * elSize);
+    for (; i < last; ++i) {
+      *out++ = (uint8_t)(word >> (WordBits - elSize));
+      word <<= elSize;
+    }
+  }
+}
+
+CompressedSequence CompressedSequence::substring(size_t begin, size_t len) const {
+  begin = min(begin, this->n);
+  len = min(len, this->n - begin);
+  CompressedSequence sub(len, this->elSize);
+  size_t words = sub.getWordCount();
+  for (size_t w = 0; w < words; ++w) {
+    sub.seq[w] = loadBits(begin * elSize + w * WordBits);
+  }
+  sub.clearPadding();
+  return sub;
+}
+
+/********************* COMPARE METHODS **********************/
+
+int CompressedSequence::compare(const CompressedSequence& other) const {
+  // padding bits are zero, so words can be compared up to the
+  // shortest sequence and the length decides the ties
+  size_t words = min(getWordCount(), other.getWordCount());
+  for (size_t w = 0; w < words; ++w) {
+    if (seq[w] != other.seq[w]) {
+      size_t common = min(this->n, other.n);
+      if ((w + 1) * (WordBits / elSize) <= common) {
+	return (seq[w] < other.seq[w]) ? -1 : 1;
+      }
+      // the word contains the end of the shortest sequence
+      size_t bits = (common - w * (WordBits / elSize)) * elSize;
+      uint64_t a = (bits == 0) ? 0 : seq[w] >> (WordBits - bits);
+      uint64_t b = (bits == 0) ? 0 : other.seq[w] >> (WordBits - bits);
+      if (a != b) {
+	return (a < b) ? -1 : 1;
+      }
+      break;
+    }
+  }
+  if (this->n == other.n) {
+    return 0;
+  }
+  return (this->n < other.n) ? -1 : 1;
+}
+
+size_t CompressedSequence::hammingDistance(const CompressedSequence& other) const {
+  size_t common = min(this->n, other.n);
+  size_t bits = common * elSize;
+  size_t words = bits / WordBits;
+  size_t distance = 0;
+  for (size_t w = 0; w < words; ++w) {
+    distance += countElements(seq[w] ^ other.seq[w], elSize, mask);
+  }
+  size_t rest = bits % WordBits;
+  if (rest > 0) {
+    uint64_t x = (seq[words] ^ other.seq[words]) >> (WordBits - rest);
+    distance += countElements(x, elSize, mask);
+  }
+  return distance;
+}
+
 /********************* MODIFY METHODS ***********************/
 
 CompressedSequence& CompressedSequence::append(const CompressedSequence &other) {
-  // size_t new_n = (this->n + other.n);
-  size_t oldRealSize = this->realSize;
-  this->realSize += other.realSize;
-  this->n = this->n + other.n;
-  uint8_t* new_sequence = new uint8_t[realSize];
-  memcpy( new_sequence, this->seq, oldRealSize * sizeof(uint8_t));
-  memcpy( &new_sequence[oldRealSize], other.seq, other.realSize * sizeof(uint8_t));
-  delete[] seq;
-  this->seq = new_sequence;
+  if (&other == this) {
+    // the words of 'other' would be rewritten while they are read
+    CompressedSequence copy(other);
+    return append(copy);
+  }
+  size_t offset = this->n * this->elSize;
+  size_t otherWords = other.getWordCount();
+  resize(this->n + other.n);
+  size_t words = getWordCount();
+  // padding of both sequences is zero: words are or-ed in place
+  for (size_t w = 0; w < otherWords; ++w) {
+    size_t bit = offset + w * WordBits;
+    size_t shift = bit % WordBits;
+    seq[bit / WordBits] |= other.seq[w] >> shift;
+    if (shift > 0 && bit / WordBits + 1 < words) {
+      seq[bit / WordBits + 1] |= other.seq[w] << (WordBits - shift);
+    }
+  }
   return *this;
 }
 
+void CompressedSequence::reserve(size_t count) {
+  size_t words = wordsForBits(count * elSize);
+  if (words <= this->capacity) {
+    return;
+  }
+  uint64_t* temp = new uint64_t[words];
+  memcpy(temp, this->seq, this->realSize * sizeof(uint8_t));
+  memset(temp + getWordCount(), 0, (words - getWordCount()) * sizeof(uint64_t));
+  delete[] this->seq;
+  this->seq = temp;
+  this->capacity = words;
+}
+
+void CompressedSequence::pack(const uint8_t* values, size_t count, size_t begin) {
+  size_t perWord = WordBits / elSize;
+  size_t i = begin;
+  size_t end = begin + count;
+  while (i < end) {
+    size_t offset = i % perWord;
+    size_t last = min(end, i - offset + perWord);
+    size_t bits = (last - i) * elSize;
+    uint64_t word = 0;
+    for (; i < last; ++i) {
+      word = (word << elSize) | (*values++ & mask);
+    }
+    // place the new elements after the first 'offset' elements
+    size_t shift = WordBits - offset * elSize - bits;
+    uint64_t m = ((bits == WordBits) ? ~(uint64_t)0 : (((uint64_t)1 << bits) - 1)) << shift;
+    uint64_t& target = seq[(i - 1) / perWord];
+    target = (target & ~m) | (word << shift);
+  }
+}
+
+void CompressedSequence::pack(const char* symbols, size_t count, const uint8_t* code,
+			      size_t begin) {
+  uint8_t buffer[256];
+  size_t done = 0;
+  while (done < count) {
+    size_t m = min(count - done, sizeof(buffer));
+    for (size_t k = 0; k < m; ++k) {
+      buffer[k] = code[(uint8_t)symbols[done + k]];
+    }
+    pack(buffer, m, begin + done);
+    done += m;
+  }
+}
+
 /************************ OPERATORS *************************/
 
+CompressedSequence& CompressedSequence::operator=(const CompressedSequence& s) {
+  if (this != &s) {
+    uint64_t* copy = new uint64_t[s.getWordCount()];
+    memcpy(copy, s.seq, s.realSize * sizeof(uint8_t));
+    delete[] this->seq;
+    this->seq = copy;
+    this->n = s.n;
+    this->elSize = s.elSize;
+    this->mask = s.mask;
+    this->realSize = s.realSize;
+    this->capacity = s.getWordCount();
+  }
+  return *this;
+}
+
+bool CompressedSequence::operator==(const CompressedSequence& other) const {
+  return (this->n == other.n && this->elSize == other.elSize &&
+	  memcmp(this->seq, other.seq, this->realSize) == 0);
+}
+
+bool CompressedSequence::operator!=(const CompressedSequence& other) const {
+  return !(*this == other);
+}
+
+bool CompressedSequence::operator<(const CompressedSequence& other) const {
+  return compare(other) < 0;
+}
+
 // uint8_t CompressedSequence::operator[] (const size_t i) const {
 //   return getElementAt(i);
 // }
@@ -84,24 +336,31 @@ CompressedSequence& CompressedSequence::append(const CompressedSequence &other)
 
 void CompressedSequence::writeToFile(const string& fileName) const {
   ofstream ofs(fileName,ofstream::binary | ofstream::out);
-  // write the real size of the array and size of an element
-  ofs.write((char*)&(this->realSize), sizeof(size_t));
+  // write the number of elements and size of an element
+  ofs.write((char*)&(this->n), sizeof(size_t));
   ofs.write((char*)&(this->elSize), sizeof(size_t));
   // write the data
-  ofs.write( (char*)this->seq, sizeof(uint8_t) * realSize );
+  writePacked(ofs);
 }
 
 CompressedSequence& CompressedSequence::loadFromFile(const string& fileName) {
-  if (this->seq) {
-    delete[] seq;
-  }
   ifstream ifs(fileName, ofstream::in | ofstream::binary);
-  // read real size of the array and size of an element
-  ifs.read((char*)&(this->realSize), sizeof(size_t));
-  ifs.read((char*)&(this->elSize), sizeof(size_t));
+  // read the number of elements and size of an element
+  size_t count = 0;
+  size_t size = 0;
+  ifs.read((char*)&count, sizeof(size_t));
+  ifs.read((char*)&size, sizeof(size_t));
+  if (!ifs || (size != 1 && size != 2 && size != 4 && size != 8)) {
+    cerr << "[ERROR] - " << fileName << " is not a compressed sequence file" << endl;
+    count = 0;
+    size = this->elSize;
+  }
+  delete[] seq;
+  this->n = count;
+  this->elSize = size;
   init();
   // read the data
-  ifs.read((char*)(this->seq), sizeof(uint8_t)*(this->realSize));
+  readPacked(ifs, getPackedByteCount());
   return *this;
 }
 
@@ -131,18 +390,68 @@ char CompressedSequence::getBaseAt(size_t i) const {
 
 void CompressedSequence::init() {
   this->mask = 0xFF  >> ( 8*sizeof(uint8_t) - elSize );
-  this->realSize = (size_t)ceil((double)n / (8.0 / (double)elSize));
-  this->seq = new uint8_t[this->realSize];
+  this->realSize = wordsForBits(n * elSize) * sizeof(uint64_t);
+  this->capacity = getWordCount();
+  this->seq = new uint64_t[this->capacity];
 }
 
 void CompressedSequence::resize(size_t newSize) {
-  size_t oldRealSize = this->realSize;
+  size_t oldWords = getWordCount();
+  size_t words = wordsForBits(newSize * elSize);
+  if (words > this->capacity) {
+    reserve(max(newSize, 2 * getCapacity()));
+  }
   this->n = newSize;
-  uint8_t* temp = this->seq;
-  init();
+  this->realSize = words * sizeof(uint64_t);
+  if (words > oldWords) {
+    memset(this->seq + oldWords, 0, (words - oldWords) * sizeof(uint64_t));
+  }
+  clearPadding();
+}
+
+void CompressedSequence::writePacked(ostream& os) const {
+  uint8_t buffer[4096];
+  size_t bytes = getPackedByteCount();
+  for (size_t b = 0; b < bytes; b += sizeof(buffer)) {
+    size_t m = min(bytes - b, sizeof(buffer));
+    getPackedBytes(b, m, buffer);
+    os.write((char*)buffer, m);
+  }
+}
+
+void CompressedSequence::readPacked(istream& is, size_t bytes) {
   memset(this->seq, 0, this->realSize);
-  memcpy(this->seq, temp, oldRealSize * sizeof(uint8_t));
-  delete[] temp;
+  uint8_t buffer[4096];
+  for (size_t b = 0; b < bytes; b += sizeof(buffer)) {
+    size_t m = min(bytes - b, sizeof(buffer));
+    is.read((char*)buffer, m);
+    for (size_t k = 0; k < m; ++k) {
+      size_t p = b + k;
+      seq[p / 8] |= (uint64_t)buffer[k] << (8 * (7 - p % 8));
+    }
+  }
+  clearPadding();
+}
+
+void CompressedSequence::clearPadding() {
+  size_t rest = (n * elSize) % WordBits;
+  if (rest > 0) {
+    seq[getWordCount() - 1] &= ~(uint64_t)0 << (WordBits - rest);
+  }
+}
+
+uint64_t CompressedSequence::loadBits(size_t bitOffset) const {
+  size_t w = bitOffset / WordBits;
+  size_t shift = bitOffset % WordBits;
+  size_t words = getWordCount();
+  if (w >= words) {
+    return 0;
+  }
+  uint64_t bits = seq[w] << shift;
+  if (shift > 0 && w + 1 < words) {
+    bits |= seq[w + 1] >> (WordBits - shift);
+  }
+  return bits;
 }
 
 /************************************************************/
@@ -0,0 +1,231 @@
+#include <core/CompressedVariableReadSet.h>
+#include <core/DNAAlphabet2Bits.hpp>
+#include <core/DNACompressedSymbol.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+using namespace std;
+
+/******************** SUPPORT FUNCTIONS *********************/
+
+// Codes and symbols for 2 bits (DNAAlphabet2Bits) or 4 bits
+// (DNACompressedSymbol) elements
+struct VariableReadTables {
+  uint8_t code[256];
+  char symbols[16];
+  VariableReadTables(size_t elSize) {
+    for (size_t c = 0; c < 256; ++c) {
+      code[c] = (elSize == 2) ? (uint8_t)DNAAlphabet2Bits::charToInt((char)c) :
+	DNACompressedSymbol::IupacToNumber((char)c);
+    }
+    for (uint8_t i = 0; i < 16; ++i) {
+      symbols[i] = (elSize == 2) ? DNAAlphabet2Bits::intToChar(i) :
+	DNACompressedSymbol::NumberToIupac(i);
+    }
+  }
+};
+
+static const VariableReadTables& variableReadTables(size_t elSize) {
+  static VariableReadTables tables2(2);
+  static VariableReadTables tables4(4);
+  return (elSize == 2) ? tables2 : tables4;
+}
+
+static const char FormatMagic[8] = {'L', 'B', 'I', 'O', 'V', 'S', 'E', 'T'};
+static const uint64_t FormatVersion = 1;
+
+/********************** CONSTRUCTORS ************************/
+
+CompressedVariableReadSet::CompressedVariableReadSet(size_t bitsPerBase)
+  : offsets(), maxReadLength(0) {
+  this->elSize = (bitsPerBase == 2) ? 2 : 4;
+  this->n = 0;
+  init();
+  this->offsets.push_back(0);
+}
+
+CompressedVariableReadSet::CompressedVariableReadSet(const vector<Read>& reads, size_t bitsPerBase)
+  : CompressedVariableReadSet(bitsPerBase) {
+  append(reads);
+}
+
+/******************* GET AND SET METHODS ********************/
+
+size_t CompressedVariableReadSet::getReadCount() const {
+  return this->offsets.size() - 1;
+}
+
+size_t CompressedVariableReadSet::getBaseCount() const {
+  return this->offsets.back();
+}
+
+size_t CompressedVariableReadSet::getReadLength(size_t i) const {
+  return this->offsets[i + 1] - this->offsets[i];
+}
+
+size_t CompressedVariableReadSet::getReadOffset(size_t i) const {
+  return this->offsets[i];
+}
+
+size_t CompressedVariableReadSet::getMaxReadLength() const {
+  return this->maxReadLength;
+}
+
+size_t CompressedVariableReadSet::getIndexByteCount() const {
+  return this->offsets.size_in_bytes();
+}
+
+void CompressedVariableReadSet::decodeRead(size_t i, char* bases) const {
+  size_t begin = this->offsets[i];
+  decodeBases(begin, this->offsets[i + 1] - begin, bases);
+}
+
+void CompressedVariableReadSet::decodeBases(size_t offset, size_t length, char* bases) const {
+  const char* symbols = variableReadTables(this->elSize).symbols;
+  // symbols are unpacked in place and then translated
+  unpack(offset, length, (uint8_t*)bases);
+  for (size_t j = 0; j < length; ++j) {
+    bases[j] = symbols[(uint8_t)bases[j]];
+  }
+}
+
+string CompressedVariableReadSet::getBases(size_t i) const {
+  string bases(getReadLength(i), ' ');
+  if (!bases.empty()) {
+    decodeRead(i, &bases[0]);
+  }
+  return bases;
+}
+
+void CompressedVariableReadSet::unpackRead(size_t i, uint8_t* symbols) const {
+  size_t begin = this->offsets[i];
+  unpack(begin, this->offsets[i + 1] - begin, symbols);
+}
+
+/********************* MODIFY METHODS ***********************/
+
+CompressedVariableReadSet& CompressedVariableReadSet::append(const char* bases, size_t length) {
+  size_t begin = this->n;
+  this->resize(begin + length);
+  pack(bases, length, variableReadTables(this->elSize).code, begin);
+  this->offsets.push_back(begin + length);
+  this->maxReadLength = max(this->maxReadLength, length);
+  return *this;
+}
+
+CompressedVariableReadSet& CompressedVariableReadSet::append(const Read& read) {
+  const string& bases = read.getBases();
+  return append(bases.data(), bases.size());
+}
+
+CompressedVariableReadSet& CompressedVariableReadSet::append(const Read* reads, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    append(reads[i]);
+  }
+  return *this;
+}
+
+CompressedVariableReadSet& CompressedVariableReadSet::append(const vector<Read>& reads) {
+  // the sequence grows once for the whole vector
+  size_t total = this->n;
+  for (size_t i = 0; i < reads.size(); ++i) {
+    total += reads[i].length();
+  }
+  reserve(total);
+  for (size_t i = 0; i < reads.size(); ++i) {
+    append(reads[i]);
+  }
+  return *this;
+}
+
+void CompressedVariableReadSet::reserve(size_t baseCount) {
+  CompressedSequence::reserve(baseCount);
+}
+
+/*********************** I/O METHODS ************************/
+
+void CompressedVariableReadSet::writeToFile(const string& fileName) const {
+  ofstream ofs(fileName, ofstream::binary | ofstream::out);
+  uint64_t info[4] = {FormatVersion, this->elSize, getReadCount(), getBaseCount()};
+  ofs.write(FormatMagic, sizeof(FormatMagic));
+  ofs.write((char*)info, sizeof(info));
+  for (size_t i = 0; i < getReadCount(); ++i) {
+    uint64_t length = getReadLength(i);
+    ofs.write((char*)&length, sizeof(uint64_t));
+  }
+  writePacked(ofs);
+}
+
+bool CompressedVariableReadSet::loadFromFile(const string& fileName) {
+  ifstream ifs(fileName, ofstream::binary | ofstream::in);
+  char magic[sizeof(FormatMagic)];
+  uint64_t info[4] = {0, 0, 0, 0};
+  ifs.read(magic, sizeof(magic));
+  ifs.read((char*)info, sizeof(info));
+  if (!ifs || memcmp(magic, FormatMagic, sizeof(magic)) != 0 || info[0] != FormatVersion ||
+      (info[1] != 2 && info[1] != 4)) {
+    cerr << "[ERROR] - " << fileName << " is not a variable read set file" << endl;
+    return false;
+  }
+  // lengths are validated before the content of the set is replaced
+  lbio::elias_fano readOffsets;
+  readOffsets.push_back(0);
+  size_t longest = 0;
+  uint64_t total = 0;
+  for (uint64_t i = 0; i < info[2] && ifs; ++i) {
+    uint64_t length = 0;
+    ifs.read((char*)&length, sizeof(uint64_t));
+    total += length;
+    readOffsets.push_back(total);
+    longest = max(longest, (size_t)length);
+  }
+  if (!ifs || total != info[3]) {
+    cerr << "[ERROR] - Inconsistent read lengths in " << fileName << endl;
+    return false;
+  }
+  delete[] this->seq;
+  this->elSize = info[1];
+  this->n = info[3];
+  init();
+  this->offsets = std::move(readOffsets);
+  this->maxReadLength = longest;
+  readPacked(ifs, getPackedByteCount());
+  if (!ifs) {
+    cerr << "[ERROR] - " << fileName << " is truncated" << endl;
+    *this = CompressedVariableReadSet(this->elSize);
+    return false;
+  }
+  return true;
+}
+
+/******************** READ ITERATOR *************************/
+
+CompressedVariableReadIterator::CompressedVariableReadIterator(const CompressedVariableReadSet& set,
+							       char* buffer)
+  : set(&set), buffer(buffer), position(0), begin(0), end(0)
+{
+}
+
+bool CompressedVariableReadIterator::next() {
+  if (this->position >= this->set->getReadCount()) {
+    return false;
+  }
+  // the end of a read is the beginning of the next one
+  this->begin = this->end;
+  this->end = this->set->getReadOffset(++this->position);
+  this->set->decodeBases(this->begin, this->end - this->begin, this->buffer);
+  return true;
+}
+
+size_t CompressedVariableReadIterator::getIndex() const {
+  return this->position - 1;
+}
+
+lbio::char_span CompressedVariableReadIterator::getBases() const {
+  return lbio::char_span(this->buffer, this->end - this->begin);
+}
+
+/************************************************************/
@@ -1,5 +1,6 @@
 #include <core/DNAAlphabet2Bits.hpp>
 
+#include <cstddef>
 #include <map>
 
 std::map<char, uint64_t> initBasesMap() {
@@ -16,9 +17,29 @@ std::map<char, uint64_t> initBasesMap() {
 // -----------------------------------------------------------------------------
 //                               UTILITY FUNCTIONS
 // -----------------------------------------------------------------------------
+// codes of all the 256 characters (0 for non bases, InvalidCode in
+// the strict table), a table is faster than the map and safe to be
+// read by many threads
+struct BasesTable {
+  uint64_t code[256];
+  uint8_t strict[256];
+  BasesTable() {
+    std::map<char, uint64_t> basesMap = initBasesMap();
+    for (size_t c = 0; c < 256; ++c) {
+      std::map<char, uint64_t>::const_iterator it = basesMap.find((char)c);
+      code[c] = (it != basesMap.end()) ? it->second : 0;
+      strict[c] = (it != basesMap.end()) ? (uint8_t)it->second : DNAAlphabet2Bits::InvalidCode;
+    }
+  }
+};
+
+static const BasesTable& basesTable() {
+  static BasesTable table;
+  return table;
+}
+
 uint64_t fromChar(const char c) {
-  static std::map<char, uint64_t> basesMap = initBasesMap();
-  return basesMap[c] & 0x3;
+  return basesTable().code[(uint8_t)c] & 0x3;
 }
 
 char fromInt(const uint64_t i) {
@@ -37,6 +58,10 @@ uint64_t DNAAlphabet2Bits::charToInt(char c) {
   return fromChar(c);
 }
 
+const uint8_t* DNAAlphabet2Bits::getCodeTable() {
+  return basesTable().strict;
+}
+
 std::map<char, uint64_t> DNAAlphabet2Bits::charToIntMap() {
   return initBasesMap();
 }
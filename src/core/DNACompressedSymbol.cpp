@@ -44,9 +44,21 @@ char DNACompressedSymbol::NumberToIupac(uint8_t n) {
   return iupacs[n];
 }
 
+// codes of all the 256 characters (0 for non IUPAC symbols)
+struct IupacTable {
+  uint8_t code[256];
+  IupacTable() {
+    map<char,int> iupacMap = initIupacMap();
+    for (size_t c = 0; c < 256; ++c) {
+      map<char,int>::const_iterator it = iupacMap.find((char)c);
+      code[c] = (it != iupacMap.end()) ? (uint8_t)it->second : 0;
+    }
+  }
+};
+
 uint8_t DNACompressedSymbol::IupacToNumber(char c) {
-  static map<char,int> iupacMap = initIupacMap();
-  return iupacMap[c];
+  static IupacTable table;
+  return table.code[(uint8_t)c];
 }
 
 /************************************************************/
@@ -5,11 +5,10 @@
 
 #include "../quality.h"
 
+#include <algorithm>
 #include <iostream>
 using namespace std;
 
-#include <boost/tokenizer.hpp>
-
 const double qual::PHRED[300] = {
 1.00000000000000000e+00, // 0.0
 7.94328234724281490e-01, // 1.0
@@ -375,6 +374,40 @@ size_t PhredQuality::length() const {
 
 /********************** STATIC METHODS **********************/
 
+size_t PhredQuality::parseQualityValues(const char* s, size_t length, int* out, size_t maxValues) {
+  size_t count = 0;
+  size_t i = 0;
+  while (i < length) {
+    // skip separators
+    while (i < length && (s[i] == ' ' || s[i] == '\t' || s[i] == ',' ||
+			  s[i] == '\r' || s[i] == '\n')) {
+      ++i;
+    }
+    if (i >= length) {
+      break;
+    }
+    bool negative = (s[i] == '-');
+    if (negative || s[i] == '+') {
+      ++i;
+    }
+    int value = 0;
+    while (i < length && s[i] >= '0' && s[i] <= '9') {
+      value = 10 * value + (s[i] - '0');
+      ++i;
+    }
+    // skip anything else up to the next separator
+    while (i < length && s[i] != ' ' && s[i] != '\t' && s[i] != ',' &&
+	   s[i] != '\r' && s[i] != '\n') {
+      ++i;
+    }
+    if (count < maxValues) {
+      out[count] = negative ? -value : value;
+    }
+    ++count;
+  }
+  return count;
+}
+
 void
 from_phred_with_offset(const std::string& q, double* p, size_t o) {
   size_t n = q.size();
@@ -421,10 +454,14 @@ void PhredQuality::init(const int* v, size_t n) {
 }
 
 void  PhredQuality::parseQualityString(const string& s) {
-  boost::tokenizer<> tok(s);
-  size_t i = 0;
-  for(const string& token : tok) {
-    qualVector[i++] = atoi(token.c_str());
+  size_t found = parseQualityValues(s.data(), s.size(), this->qualVector, this->n);
+  // missing calls (negative values) have the lowest quality
+  for (size_t i = 0; i < std::min(found, this->n); ++i) {
+    this->qualVector[i] = std::max(this->qualVector[i], 0);
+  }
+  // missing values are set to zero
+  for (size_t i = found; i < this->n; ++i) {
+    this->qualVector[i] = 0;
   }
 }
 
@@ -23,15 +23,27 @@ void Read::setQualities(const std::string& qualities) {
   this->qualities = qualities;
 }
 
-std::string Read::getHeader() const {
+void Read::setHeader(const char* header, size_t n) {
+  this->header.assign(header, n);
+}
+
+void Read::setBases(const char* bases, size_t n) {
+  this->bases.assign(bases, n);
+}
+
+void Read::setQualities(const char* qualities, size_t n) {
+  this->qualities.assign(qualities, n);
+}
+
+const std::string& Read::getHeader() const {
   return this->header;
 }
 
-std::string Read::getBases() const {
+const std::string& Read::getBases() const {
   return this->bases;
 }
 
-std::string Read::getQualities() const {
+const std::string& Read::getQualities() const {
   return this->qualities;
 }
 
@@ -43,11 +55,24 @@ std::list<KMer> Read::getKMerList(size_t k) const {
   std::list<KMer> kmersList;
   int M = bases.length() - k + 1;
   for (int i = 0; i < M; i++) {
-    kmersList.push_back(KMer(bases.substr(i,k)));
+    kmersList.push_back(KMer(bases.data() + i, k));
   }
   return kmersList;
 }
 
+KMerSpanList Read::getKMerList(size_t k, lbio::arena& arena) const {
+  KMerSpanList kmers(arena);
+  if (k == 0 || bases.length() < k) {
+    return kmers;
+  }
+  size_t M = bases.length() - k + 1;
+  kmers.reserve(M);
+  for (size_t i = 0; i < M; ++i) {
+    kmers.push_back(lbio::char_span(bases.data() + i, k));
+  }
+  return kmers;
+}
+
 /******************** MODIFY OPERATIONS *********************/
 
 Read& Read::trim(size_t n) {
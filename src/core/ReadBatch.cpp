@@ -0,0 +1,149 @@
+#include <core/ReadBatch.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+/*********************** READ RECORD ************************/
+
+ReadRecord::ReadRecord()
+  : header(), bases(), qualities()
+{
+}
+
+ReadRecord::ReadRecord(lbio::char_span header, lbio::char_span bases, lbio::char_span qualities)
+  : header(header), bases(bases), qualities(qualities)
+{
+}
+
+ReadRecord::ReadRecord(const Read& read)
+  : header(read.getHeader()), bases(read.getBases()), qualities(read.getQualities())
+{
+}
+
+lbio::char_span ReadRecord::getHeader() const {
+  return this->header;
+}
+
+lbio::char_span ReadRecord::getBases() const {
+  return this->bases;
+}
+
+lbio::char_span ReadRecord::getQualities() const {
+  return this->qualities;
+}
+
+size_t ReadRecord::length() const {
+  return this->bases.size();
+}
+
+void ReadRecord::copyTo(Read& read) const {
+  read.setHeader(header.data(), header.size());
+  read.setBases(bases.data(), bases.size());
+  read.setQualities(qualities.data(), qualities.size());
+}
+
+const void* ReadRecord::getSequence() const {
+  return this->bases.data();
+}
+
+size_t ReadRecord::getSequenceLength() const {
+  return this->bases.size();
+}
+
+size_t ReadRecord::getElementSize() const {
+  return sizeof(char);
+}
+
+size_t ReadRecord::getByteCount() const {
+  return this->bases.size() * sizeof(char);
+}
+
+char ReadRecord::getBaseAt(size_t i) const {
+  return this->bases[i];
+}
+
+/************************ READ BATCH ************************/
+
+ReadBatch::ReadBatch(size_t bytesHint)
+  : data(), offsets(1, 0)
+{
+  data.reserve(bytesHint);
+}
+
+size_t ReadBatch::size() const {
+  return offsets.size() / 3;
+}
+
+bool ReadBatch::empty() const {
+  return (offsets.size() == 1);
+}
+
+size_t ReadBatch::getByteCount() const {
+  return data.size();
+}
+
+ReadRecord ReadBatch::getRecord(size_t i) const {
+  const size_t* o = &offsets[3 * i];
+  const char* base = data.data();
+  return ReadRecord(lbio::char_span(base + o[0], o[1] - o[0]),
+		    lbio::char_span(base + o[1], o[2] - o[1]),
+		    lbio::char_span(base + o[2], o[3] - o[2]));
+}
+
+void ReadBatch::copyTo(size_t i, Read& read) const {
+  getRecord(i).copyTo(read);
+}
+
+size_t ReadBatch::append(const char* header, size_t headerLength,
+			 const char* bases, size_t basesLength,
+			 const char* qualities, size_t qualitiesLength) {
+  size_t total = data.size() + headerLength + basesLength + qualitiesLength;
+  vector< char > previous;
+  if (total > data.capacity()) {
+    // the previous buffer is released only after the copy since the
+    // fields may be views of reads of this batch
+    previous.reserve(max(2 * data.capacity(), total));
+    previous.assign(data.begin(), data.end());
+    data.swap(previous);
+  }
+  appendField(header, headerLength);
+  appendField(bases, basesLength);
+  appendField(qualities, qualitiesLength);
+  return size() - 1;
+}
+
+size_t ReadBatch::append(const ReadRecord& record) {
+  lbio::char_span h = record.getHeader();
+  lbio::char_span b = record.getBases();
+  lbio::char_span q = record.getQualities();
+  return append(h.data(), h.size(), b.data(), b.size(), q.data(), q.size());
+}
+
+size_t ReadBatch::append(const Read& read) {
+  return append(ReadRecord(read));
+}
+
+void ReadBatch::reserve(size_t reads, size_t bytes) {
+  offsets.reserve(3 * reads + 1);
+  data.reserve(bytes);
+}
+
+void ReadBatch::clear() {
+  data.clear();
+  offsets.resize(1);
+}
+
+/********************* UTILITY METHODS **********************/
+
+void ReadBatch::appendField(const char* field, size_t n) {
+  size_t begin = data.size();
+  data.resize(begin + n);
+  if (n > 0) {
+    memcpy(data.data() + begin, field, n);
+  }
+  offsets.push_back(data.size());
+}
+
+/************************************************************/
@@ -45,6 +45,19 @@ list<KMer> Reference::getKMerList(size_t k) {
   return kmers;
 }
 
+KMerSpanList Reference::getKMerList(size_t k, lbio::arena& arena) const {
+  KMerSpanList kmers(arena);
+  if (k == 0 || this->length < k) {
+    return kmers;
+  }
+  size_t m = this->length - k + 1;
+  kmers.reserve(m);
+  for (size_t i = 0; i < m; ++i) {
+    kmers.push_back(lbio::char_span(&(this->sequence[i]), k));
+  }
+  return kmers;
+}
+
 // ---------------------------------------------------------
 //                     CONVERSION METHODS
 // ---------------------------------------------------------
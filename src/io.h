@@ -3,10 +3,17 @@
  */
 
 #include "io/Format.hpp"
+#include "io/CompressedInputStream.hpp"
 #include "io/FastFormat.hpp"
+#include "io/FastaStreamReader.hpp"
+#include "io/FastaIndex.hpp"
 #include "io/FastqRead.hpp"
 #include "io/FastqFormat.hpp"
 
 #include "io/CSFastRead.hpp"
 #include "io/CSFastFormat.hpp"
+#include "io/CSFastBatchReader.hpp"
 #include "io/FastqLazyLoader.hpp"
+#include "io/FastqMappedReader.hpp"
+#include "io/FastqParallelReader.hpp"
+#include "io/FastqReadPipeline.hpp"
@@ -1,7 +1,121 @@
 #include "BamFormat.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
 using namespace lbiobam;
 
+BamRecordBatch::BamRecordBatch()
+{
+  clear();
+}
+
+void
+BamRecordBatch::clear()
+{
+  tid.clear();
+  pos.clear();
+  flag.clear();
+  mapq.clear();
+  mtid.clear();
+  mpos.clear();
+  isize.clear();
+  seqLength.clear();
+  names.clear();
+  cigar.clear();
+  seq.clear();
+  qual.clear();
+  nameOffsets.assign(1, 0);
+  cigarOffsets.assign(1, 0);
+  seqOffsets.assign(1, 0);
+  qualOffsets.assign(1, 0);
+}
+
+void
+BamRecordBatch::reserve(size_t n)
+{
+  tid.reserve(n);
+  pos.reserve(n);
+  flag.reserve(n);
+  mapq.reserve(n);
+  mtid.reserve(n);
+  mpos.reserve(n);
+  isize.reserve(n);
+  seqLength.reserve(n);
+  nameOffsets.reserve(n + 1);
+  cigarOffsets.reserve(n + 1);
+  seqOffsets.reserve(n + 1);
+  qualOffsets.reserve(n + 1);
+}
+
+#ifdef HAVE_HTSLIB
+
+void
+BamRecordBatch::append(const bam1_t* b)
+{
+  const bam1_core_t& c = b->core;
+  tid.push_back(c.tid);
+  pos.push_back(c.pos);
+  flag.push_back(c.flag);
+  mapq.push_back(c.qual);
+  mtid.push_back(c.mtid);
+  mpos.push_back(c.mpos);
+  isize.push_back(c.isize);
+  seqLength.push_back(c.l_qseq);
+
+  // the name is null terminated (l_qname includes the terminator)
+  const char* qname = bam_get_qname(b);
+  names.insert(names.end(), qname, qname + strlen(qname) + 1);
+  nameOffsets.push_back(names.size());
+
+  const uint32_t* ops = bam_get_cigar(b);
+  cigar.insert(cigar.end(), ops, ops + c.n_cigar);
+  cigarOffsets.push_back(cigar.size());
+
+  const uint8_t* s = bam_get_seq(b);
+  seq.insert(seq.end(), s, s + ((c.l_qseq + 1) >> 1));
+  seqOffsets.push_back(seq.size());
+
+  const uint8_t* q = bam_get_qual(b);
+  qual.insert(qual.end(), q, q + c.l_qseq);
+  qualOffsets.push_back(qual.size());
+}
+
+/******************** SUPPORT FUNCTIONS *********************/
+
+// Converts a CIGAR string to the BAM encoding (length << 4 | op)
+static bool
+parseCigar(const std::string& cigar, std::vector<uint32_t>& ops)
+{
+  static const std::string codes = "MIDNSHP=X";
+  ops.clear();
+  uint32_t len = 0;
+  bool hasLen = false;
+  for (char c : cigar)
+    {
+      if (c >= '0' && c <= '9')
+        {
+          len = 10 * len + (c - '0');
+          hasLen = true;
+          continue;
+        }
+      size_t op = codes.find(c);
+      if (op == std::string::npos || !hasLen)
+        {
+          return false;
+        }
+      ops.push_back((len << BAM_CIGAR_SHIFT) | (uint32_t)op);
+      len = 0;
+      hasLen = false;
+    }
+  return !hasLen;
+}
+
+#endif
+
 BamFormat::BamFormat()
   : Format("BAM"), hFilePath(""), mode(NotOpened)
 {
@@ -21,7 +135,20 @@ BamFormat::open(const std::string& filePath, BamOpenMode opMode)
 #ifdef HAVE_HTSLIB
 
       hFile = sam_open(hFilePath.c_str(), "r");
+      if (hFile == NULL)
+        {
+          std::cerr << "[ERROR] - Unable to open " << hFilePath << std::endl;
+          mode = NotOpened;
+          return;
+        }
       head = sam_hdr_read(hFile);
+      if (head == NULL)
+        {
+          std::cerr << "[ERROR] - Unable to read the header of " << hFilePath << std::endl;
+          close();
+          mode = NotOpened;
+          return;
+        }
       content = bam_init1();
   
 #else
@@ -36,7 +163,17 @@ BamFormat::open(const std::string& filePath, BamOpenMode opMode)
       mode = BamOpenWrite;
       std::cout << hFilePath << " -->  WRITE\n";      
 #ifdef HAVE_HTSLIB
-      hFile = sam_open(hFilePath.c_str(), "w");
+      // compressed BAM unless the extension asks for SAM text
+      bool sam = (hFilePath.size() >= 4 &&
+                  hFilePath.compare(hFilePath.size() - 4, 4, ".sam") == 0);
+      hFile = sam_open(hFilePath.c_str(), sam ? "w" : "wb");
+      if (hFile == NULL)
+        {
+          std::cerr << "[ERROR] - Unable to open " << hFilePath << std::endl;
+          mode = NotOpened;
+          return;
+        }
+      content = bam_init1();
       
 #else
       std::cout << "Error undefined htslib" << std::endl;
@@ -50,13 +187,25 @@ BamFormat::close()
 {
   hFilePath = "";
   #ifdef HAVE_HTSLIB  
+  if (iterator)
+    {
+      hts_itr_destroy(iterator);
+      iterator = NULL;
+    }
+  if (index)
+    {
+      hts_idx_destroy(index);
+      index = NULL;
+    }
   if (head)
     {
         bam_hdr_destroy(head);
+        head = NULL;
     }
   if (content)
     {
         bam_destroy1(content);
+        content = NULL;
     }
   if (hFile)
     {
@@ -79,7 +228,7 @@ BamFormat::getAlignmentPositions()
   #ifdef HAVE_HTSLIB
   
 
-  while(sam_read1(hFile, head, content) >= 0) {
+  while(readRecord()) {
     pList->push_back(content->core.pos);
   }
 
@@ -98,7 +247,7 @@ BamFormat::getNext() {
       return idPos;
     }
   #ifdef HAVE_HTSLIB
-  if (sam_read1(hFile, head, content) >= 0) { 
+  if (readRecord()) { 
     idPos.first = std::string(bam_get_qname(content));
     idPos.second = content->core.pos;
   }
@@ -111,10 +260,228 @@ BamFormat::getNext() {
   return idPos;
 }
 
+bool
+BamFormat::setThreads(int n)
+{
+#ifdef HAVE_HTSLIB
+  if (hFile == NULL || n < 1)
+    {
+      return false;
+    }
+  return (hts_set_threads(hFile, n) == 0);
+#else
+  return false;
+#endif
+}
+
+size_t
+BamFormat::readBatch(BamRecordBatch& batch, size_t n)
+{
+  batch.clear();
+  if (mode != BamOpenRead)
+    {
+      return 0;
+    }
+#ifdef HAVE_HTSLIB
+  batch.reserve(n);
+  while (batch.size() < n && readRecord())
+    {
+      batch.append(content);
+    }
+#endif
+  return batch.size();
+}
+
+bool
+BamFormat::loadIndex(const std::string& indexPath)
+{
+  if (mode != BamOpenRead)
+    {
+      return false;
+    }
+#ifdef HAVE_HTSLIB
+  if (index)
+    {
+      hts_idx_destroy(index);
+    }
+  index = indexPath.empty() ? sam_index_load(hFile, hFilePath.c_str())
+    : sam_index_load2(hFile, hFilePath.c_str(), indexPath.c_str());
+  if (index == NULL)
+    {
+      std::cerr << "[ERROR] - Unable to load the index of " << hFilePath << std::endl;
+      return false;
+    }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool
+BamFormat::setRegion(const std::string& region)
+{
+#ifdef HAVE_HTSLIB
+  if (index == NULL)
+    {
+      return false;
+    }
+  clearRegion();
+  iterator = sam_itr_querys(index, head, region.c_str());
+  return (iterator != NULL);
+#else
+  return false;
+#endif
+}
+
+bool
+BamFormat::setRegion(const BamRegion& region)
+{
+#ifdef HAVE_HTSLIB
+  if (index == NULL)
+    {
+      return false;
+    }
+  clearRegion();
+  iterator = sam_itr_queryi(index, region.tid, region.begin, region.end);
+  return (iterator != NULL);
+#else
+  return false;
+#endif
+}
 
 void
-BamFormat::setBamHeader()
-{  
+BamFormat::clearRegion()
+{
+#ifdef HAVE_HTSLIB
+  if (iterator)
+    {
+      hts_itr_destroy(iterator);
+      iterator = NULL;
+    }
+#endif
+}
+
+std::vector<BamRegion>
+BamFormat::splitRegions(int64_t regionSize) const
+{
+  std::vector<BamRegion> regions;
+#ifdef HAVE_HTSLIB
+  if (head == NULL || regionSize <= 0)
+    {
+      return regions;
+    }
+  for (int32_t tid = 0; tid < head->n_targets; ++tid)
+    {
+      int64_t length = head->target_len[tid];
+      for (int64_t begin = 0; begin < length; begin += regionSize)
+        {
+          BamRegion r;
+          r.tid = tid;
+          r.begin = begin;
+          r.end = std::min(begin + regionSize, length);
+          regions.push_back(r);
+        }
+    }
+#endif
+  return regions;
+}
+
+size_t
+BamFormat::forEachRegion(const std::string& filePath,
+                         const std::vector<BamRegion>& regions, size_t T,
+                         const BamRegionCallback& callback, size_t batchSize)
+{
+#ifdef HAVE_HTSLIB
+  T = (T > 0) ? T : 1;
+  batchSize = (batchSize > 0) ? batchSize : 1;
+  // regions are assigned dynamically, since their cost varies a lot
+  std::atomic<size_t> nextRegion(0);
+  std::vector<size_t> counts(T, 0);
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < T; ++t)
+    {
+      workers.push_back(std::thread([&, t]() {
+            BamFormat bam;
+            bam.open(filePath, BamOpenRead);
+            if (!bam.loadIndex())
+              {
+                return;
+              }
+            BamRecordBatch batch;
+            batch.reserve(batchSize);
+            size_t r;
+            while ((r = nextRegion++) < regions.size())
+              {
+                const BamRegion& region = regions[r];
+                if (!bam.setRegion(region))
+                  {
+                    continue;
+                  }
+                bool more = true;
+                while (more)
+                  {
+                    batch.clear();
+                    while (batch.size() < batchSize && (more = bam.readRecord()))
+                      {
+                        // keep only the alignments beginning in the region
+                        if (bam.content->core.pos >= region.begin)
+                          {
+                            batch.append(bam.content);
+                          }
+                      }
+                    if (!batch.empty())
+                      {
+                        counts[t] += batch.size();
+                        callback(t, region, batch);
+                      }
+                  }
+              }
+            bam.close();
+          }));
+    }
+  size_t total = 0;
+  for (size_t t = 0; t < T; ++t)
+    {
+      workers[t].join();
+      total += counts[t];
+    }
+  return total;
+#else
+  return 0;
+#endif
+}
+
+#ifdef HAVE_HTSLIB
+
+bool
+BamFormat::readRecord()
+{
+  if (iterator)
+    {
+      return (sam_itr_next(hFile, iterator, content) >= 0);
+    }
+  return (sam_read1(hFile, head, content) >= 0);
+}
+
+#endif
+
+void
+BamFormat::setBamHeader(const std::vector<BamReferenceInfo>& references)
+{
+#ifdef HAVE_HTSLIB
+  std::ostringstream text;
+  text << "@HD\tVN:1.6\tSO:unsorted\n";
+  for (const BamReferenceInfo& r : references)
+    {
+      text << "@SQ\tSN:" << r.first << "\tLN:" << r.second << "\n";
+    }
+  std::string s = text.str();
+  if (head)
+    {
+      bam_hdr_destroy(head);
+    }
+  head = sam_hdr_parse(s.size(), s.c_str());
+#endif
 }
 
 void
@@ -134,9 +501,60 @@ void
 BamFormat::writeBamHeader()
 {
 #ifdef HAVE_HTSLIB
-  int hdrWriteRes = sam_hdr_write(hFile, head);
-
+  if (hFile == NULL || head == NULL || sam_hdr_write(hFile, head) < 0)
+    {
+      std::cerr << "[ERROR] - Unable to write header to " << hFilePath << std::endl;
+    }
 #else
   
 #endif
 }
+
+bool
+BamFormat::writeAlignment(const BamAlignment& alignment)
+{
+  if (mode != BamOpenWrite)
+    {
+      return false;
+    }
+#ifdef HAVE_HTSLIB
+  if (head == NULL)
+    {
+      std::cerr << "[ERROR] - The header of " << hFilePath << " has not been set" << std::endl;
+      return false;
+    }
+  std::vector<uint32_t> cigar;
+  if (!parseCigar(alignment.cigar, cigar))
+    {
+      std::cerr << "[ERROR] - Invalid CIGAR " << alignment.cigar << std::endl;
+      return false;
+    }
+  std::string qual;
+  if (!alignment.qual.empty())
+    {
+      qual.resize(alignment.qual.size());
+      for (size_t i = 0; i < qual.size(); ++i)
+        {
+          qual[i] = alignment.qual[i] - 33;
+        }
+    }
+  // room for the AS:i tag (2 bytes tag, 1 byte type, 4 bytes value)
+  size_t auxLength = (alignment.score >= 0) ? 7 : 0;
+  if (bam_set1(content, alignment.qname.size(), alignment.qname.c_str(),
+               alignment.flag, alignment.tid, alignment.pos, alignment.mapq,
+               cigar.size(), cigar.data(), -1, -1, 0,
+               alignment.seq.size(), alignment.seq.c_str(),
+               qual.empty() ? NULL : qual.c_str(), auxLength) < 0)
+    {
+      return false;
+    }
+  if (alignment.score >= 0)
+    {
+      int32_t score = alignment.score;
+      bam_aux_append(content, "AS", 'i', sizeof(score), (const uint8_t*)&score);
+    }
+  return (sam_write1(hFile, head, content) >= 0);
+#else
+  return false;
+#endif
+}
@@ -3,14 +3,18 @@
 
 #include "../io.h"
 
+#include <functional>
 #include <list>
 #include <memory>
+#include <vector>
 
 typedef std::list<uint64_t> UIntList;
 typedef std::pair<std::string,int64_t> IdPos;
 
-// This is a variable to be set using autoconf & co
-#define HAVE_HTSLIB 1
+// HAVE_HTSLIB is set by configure (in config.h) when htslib is found
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
 
 #ifdef HAVE_HTSLIB
 
@@ -48,6 +52,114 @@ namespace lbiobam
     
   } BamAlignInfo;
   
+  /**
+   * A batch of alignments decoded in <em>struct of arrays</em> form.
+   *
+   * Fixed size fields are stored in one array per field (the i-th
+   * alignment of the batch is at index i of every array), while
+   * variable length fields (names, CIGAR operations, sequences and
+   * qualities) are stored back to back in a single array together
+   * with the offsets of each alignment. Sequences keep the 4 bits per
+   * base encoding of BAM (two bases per byte, see
+   * <code>bam_seqi</code>) and qualities are raw Phred values.
+   *
+   * Batches are meant to be reused: clear() keeps the allocated
+   * memory so that, after the first few batches, decoding does not
+   * allocate.
+   */
+  struct BamRecordBatch
+  {
+    std::vector<int32_t> tid;
+    std::vector<int64_t> pos;
+    std::vector<uint16_t> flag;
+    std::vector<uint8_t> mapq;
+    std::vector<int32_t> mtid;
+    std::vector<int64_t> mpos;
+    std::vector<int64_t> isize;
+    std::vector<int32_t> seqLength;
+
+    std::vector<char> names;
+    std::vector<uint32_t> cigar;
+    std::vector<uint8_t> seq;
+    std::vector<uint8_t> qual;
+
+    // offsets of each alignment (size()+1 entries)
+    std::vector<size_t> nameOffsets;
+    std::vector<size_t> cigarOffsets;
+    std::vector<size_t> seqOffsets;
+    std::vector<size_t> qualOffsets;
+
+    BamRecordBatch();
+
+    size_t size() const { return tid.size(); }
+    bool empty() const { return tid.empty(); }
+    void clear();
+    void reserve(size_t n);
+
+    const char* getName(size_t i) const { return &names[nameOffsets[i]]; }
+    size_t getCigarCount(size_t i) const { return cigarOffsets[i + 1] - cigarOffsets[i]; }
+    const uint32_t* getCigar(size_t i) const { return cigar.data() + cigarOffsets[i]; }
+    const uint8_t* getSeq(size_t i) const { return seq.data() + seqOffsets[i]; }
+    const uint8_t* getQual(size_t i) const { return qual.data() + qualOffsets[i]; }
+
+#ifdef HAVE_HTSLIB
+    /**
+     * Appends (a copy of) an alignment to the batch
+     */
+    void append(const bam1_t* b);
+#endif
+  };
+
+  /**
+   * A single alignment to be written with BamFormat::writeAlignment().
+   *
+   * Positions are 0-based (as in <code>bam1_core_t</code>), the CIGAR
+   * is given as a string (e.g. <code>4S20M1I10M</code>) and qualities
+   * as a fastq (Phred+33) string, an empty quality string is written
+   * as missing qualities. Negative scores are not written, otherwise
+   * the score is stored in the <code>AS</code> tag.
+   */
+  struct BamAlignment
+  {
+    /**
+     * The flag of unmapped reads (<code>BAM_FUNMAP</code>), also
+     * available without htslib
+     */
+    static const uint16_t Unmapped = 0x4;
+
+    std::string qname;
+    int32_t tid;
+    int64_t pos;
+    uint16_t flag;
+    uint8_t mapq;
+    std::string cigar;
+    std::string seq;
+    std::string qual;
+    int32_t score;
+
+    BamAlignment() : tid(-1), pos(-1), flag(0), mapq(255), score(-1) { }
+  };
+
+  typedef std::pair<std::string, uint64_t> BamReferenceInfo;
+
+  /**
+   * A genomic interval: reference id and 0-based half open range
+   * of positions.
+   */
+  struct BamRegion
+  {
+    int32_t tid;
+    int64_t begin;
+    int64_t end;
+  };
+
+  /**
+   * Callback used by BamFormat::forEachRegion(), it receives the
+   * index of the worker, the region and a batch of alignments of the
+   * region.
+   */
+  typedef std::function<void(size_t, const BamRegion&, const BamRecordBatch&)> BamRegionCallback;
+
   enum BamOpenMode { BamOpenRead, BamOpenWrite, BamOpenAppend, NotOpened };
 
   class BamFormat : public Format {
@@ -56,6 +168,8 @@ namespace lbiobam
     htsFile* hFile = NULL;
     bam_hdr_t* head = NULL;
     bam1_t* content = NULL;
+    hts_idx_t* index = NULL;
+    hts_itr_t* iterator = NULL;
 
     #endif
 
@@ -69,15 +183,84 @@ namespace lbiobam
     std::unique_ptr<UIntList> getAlignmentPositions();
     IdPos getNext();
 
-    void setBamHeader();
+    /**
+     * Uses <code>n</code> threads for the (de)compression of the
+     * BGZF blocks of the file, must be called after open().
+     * Returns <code>false</code> if the thread pool could not be set.
+     */
+    bool setThreads(int n);
+    /**
+     * Decodes (at most) <code>n</code> alignments into the batch,
+     * the previous content of the batch is cleared. Returns the
+     * number of alignments decoded, 0 at the end of the file.
+     */
+    size_t readBatch(BamRecordBatch& batch, size_t n);
+
+    /**
+     * Loads the index (<code>.bai</code> or <code>.csi</code>) of a
+     * file opened for reading. When <code>indexPath</code> is empty
+     * the index is searched next to the file (as samtools does).
+     */
+    bool loadIndex(const std::string& indexPath = "");
+    /**
+     * Restricts the following reads (getNext(), readBatch(), ...) to
+     * the alignments overlapping a region in samtools syntax (e.g.
+     * <code>chr2:1000-2000</code>), requires loadIndex().
+     */
+    bool setRegion(const std::string& region);
+    /**
+     * As setRegion(const std::string&) using a BamRegion
+     */
+    bool setRegion(const BamRegion& region);
+    /**
+     * Goes back to reading the whole file (from the current position)
+     */
+    void clearRegion();
+    /**
+     * Splits all the references of the header into regions of (at
+     * most) <code>regionSize</code> positions.
+     */
+    std::vector<BamRegion> splitRegions(int64_t regionSize) const;
+
+    /**
+     * Processes the regions in parallel: <code>T</code> workers, each
+     * with its own file handle, take the regions one at a time and
+     * pass the alignments to the callback in batches. Alignments
+     * overlapping more regions are passed only with the region where
+     * they begin, so (when regions do not overlap) each alignment is
+     * processed once. Unmapped alignments without coordinates are not
+     * considered. Returns the number of alignments processed.
+     */
+    static size_t forEachRegion(const std::string& filePath,
+                                const std::vector<BamRegion>& regions, size_t T,
+                                const BamRegionCallback& callback,
+                                size_t batchSize = 4096);
+
+    /**
+     * Creates the header of a file opened for writing from the names
+     * and lengths of the reference sequences (the order gives the
+     * <code>tid</code> of each reference).
+     */
+    void setBamHeader(const std::vector<BamReferenceInfo>& references);
     void copyHeader(const BamFormat& other);
     void writeBamHeader();
+    /**
+     * Appends an alignment to a file opened for writing, the header
+     * must have been written already. Records are collected in BGZF
+     * blocks that are compressed by the thread pool (if any, see
+     * setThreads()). Returns <code>false</code> on errors (e.g.
+     * malformed CIGAR strings).
+     */
+    bool writeAlignment(const BamAlignment& alignment);
 
     // As of now these are meaningless and should not be used.
     // In the future we may give them speial meaning (bad design [sic]).
     std::string loadFromFile(const std::string& fileName) { return ""; }
     std::string getSequence() const  { return ""; }
     std::string getHeader() const  { return ""; }
+
+  private:
+    bool readRecord();
   };
   
 }
@@ -0,0 +1,153 @@
+#include "CSFastBatchReader.hpp"
+
+#include <core/PhredQuality.hpp>
+
+#include <cstring>
+#include <iostream>
+
+/******************** COLOR SPACE BATCH *********************/
+
+CSFastReadBatch::CSFastReadBatch()
+  : text(), textOffsets(1, 0), qualities(), qualOffsets(1, 0), primers()
+{
+}
+
+size_t CSFastReadBatch::size() const {
+  return primers.size();
+}
+
+bool CSFastReadBatch::empty() const {
+  return primers.empty();
+}
+
+lbio::char_span CSFastReadBatch::getHeader(size_t i) const {
+  return lbio::char_span(text.data() + textOffsets[3 * i],
+			 textOffsets[3 * i + 1] - textOffsets[3 * i]);
+}
+
+lbio::char_span CSFastReadBatch::getColors(size_t i) const {
+  return lbio::char_span(text.data() + textOffsets[3 * i + 1],
+			 textOffsets[3 * i + 2] - textOffsets[3 * i + 1]);
+}
+
+char CSFastReadBatch::getPrimer(size_t i) const {
+  return primers[i];
+}
+
+lbio::char_span CSFastReadBatch::getQualityLine(size_t i) const {
+  return lbio::char_span(text.data() + textOffsets[3 * i + 2],
+			 textOffsets[3 * i + 3] - textOffsets[3 * i + 2]);
+}
+
+const int* CSFastReadBatch::getQualities(size_t i) const {
+  return qualities.data() + qualOffsets[i];
+}
+
+size_t CSFastReadBatch::getQualityCount(size_t i) const {
+  return qualOffsets[i + 1] - qualOffsets[i];
+}
+
+void CSFastReadBatch::copyTo(size_t i, CSFastRead& read) const {
+  lbio::char_span header = getHeader(i);
+  lbio::char_span colors = getColors(i);
+  lbio::char_span quals = getQualityLine(i);
+  read.setHeader(header.data(), header.size());
+  read.setBases(colors.data(), colors.size());
+  read.setQualities(quals.data(), quals.size());
+  read.setPrimer(primers[i]);
+}
+
+void CSFastReadBatch::clear() {
+  text.clear();
+  textOffsets.assign(1, 0);
+  qualities.clear();
+  qualOffsets.assign(1, 0);
+  primers.clear();
+}
+
+size_t CSFastReadBatch::append(const std::string& header, const std::string& colors,
+			       const std::string& qualityLine) {
+  // one value per color is expected, more are counted but not stored
+  size_t expected = (colors.empty()) ? 0 : colors.size() - 1;
+  size_t begin = qualities.size();
+  qualities.resize(begin + expected);
+  size_t found = PhredQuality::parseQualityValues(qualityLine.data(), qualityLine.size(),
+						   qualities.data() + begin, expected);
+  if (found != expected) {
+    // the read is not added, the batch only holds consistent reads
+    qualities.resize(begin);
+    return found;
+  }
+  qualOffsets.push_back(qualities.size());
+  appendText(header, 0);
+  primers.push_back(colors.empty() ? 0 : colors[0]);
+  appendText(colors, colors.empty() ? 0 : 1);
+  appendText(qualityLine, 0);
+  return found;
+}
+
+void CSFastReadBatch::appendText(const std::string& s, size_t from) {
+  text.insert(text.end(), s.begin() + from, s.end());
+  textOffsets.push_back(text.size());
+}
+
+/*********************** CONSTRUCTORS ***********************/
+
+CSFastBatchReader::CSFastBatchReader(const std::string& colorsPath, const std::string& qualPath)
+  : colorsInput(colorsPath), qualInput(qualPath), colorsHeader(), colorsLine(),
+    qualHeader(), qualLine(), synchronized(true)
+{
+}
+
+/*********************** LOAD METHODS ***********************/
+
+bool CSFastBatchReader::isOpen() const {
+  return (colorsInput.is_open() && qualInput.is_open());
+}
+
+bool CSFastBatchReader::isSynchronized() const {
+  return synchronized;
+}
+
+size_t CSFastBatchReader::nextBatch(CSFastReadBatch& batch, size_t n) {
+  batch.clear();
+  if (!synchronized || !isOpen()) {
+    return 0;
+  }
+  while (batch.size() < n) {
+    if (!nextDataLine(colorsInput, colorsHeader) || !nextDataLine(colorsInput, colorsLine)) {
+      break;
+    }
+    if (!nextDataLine(qualInput, qualHeader) || !nextDataLine(qualInput, qualLine) ||
+	qualHeader != colorsHeader) {
+      std::cerr << "[ERROR] - Inconsistency between colors and qualities header ("
+		<< colorsHeader << ")\n";
+      synchronized = false;
+      break;
+    }
+    size_t colors = colorsLine.size() - 1;
+    if (batch.append(colorsHeader, colorsLine, qualLine) != colors) {
+      std::cerr << "[ERROR] - Number of qualities and colors differ ("
+		<< colorsHeader << ")\n";
+      synchronized = false;
+      break;
+    }
+  }
+  return batch.size();
+}
+
+/********************* UTILITY METHODS **********************/
+
+bool CSFastBatchReader::nextDataLine(std::istream& is, std::string& line) {
+  while (std::getline(is, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r') {
+      line.resize(line.size() - 1);
+    }
+    if (!line.empty() && line[0] != '#') {
+      return true;
+    }
+  }
+  return false;
+}
+
+/************************************************************/
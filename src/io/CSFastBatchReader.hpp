@@ -0,0 +1,162 @@
+#ifndef CS_FAST_BATCH_READER_H
+#define CS_FAST_BATCH_READER_H
+
+#include "CSFastRead.hpp"
+#include "CompressedInputStream.hpp"
+
+#include <util/char_span.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * \brief A batch of color space reads stored contiguously.
+ *
+ * Headers, colors and the original quality lines of all the reads of
+ * the batch are stored back to back in one character buffer, while
+ * the parsed quality values are stored in a single integer array.
+ * Both buffers are kept by clear() so that a batch reused for many
+ * calls of CSFastBatchReader::nextBatch() stops allocating once it has
+ * grown to the size of a typical batch.
+ *
+ * \sa CSFastBatchReader
+ */
+class CSFastReadBatch {
+ private:
+  std::vector< char > text;
+  // 3 offsets per read (header, colors, quality line) plus the end
+  std::vector< size_t > textOffsets;
+  std::vector< int > qualities;
+  std::vector< size_t > qualOffsets;
+  std::vector< char > primers;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  CSFastReadBatch();
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  size_t size() const;
+  bool empty() const;
+  /**
+   * \brief Returns the header (including the leading \c >) of the
+   * i-th read
+   */
+  lbio::char_span getHeader(size_t i) const;
+  /**
+   * \brief Returns the colors of the i-th read (primer excluded)
+   */
+  lbio::char_span getColors(size_t i) const;
+  char getPrimer(size_t i) const;
+  /**
+   * \brief Returns the quality line of the i-th read as found in the
+   * input file
+   */
+  lbio::char_span getQualityLine(size_t i) const;
+  /**
+   * \brief Returns the parsed quality values of the i-th read
+   */
+  const int* getQualities(size_t i) const;
+  size_t getQualityCount(size_t i) const;
+  /**
+   * \brief Copies the i-th read into an existing CSFastRead
+   */
+  void copyTo(size_t i, CSFastRead& read) const;
+
+  // ---------------------------------------------------------
+  //                    MODIFY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Removes all reads (allocated memory is kept)
+   */
+  void clear();
+  /**
+   * \brief Appends a read given its header, the colors line (primer
+   * included) and the quality line
+   *
+   * The read is appended only if the quality line has one value per
+   * color, otherwise the batch is left unchanged.
+   *
+   * \return The number of quality values found in the quality line
+   */
+  size_t append(const std::string& header, const std::string& colors,
+		const std::string& qualityLine);
+
+ private:
+  void appendText(const std::string& s, size_t from);
+};
+
+/**
+ * \brief Buffered reader for color space reads stored in a pair of
+ * \c .csfasta and \c .qual files.
+ *
+ * The two files are read in parallel through buffered (and possibly
+ * compressed, see CompressedInputStream) streams, lines are loaded in
+ * reusable strings (so they are never truncated) and comment lines
+ * (starting with \c #) are skipped. Each call to nextBatch() fills a
+ * CSFastReadBatch with the next reads, quality values are parsed with
+ * PhredQuality::parseQualityValues().
+ *
+ * The two files are checked to be in sync: if the header of a read
+ * differs between the two files, or if the number of quality values
+ * does not match the number of colors, the reader reports the error
+ * and stops (see isSynchronized()).
+ *
+ * \code
+ * CSFastBatchReader reader("reads.csfasta", "reads_QV.qual");
+ * CSFastReadBatch batch;
+ * while (reader.nextBatch(batch, 4096) > 0) {
+ *   for (size_t i = 0; i < batch.size(); ++i) {
+ *     // batch.getColors(i), batch.getQualities(i), ...
+ *   }
+ * }
+ * \endcode
+ *
+ * \sa CSFastFormat
+ * \sa CSFastReadBatch
+ */
+class CSFastBatchReader {
+ private:
+  CompressedInputStream colorsInput;
+  CompressedInputStream qualInput;
+  std::string colorsHeader;
+  std::string colorsLine;
+  std::string qualHeader;
+  std::string qualLine;
+  bool synchronized;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  /**
+   * \brief Opens the colors and the qualities files
+   */
+  CSFastBatchReader(const std::string& colorsPath, const std::string& qualPath);
+
+  // ---------------------------------------------------------
+  //                       LOAD METHODS
+  // ---------------------------------------------------------
+  bool isOpen() const;
+  /**
+   * \brief Returns \c false if an inconsistency between the two
+   * files has been found
+   */
+  bool isSynchronized() const;
+  /**
+   * \brief Loads (at most) \c n reads into the batch, the previous
+   * content of the batch is cleared
+   *
+   * \return The number of reads loaded, 0 when the files have been
+   * consumed (or are not synchronized)
+   */
+  size_t nextBatch(CSFastReadBatch& batch, size_t n);
+
+ private:
+  static bool nextDataLine(std::istream& is, std::string& line);
+};
+
+#endif
@@ -28,7 +28,7 @@ CSFastFormat::~CSFastFormat() {
 /***************** FORMAT METHODS OVERRIDE ******************/
 
 string CSFastFormat::loadFromFile(const string &fileName) {
-  ifstream ifs(fileName);
+  CompressedInputStream ifs(fileName);
   char buffer[MAX_BUFFER_SIZE];
   sequence.clear();
   while(!ifs.eof()) {
@@ -2,6 +2,7 @@
 #define CS_FAST_FORMAT_H
 
 #include "CSFastRead.hpp"
+#include "CompressedInputStream.hpp"
 #include "Format.hpp"
 
 #include <fstream>
@@ -21,15 +22,18 @@ using namespace std;
  * reads one at time using the getNextRead() method which
  * returns a CSFastRead object.
  *
+ * For large inputs CSFastBatchReader should be preferred.
+ *
  * \sa CSFastRead
+ * \sa CSFastBatchReader
  *
  */
 class CSFastFormat : public Format {
  private:
   string sequence;
   string header;
-  ifstream baseFile;
-  ifstream qualFile;
+  CompressedInputStream baseFile;
+  CompressedInputStream qualFile;
   CSFastRead* nextRead;
 public:
   // ---------------------------------------------------------
@@ -2,7 +2,19 @@
 
 #include <core/PhredQuality.hpp>
 
-#define MAX_BUFFER_SIZE 4096
+// Reads the next line that is neither empty nor a comment ('#'),
+// the line terminator (including '\r') is removed
+static bool nextDataLine(istream& is, string& line) {
+  while (std::getline(is, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r') {
+      line.resize(line.size() - 1);
+    }
+    if (!line.empty() && line[0] != '#') {
+      return true;
+    }
+  }
+  return false;
+}
 
 // ---------------------------------------------------------
 //                      CONSTRUCTORS
@@ -33,20 +45,26 @@ void CSFastRead::setPrimer(char p) {
   this->primer = p;
 }
 
-list< FullyQualifiedSequence< ColorAlphabet > > CSFastRead::getFullyQualifiedKMerList(size_t k) const {
-  list< FullyQualifiedSequence< ColorAlphabet > > qualKmersList;
+FullyQualifiedKMerList CSFastRead::getFullyQualifiedKMerList(size_t k, lbio::arena& arena) const {
+  FullyQualifiedKMerList qualKmersList(arena);
+  if (k == 0 || bases.size() < k) {
+    return qualKmersList;
+  }
   size_t N = bases.size() - k + 1;
-  // compute raw string and quality for entire read
-  const char* rawSequence = this->bases.c_str();
+  qualKmersList.reserve(N);
+  // error probabilities are computed once for the entire read
   PhredQuality quals(this->qualities, this->bases.size());
+  double* probs = quals.getProbabilities();
+  lbio::char_span colors(this->bases);
   for (size_t i = 0; i < N; ++i) {
-    // get quality and k-mer for subsequence [i .. i+k-1] of the read
-    PhredQuality qual(quals.getQualities(i,k), k);
-    KMer* kmer = new KMer(&rawSequence[i], k);
-    // creates and insert into the output list a new entry
-    FullQuality< ColorAlphabet >* quality = new FullQuality< ColorAlphabet >(qual,*kmer);
+    // the k-mer is a view of the colors [i .. i+k-1] of the read
+    ReadRecord* kmer = arena.create< ReadRecord >(lbio::char_span(), colors.substr(i, k),
+						   lbio::char_span());
+    FullQuality< ColorAlphabet >* quality =
+      arena.create< FullQuality< ColorAlphabet > >(probs + i, *kmer, arena);
     qualKmersList.push_back(FullyQualifiedSequence< ColorAlphabet >(kmer, quality));
   }
+  delete[] probs;
   return qualKmersList;
 }
 
@@ -56,14 +74,19 @@ list< FullyQualifiedSequence< ColorAlphabet > > CSFastRead::getFullyQualifiedKMe
 
 istream& operator>>(istream& is, CSFastRead& read) {
   // WARNING: this methods doesn't load quality values (yet)
-  char buffer[MAX_BUFFER_SIZE];
-  // header starts with '>'
-  is.getline(buffer,MAX_BUFFER_SIZE);
-  read.header = string(buffer);
-  // read actual colors
-  is.get(read.primer);
-  is.getline(buffer,MAX_BUFFER_SIZE);
-  read.bases = string(buffer);  
+  // header starts with '>' (comment lines are skipped)
+  if (!nextDataLine(is, read.header)) {
+    read.header.clear();
+    read.bases.clear();
+    return is;
+  }
+  // read actual colors (first character is the primer)
+  if (!nextDataLine(is, read.bases)) {
+    read.bases.clear();
+    return is;
+  }
+  read.primer = read.bases[0];
+  read.bases.erase(0, 1);
   return is;
 }
 
@@ -76,13 +99,14 @@ ostream& operator<<(ostream& os, CSFastRead& read) {
 
 void CSFastRead::loadBasesAndQualitiesFromFiles(istream& bases_is, istream& qual_is) {
   bases_is >> (*this);
-  char buffer[MAX_BUFFER_SIZE];
+  string qualHeader;
   // discard header
-  qual_is.getline(buffer,MAX_BUFFER_SIZE);
-  if (string(buffer) != this->header) {
+  nextDataLine(qual_is, qualHeader);
+  if (qualHeader != this->header) {
     cerr << "[ERROR] - Inconsistency between colors and qualities header\n";
   }
   // read qualitis string
-  qual_is.getline(buffer,MAX_BUFFER_SIZE);
-  this->qualities = string(buffer);
+  if (!nextDataLine(qual_is, this->qualities)) {
+    this->qualities.clear();
+  }
 }
@@ -2,12 +2,17 @@
 #define CSFAST_READ_H
 
 #include <core/Read.hpp>
+#include <core/ReadBatch.hpp>
 #include <core/FullyQualifiedSequence.hpp>
 #include <core/ColorAlphabet.hpp>
 
 #include <iostream>
-#include <list>
 
+/**
+ * \brief The qualified k-mers of a color space read, allocated in an
+ * arena (see CSFastRead::getFullyQualifiedKMerList(size_t, lbio::arena&))
+ */
+typedef lbio::arena_vector< FullyQualifiedSequence< ColorAlphabet > > FullyQualifiedKMerList;
 
 /**
  * \brief This class represents a Read stored in the colors space format
@@ -90,10 +95,10 @@ public:
   void setPrimer(char p);
 
   /**
-   * \brief Returns a standard \c list of FullyQualifiedSequence
-   * one for each k-mer of the read.
+   * \brief Returns a FullyQualifiedSequence for each k-mer of the
+   * read, all allocated in an arena.
    *
-   * The list is created starting from the stored seuqence and the
+   * The k-mers are created starting from the stored sequence and the
    * stored quality values. The class requires that the sequence is
    * represented into color space (since ColorAlphabet class will
    * be used) and that qualities a represented as phred values.
@@ -102,26 +107,24 @@ public:
    * The returned list contains \f$ n-k+1 \f$ elements (where \c n
    * is the size of the read and \c k ise the size of k-mers), each
    * element is a FullyQualifiedSequence templated on ColorAlphabet.
-   * Recall that the references passed to constructors of the
-   * FullyQualifiedSequence class require that <b>pointer to the
-   * Sequence and FullQuality objects remain valid through all the
-   * class scope</b> and therefore they are dynamically allocated
-   * and <b>the programmer should take care of freeing them</b>
-   * when they are no more needed.
+   * The container, the Sequence (a ReadRecord viewing the colors
+   * of the read) and the FullQuality of each k-mer are allocated in
+   * the given arena: nothing has to be freed by the caller, all of
+   * them are released together with arena::release(). The k-mers
+   * remain valid until the read is modified or the arena released.
    *
    * \param k The size of the k-mers
-   * \return A list of FullyQualifiedSequence for the k-mers
+   * \param arena The arena where the k-mers are allocated
+   * \return The qualified k-mers of the read
    *
-   * \sa Read::getKMerList()
+   * \sa lbio::arena
    * \sa FullQuality
-   * \sa Sequence
    * \sa FullyQualifiedSequence
    * \sa ColorAlphabet
    * \sa PhredQuality
-   *
    */
-  std::list<FullyQualifiedSequence<ColorAlphabet>>
-  getFullyQualifiedKMerList(size_t k) const;
+  FullyQualifiedKMerList
+  getFullyQualifiedKMerList(size_t k, lbio::arena& arena) const;
 
   // ---------------------------------------------------------
   //                  '>>' AND '<<' OPERATORS
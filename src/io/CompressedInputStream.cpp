@@ -0,0 +1,171 @@
+#include "CompressedInputStream.hpp"
+
+#include <iostream>
+#include <thread>
+
+const size_t DECOMPRESSION_BUFFER_SIZE = 1 << 16;
+// number of blocks each decompression thread works on at once
+const int BGZF_BLOCKS_PER_THREAD = 256;
+
+/****************** DECOMPRESSION BUFFER ********************/
+
+DecompressionBuffer::DecompressionBuffer()
+  :
+#ifdef HAVE_HTSLIB
+  bgzf(NULL),
+#endif
+  plain(NULL), compression(CompressionType::UNKNOWN),
+  buffer(DECOMPRESSION_BUFFER_SIZE)
+{
+  setg(buffer.data(), buffer.data(), buffer.data());
+}
+
+DecompressionBuffer::~DecompressionBuffer() {
+  close();
+}
+
+bool DecompressionBuffer::open(const std::string& filePath, size_t threads) {
+  close();
+  compression = CompressedInputStream::detectCompression(filePath);
+  if (compression == CompressionType::UNKNOWN) {
+    return false;
+  }
+#ifdef HAVE_HTSLIB
+  bgzf = bgzf_open(filePath.c_str(), "r");
+  if (bgzf == NULL) {
+    compression = CompressionType::UNKNOWN;
+    return false;
+  }
+  if (compression == CompressionType::BGZF) {
+    if (threads == 0) {
+      threads = std::thread::hardware_concurrency();
+    }
+    if (threads > 1) {
+      bgzf_mt(bgzf, (int)threads, BGZF_BLOCKS_PER_THREAD);
+    }
+  }
+#else
+  if (compression != CompressionType::NONE) {
+    std::cerr << "[ERROR] - Compressed input requires htslib: "
+	      << filePath << std::endl;
+    compression = CompressionType::UNKNOWN;
+    return false;
+  }
+  plain = fopen(filePath.c_str(), "rb");
+  if (plain == NULL) {
+    compression = CompressionType::UNKNOWN;
+    return false;
+  }
+#endif
+  setg(buffer.data(), buffer.data(), buffer.data());
+  return true;
+}
+
+void DecompressionBuffer::close() {
+#ifdef HAVE_HTSLIB
+  if (bgzf != NULL) {
+    bgzf_close(bgzf);
+    bgzf = NULL;
+  }
+#endif
+  if (plain != NULL) {
+    fclose(plain);
+    plain = NULL;
+  }
+  compression = CompressionType::UNKNOWN;
+  setg(buffer.data(), buffer.data(), buffer.data());
+}
+
+bool DecompressionBuffer::isOpen() const {
+#ifdef HAVE_HTSLIB
+  if (bgzf != NULL) {
+    return true;
+  }
+#endif
+  return (plain != NULL);
+}
+
+CompressionType DecompressionBuffer::getCompression() const {
+  return compression;
+}
+
+DecompressionBuffer::int_type DecompressionBuffer::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  ssize_t n = 0;
+#ifdef HAVE_HTSLIB
+  if (bgzf != NULL) {
+    n = bgzf_read(bgzf, buffer.data(), buffer.size());
+  }
+#endif
+  if (plain != NULL) {
+    n = fread(buffer.data(), 1, buffer.size(), plain);
+  }
+  if (n <= 0) {
+    // read errors (n < 0) are reported as end of file
+    return traits_type::eof();
+  }
+  setg(buffer.data(), buffer.data(), buffer.data() + n);
+  return traits_type::to_int_type(*gptr());
+}
+
+/*************** CONSTRUCTORS AND DESTRUCTOR ****************/
+
+CompressedInputStream::CompressedInputStream()
+  : std::istream(NULL), buffer()
+{
+  rdbuf(&buffer);
+}
+
+CompressedInputStream::CompressedInputStream(const std::string& filePath, size_t threads)
+  : std::istream(NULL), buffer()
+{
+  rdbuf(&buffer);
+  open(filePath, threads);
+}
+
+/****************** IFSTREAM LIKE METHODS *******************/
+
+void CompressedInputStream::open(const std::string& filePath, size_t threads) {
+  if (buffer.open(filePath, threads)) {
+    clear();
+  } else {
+    setstate(std::ios_base::failbit);
+  }
+}
+
+bool CompressedInputStream::is_open() const {
+  return buffer.isOpen();
+}
+
+void CompressedInputStream::close() {
+  buffer.close();
+}
+
+/********************** QUERY METHODS ***********************/
+
+CompressionType CompressedInputStream::getCompression() const {
+  return buffer.getCompression();
+}
+
+CompressionType CompressedInputStream::detectCompression(const std::string& filePath) {
+  FILE* f = fopen(filePath.c_str(), "rb");
+  if (f == NULL) {
+    return CompressionType::UNKNOWN;
+  }
+  unsigned char magic[14];
+  size_t n = fread(magic, 1, sizeof(magic), f);
+  fclose(f);
+  if (n < 2 || magic[0] != 0x1f || magic[1] != 0x8b) {
+    return CompressionType::NONE;
+  }
+  // FLG.FEXTRA set and first extra subfield identified by 'B' 'C'
+  if (n == sizeof(magic) && (magic[3] & 0x04) != 0
+      && magic[12] == 'B' && magic[13] == 'C') {
+    return CompressionType::BGZF;
+  }
+  return CompressionType::GZIP;
+}
+
+/************************************************************/
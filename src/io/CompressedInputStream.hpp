@@ -0,0 +1,143 @@
+#ifndef COMPRESSED_INPUT_STREAM_H
+#define COMPRESSED_INPUT_STREAM_H
+
+#include <cstdio>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// HAVE_HTSLIB is set by configure (in config.h) when htslib is found
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_HTSLIB
+
+#include <htslib/bgzf.h>
+
+#endif
+
+/**
+ * \brief Compression of an input file as detected from its magic bytes
+ */
+enum class CompressionType { NONE, GZIP, BGZF, UNKNOWN };
+
+/**
+ * \brief Stream buffer that decompresses (if needed) the content of
+ * a file while it is read.
+ *
+ * When htslib is available every file is read through a \c BGZF
+ * handle, which transparently deals with plain, gzip and BGZF files.
+ * For BGZF files, whose blocks are compressed independently, a pool
+ * of threads may be attached to the handle so that the following
+ * blocks are decompressed in parallel while the current one is
+ * consumed. Without htslib only plain files can be read.
+ *
+ * \sa CompressedInputStream
+ */
+class DecompressionBuffer : public std::streambuf {
+ private:
+#ifdef HAVE_HTSLIB
+  BGZF* bgzf;
+#endif
+  FILE* plain;
+  CompressionType compression;
+  std::vector< char > buffer;
+
+ public:
+  DecompressionBuffer();
+  ~DecompressionBuffer();
+
+  DecompressionBuffer(const DecompressionBuffer&) = delete;
+  DecompressionBuffer& operator=(const DecompressionBuffer&) = delete;
+
+  /**
+   * \brief Opens a file for decompression
+   *
+   * \param filePath The path of the (possibly compressed) file
+   * \param threads The number of threads used to decompress BGZF
+   * files (0 uses all available cores, 1 disables the pool)
+   * \return \c true if the file has been opened
+   */
+  bool open(const std::string& filePath, size_t threads);
+  void close();
+  bool isOpen() const;
+  CompressionType getCompression() const;
+
+ protected:
+  int_type underflow();
+};
+
+/**
+ * \brief Input stream that can replace a \c std::ifstream on plain,
+ * gzip or BGZF compressed files.
+ *
+ * The compression is detected from the first bytes of the file (see
+ * detectCompression()) so the same code reads \c reads.fastq,
+ * \c reads.fastq.gz or a bgzip'ed file without any intermediate
+ * decompression to disk. Since the class is an \c std::istream all
+ * the existing parsers (e.g. <code>operator>></code> of FastqRead)
+ * can be used unchanged.
+ *
+ * Compressed streams can be read only sequentially: seeking is not
+ * supported, this is why random access readers (FastqMappedReader and
+ * FastqParallelReader) still require plain files.
+ *
+ * \code
+ * CompressedInputStream in("reads.fastq.gz");
+ * FastqRead read;
+ * while (in >> read) {
+ *   // ...
+ * }
+ * \endcode
+ *
+ * \sa DecompressionBuffer
+ */
+class CompressedInputStream : public std::istream {
+ private:
+  DecompressionBuffer buffer;
+
+ public:
+  // ---------------------------------------------------------
+  //                CONSTRUCTORS AND DESTRUCTOR
+  // ---------------------------------------------------------
+  CompressedInputStream();
+  /**
+   * \brief Creates the stream and opens the file
+   *
+   * \param filePath The path of the (possibly compressed) file
+   * \param threads The number of decompression threads used for
+   * BGZF files (0 uses all available cores)
+   */
+  explicit CompressedInputStream(const std::string& filePath, size_t threads = 0);
+
+  // ---------------------------------------------------------
+  //                  IFSTREAM LIKE METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Opens a file, the stream state is set to \c failbit if
+   * the file cannot be opened
+   */
+  void open(const std::string& filePath, size_t threads = 0);
+  bool is_open() const;
+  void close();
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Returns the compression of the currently open file
+   */
+  CompressionType getCompression() const;
+  /**
+   * \brief Detects the compression of a file from its magic bytes
+   *
+   * A gzip member starts with bytes \c 1f \c 8b, BGZF blocks are gzip
+   * members having the extra subfield \c BC. Files that cannot be
+   * opened are reported as CompressionType::UNKNOWN.
+   */
+  static CompressionType detectCompression(const std::string& filePath);
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "FastFormat.hpp"
+#include "CompressedInputStream.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -37,7 +38,7 @@ FastFormat::operator Reference() const {
 //                 'FORMAT' METHODS OVERRIDE
 // ---------------------------------------------------------
 string FastFormat::loadFromFile(const string &fileName) {
-  ifstream ifs(fileName.c_str(), ifstream::in);
+  CompressedInputStream ifs(fileName);
   char buffer[MAX_BUFFER_SIZE];
   while(!ifs.eof()) {
     ifs.getline(buffer,MAX_BUFFER_SIZE);
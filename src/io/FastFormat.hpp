@@ -19,7 +19,13 @@
  * content of the line is appended to the sequence string (the
  * new line character is discarded).
  *
+ * Files compressed with gzip or bgzip are decompressed while they
+ * are loaded. Multi record files (and large references) should be
+ * loaded with FastaStreamReader instead.
+ *
  * \sa Format
+ * \sa FastaStreamReader
+ * \sa CompressedInputStream
  */
 
 class FastFormat : public Format {
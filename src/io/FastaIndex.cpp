@@ -0,0 +1,260 @@
+#include "FastaIndex.hpp"
+#include "CompressedInputStream.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/******************** SUPPORT FUNCTIONS *********************/
+
+// Parses a (1-based) coordinate, commas are allowed as in samtools
+static bool parseCoordinate(const std::string& s, uint64_t& value) {
+  std::string digits;
+  for (char c : s) {
+    if (c == ',') {
+      continue;
+    }
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    digits.push_back(c);
+  }
+  if (digits.empty()) {
+    return false;
+  }
+  value = strtoull(digits.c_str(), NULL, 10);
+  return true;
+}
+
+/*********************** CONSTRUCTORS ***********************/
+
+FastaIndex::FastaIndex()
+  : file(), entries(), positions()
+{
+}
+
+/******************** INDEX MANAGEMENT **********************/
+
+bool FastaIndex::open(const std::string& fastaPath) {
+  close();
+  if (CompressedInputStream::detectCompression(fastaPath) != CompressionType::NONE) {
+    std::cerr << "[ERROR] - Indexed access requires an uncompressed fasta file: "
+	      << fastaPath << std::endl;
+    return false;
+  }
+  if (!file.open(fastaPath, lbio::mapped_file::random)) {
+    std::cerr << "[ERROR] - Unable to map " << fastaPath << std::endl;
+    return false;
+  }
+  std::string indexPath = fastaPath + ".fai";
+  if (std::ifstream(indexPath).good()) {
+    return loadIndex(indexPath);
+  }
+  if (!build(fastaPath)) {
+    return false;
+  }
+  // the index is usable even if it can not be saved
+  writeIndex(indexPath);
+  return true;
+}
+
+void FastaIndex::close() {
+  file.close();
+  entries.clear();
+  positions.clear();
+}
+
+bool FastaIndex::build(const std::string& fastaPath) {
+  lbio::mapped_file fasta;
+  if (!fasta.open(fastaPath, lbio::mapped_file::sequential)) {
+    std::cerr << "[ERROR] - Unable to map " << fastaPath << std::endl;
+    return false;
+  }
+  entries.clear();
+  positions.clear();
+  const char* begin = fasta.begin();
+  const char* end = fasta.end();
+  const char* cursor = begin;
+  FastaIndexEntry entry;
+  bool inSequence = false;
+  // set after a line shorter than the others, which must be the last
+  bool shortLine = false;
+  while (cursor < end) {
+    const char* newline = (const char*)memchr(cursor, '\n', end - cursor);
+    const char* lineEnd = (newline != NULL) ? newline : end;
+    const char* next = (newline != NULL) ? newline + 1 : end;
+    uint64_t bases = lineEnd - cursor;
+    if (bases > 0 && cursor[bases - 1] == '\r') {
+      --bases;
+    }
+    if (bases > 0 && *cursor == '>') {
+      if (inSequence) {
+	addEntry(entry);
+      }
+      const char* nameEnd = cursor + 1;
+      while (nameEnd < cursor + bases && *nameEnd != ' ' && *nameEnd != '\t') {
+	++nameEnd;
+      }
+      entry.name.assign(cursor + 1, nameEnd);
+      entry.length = 0;
+      entry.offset = next - begin;
+      entry.lineBases = entry.lineWidth = 0;
+      inSequence = true;
+      shortLine = false;
+    } else if (inSequence && bases == 0) {
+      shortLine = true;
+    } else if (inSequence) {
+      if (shortLine || (entry.lineBases > 0 && bases > entry.lineBases)) {
+	std::cerr << "[ERROR] - Different line length in sequence '"
+		  << entry.name << "'" << std::endl;
+	entries.clear();
+	positions.clear();
+	return false;
+      }
+      if (entry.lineBases == 0) {
+	entry.lineBases = bases;
+	entry.lineWidth = next - cursor;
+      } else if (bases < entry.lineBases) {
+	shortLine = true;
+      }
+      entry.length += bases;
+    }
+    cursor = next;
+  }
+  if (inSequence) {
+    addEntry(entry);
+  }
+  return true;
+}
+
+bool FastaIndex::loadIndex(const std::string& indexPath) {
+  std::ifstream ifs(indexPath);
+  if (!ifs.good()) {
+    std::cerr << "[ERROR] - Unable to open index " << indexPath << std::endl;
+    return false;
+  }
+  entries.clear();
+  positions.clear();
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream fields(line);
+    FastaIndexEntry entry;
+    if (!std::getline(fields, entry.name, '\t') ||
+	!(fields >> entry.length >> entry.offset >> entry.lineBases >> entry.lineWidth)) {
+      std::cerr << "[ERROR] - Malformed index line: " << line << std::endl;
+      entries.clear();
+      positions.clear();
+      return false;
+    }
+    addEntry(entry);
+  }
+  return true;
+}
+
+bool FastaIndex::writeIndex(const std::string& indexPath) const {
+  std::ofstream ofs(indexPath);
+  for (const FastaIndexEntry& entry : entries) {
+    ofs << entry.name << '\t' << entry.length << '\t' << entry.offset << '\t'
+	<< entry.lineBases << '\t' << entry.lineWidth << '\n';
+  }
+  return ofs.good();
+}
+
+/********************** QUERY METHODS ***********************/
+
+const std::vector< FastaIndexEntry >& FastaIndex::getEntries() const {
+  return entries;
+}
+
+const FastaIndexEntry* FastaIndex::find(const std::string& name) const {
+  std::unordered_map< std::string, size_t >::const_iterator it = positions.find(name);
+  return (it != positions.end()) ? &entries[it->second] : NULL;
+}
+
+bool FastaIndex::fetch(const std::string& name, uint64_t begin, uint64_t end,
+		       std::string& bases) const {
+  const FastaIndexEntry* entry = find(name);
+  if (entry == NULL || !file.is_open() || entry->lineBases == 0) {
+    return false;
+  }
+  end = std::min(end, entry->length);
+  if (begin >= end) {
+    return false;
+  }
+  bases.resize(end - begin);
+  char* out = &bases[0];
+  uint64_t p = begin;
+  while (p < end) {
+    uint64_t column = p % entry->lineBases;
+    uint64_t n = std::min(entry->lineBases - column, end - p);
+    uint64_t offset = entry->offset + (p / entry->lineBases) * entry->lineWidth + column;
+    if (offset + n > file.size()) {
+      std::cerr << "[ERROR] - Index does not match the fasta file" << std::endl;
+      bases.clear();
+      return false;
+    }
+    memcpy(out, file.data() + offset, n);
+    out += n;
+    p += n;
+  }
+  return true;
+}
+
+bool FastaIndex::fetch(const std::string& region, std::string& bases) const {
+  // names may contain ':', a full match has precedence
+  if (find(region) != NULL) {
+    return fetch(region, 0, UINT64_MAX, bases);
+  }
+  std::string name;
+  uint64_t begin, end;
+  if (!parseRegion(region, name, begin, end)) {
+    return false;
+  }
+  return fetch(name, begin, end, bases);
+}
+
+std::unique_ptr< Reference > FastaIndex::fetchReference(const std::string& region) const {
+  std::string bases;
+  if (!fetch(region, bases)) {
+    return std::unique_ptr< Reference >();
+  }
+  return Reference::createFromString(bases);
+}
+
+bool FastaIndex::parseRegion(const std::string& region, std::string& name,
+			     uint64_t& begin, uint64_t& end) {
+  size_t colon = region.rfind(':');
+  begin = 0;
+  end = UINT64_MAX;
+  if (colon == std::string::npos) {
+    name = region;
+    return !name.empty();
+  }
+  name = region.substr(0, colon);
+  std::string range = region.substr(colon + 1);
+  size_t dash = range.find('-');
+  uint64_t first;
+  if (!parseCoordinate(range.substr(0, dash), first) || first == 0) {
+    return false;
+  }
+  begin = first - 1;
+  if (dash != std::string::npos && !parseCoordinate(range.substr(dash + 1), end)) {
+    return false;
+  }
+  return !name.empty();
+}
+
+/********************* UTILITY METHODS **********************/
+
+void FastaIndex::addEntry(const FastaIndexEntry& entry) {
+  positions[entry.name] = entries.size();
+  entries.push_back(entry);
+}
+
+/************************************************************/
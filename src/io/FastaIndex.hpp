@@ -0,0 +1,153 @@
+#ifndef FASTA_INDEX_H
+#define FASTA_INDEX_H
+
+#include <core/Reference.hpp>
+
+#include <util/mapped_file.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * \brief One line of a fasta index (\c .fai) file.
+ */
+struct FastaIndexEntry {
+  /**
+   * \brief The name of the sequence
+   */
+  std::string name;
+  /**
+   * \brief The number of bases of the sequence
+   */
+  uint64_t length;
+  /**
+   * \brief The offset in the file of the first base
+   */
+  uint64_t offset;
+  /**
+   * \brief The number of bases on each line
+   */
+  uint64_t lineBases;
+  /**
+   * \brief The number of bytes of each line (line terminator included)
+   */
+  uint64_t lineWidth;
+};
+
+/**
+ * \brief Random access to the sequences of a fasta file through a
+ * <em>samtools faidx</em> compatible index.
+ *
+ * The index stores, for each sequence, its length, the offset of its
+ * first base and the (fixed) length of its lines, that is all what is
+ * needed to compute the position in the file of any base. The fasta
+ * file is memory mapped and fetching a region only touches the pages
+ * containing the region, the rest of the genome is never loaded.
+ *
+ * If the \c .fai file is not found next to the fasta file, open()
+ * builds the index (and tries to save it for later runs). Like
+ * samtools, sequences must have all lines (but the last) of the same
+ * length. Only uncompressed fasta files are supported.
+ *
+ * Regions use the samtools syntax: \c chr, \c chr:begin or
+ * \c chr:begin-end with 1-based, inclusive coordinates.
+ *
+ * \code
+ * FastaIndex index;
+ * if (index.open("genome.fa")) {
+ *   std::string bases;
+ *   index.fetch("chr2:10000-10500", bases);
+ * }
+ * \endcode
+ */
+class FastaIndex {
+ private:
+  lbio::mapped_file file;
+  std::vector< FastaIndexEntry > entries;
+  std::unordered_map< std::string, size_t > positions;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  FastaIndex();
+
+  // ---------------------------------------------------------
+  //                    INDEX MANAGEMENT
+  // ---------------------------------------------------------
+  /**
+   * \brief Opens a fasta file for random access
+   *
+   * The index is loaded from <tt>fastaPath + ".fai"</tt>, when such
+   * file does not exist it is built from the fasta file and saved.
+   *
+   * \param fastaPath The path of the (uncompressed) fasta file
+   * \return \c true if both the fasta file and its index are available
+   */
+  bool open(const std::string& fastaPath);
+  void close();
+  /**
+   * \brief Builds the index scanning the whole fasta file
+   *
+   * \return \c false if the file can not be read or if its lines
+   * do not have the length required by the index
+   */
+  bool build(const std::string& fastaPath);
+  /**
+   * \brief Loads an existing \c .fai file
+   */
+  bool loadIndex(const std::string& indexPath);
+  /**
+   * \brief Writes the index in \c .fai format
+   */
+  bool writeIndex(const std::string& indexPath) const;
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  const std::vector< FastaIndexEntry >& getEntries() const;
+  /**
+   * \brief Returns the entry of a sequence (\c NULL if the name is
+   * not in the index)
+   */
+  const FastaIndexEntry* find(const std::string& name) const;
+  /**
+   * \brief Copies the bases in [begin, end) of a sequence
+   *
+   * Coordinates are 0-based and \c end is clamped to the length of
+   * the sequence.
+   *
+   * \return \c false if the sequence is unknown, the file is not
+   * open or the range is empty
+   */
+  bool fetch(const std::string& name, uint64_t begin, uint64_t end,
+	     std::string& bases) const;
+  /**
+   * \brief Copies the bases of a region given in samtools syntax
+   */
+  bool fetch(const std::string& region, std::string& bases) const;
+  /**
+   * \brief Creates a Reference with the bases of a region
+   *
+   * \return The reference or an empty pointer if the region can not
+   * be fetched
+   */
+  std::unique_ptr< Reference > fetchReference(const std::string& region) const;
+
+  /**
+   * \brief Splits a region in samtools syntax into name and 0-based
+   * half open interval
+   *
+   * \return \c false if the coordinates are not valid numbers
+   */
+  static bool parseRegion(const std::string& region, std::string& name,
+			  uint64_t& begin, uint64_t& end);
+
+ private:
+  void addEntry(const FastaIndexEntry& entry);
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "FastaStreamReader.hpp"
+
+#include <core/DNAAlphabet2Bits.hpp>
+
+#include <algorithm>
+
+/******************** SUPPORT FUNCTIONS *********************/
+
+// Two bits code of each character (symbols other than ACGT are
+// mapped to A, as DNAAlphabet2Bits does)
+struct PackingTable {
+  uint8_t code[256];
+  PackingTable() {
+    for (size_t c = 0; c < 256; ++c) {
+      code[c] = (uint8_t)DNAAlphabet2Bits::charToInt((char)c);
+    }
+  }
+};
+
+static const PackingTable& packingTable() {
+  static PackingTable table;
+  return table;
+}
+
+// Returns the name of the record given its header line
+static std::string headerToName(const std::string& header) {
+  size_t end = header.find_first_of(" \t", 1);
+  return header.substr(1, (end == std::string::npos) ? std::string::npos : end - 1);
+}
+
+/*********************** CONSTRUCTORS ***********************/
+
+FastaStreamReader::FastaStreamReader()
+  : input(), line(), nextHeader(), nextHeaderOffset(0), bytesRead(0),
+    pending(false), records(), packed()
+{
+}
+
+FastaStreamReader::FastaStreamReader(const std::string& filePath)
+  : FastaStreamReader()
+{
+  openFile(filePath);
+}
+
+/*********************** LOAD METHODS ***********************/
+
+bool FastaStreamReader::openFile(const std::string& filePath) {
+  close();
+  input.open(filePath);
+  if (!input.is_open()) {
+    return false;
+  }
+  // skip everything before the first header
+  while (nextLine()) {
+    if (!line.empty() && line[0] == '>') {
+      nextHeader.swap(line);
+      pending = true;
+      break;
+    }
+  }
+  return true;
+}
+
+void FastaStreamReader::close() {
+  input.close();
+  input.clear();
+  pending = false;
+  bytesRead = 0;
+  nextHeaderOffset = 0;
+  records.clear();
+}
+
+bool FastaStreamReader::hasNextRecord() const {
+  return pending;
+}
+
+bool FastaStreamReader::nextRecord(std::string& name, std::string& bases) {
+  if (!beginRecord(name)) {
+    return false;
+  }
+  bases.clear();
+  while (nextLine()) {
+    if (!line.empty() && line[0] == '>') {
+      nextHeader.swap(line);
+      pending = true;
+      break;
+    }
+    bases.append(line);
+  }
+  endRecord(bases.size());
+  return true;
+}
+
+bool FastaStreamReader::nextRecord(std::string& name, CompressedSequence& sequence) {
+  if (!beginRecord(name)) {
+    return false;
+  }
+  const uint8_t* code = packingTable().code;
+  uint64_t n = 0;
+  while (nextLine()) {
+    if (!line.empty() && line[0] == '>') {
+      nextHeader.swap(line);
+      pending = true;
+      break;
+    }
+    // the buffer grows geometrically and is reused between records
+    size_t needed = (size_t)((n + line.size() + 3) / 4);
+    if (needed > packed.size()) {
+      packed.resize(std::max(needed, 2 * packed.size()), 0);
+    }
+    for (size_t i = 0; i < line.size(); ++i, ++n) {
+      uint8_t shift = 2 * (3 - (n & 0x03));
+      uint8_t& byte = packed[n >> 2];
+      if (shift == 6) {
+	// first base of the byte: bits left by previous records are cleared
+	byte = 0;
+      }
+      byte |= code[(uint8_t)line[i]] << shift;
+    }
+  }
+  sequence = CompressedSequence(packed.data(), n, 2);
+  endRecord(n);
+  return true;
+}
+
+/********************** QUERY METHODS ***********************/
+
+const std::vector< FastaRecordInfo >& FastaStreamReader::getRecords() const {
+  return records;
+}
+
+/********************* UTILITY METHODS **********************/
+
+bool FastaStreamReader::nextLine() {
+  uint64_t offset = bytesRead;
+  if (!std::getline(input, line)) {
+    return false;
+  }
+  bytesRead += line.size() + 1;
+  if (!line.empty() && line[line.size() - 1] == '\r') {
+    line.resize(line.size() - 1);
+  }
+  if (!line.empty() && line[0] == '>') {
+    nextHeaderOffset = offset;
+  }
+  return true;
+}
+
+bool FastaStreamReader::beginRecord(std::string& name) {
+  if (!pending) {
+    return false;
+  }
+  pending = false;
+  name = headerToName(nextHeader);
+  FastaRecordInfo info;
+  info.name = name;
+  info.fileOffset = nextHeaderOffset;
+  info.sequenceOffset = records.empty() ? 0 :
+    records.back().sequenceOffset + records.back().length;
+  info.length = 0;
+  records.push_back(info);
+  return true;
+}
+
+void FastaStreamReader::endRecord(uint64_t length) {
+  records.back().length = length;
+}
+
+/************************************************************/
@@ -0,0 +1,142 @@
+#ifndef FASTA_STREAM_READER_H
+#define FASTA_STREAM_READER_H
+
+#include "CompressedInputStream.hpp"
+
+#include <core/CompressedSequence.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Position and size of a record of a fasta file.
+ */
+struct FastaRecordInfo {
+  /**
+   * \brief The name of the record (the header up to the first
+   * white space, without the leading \c >)
+   */
+  std::string name;
+  /**
+   * \brief The offset (in the uncompressed file) of the header line
+   */
+  uint64_t fileOffset;
+  /**
+   * \brief The number of bases of all the previous records, i.e. the
+   * offset of the first base of the record when the records are
+   * concatenated
+   */
+  uint64_t sequenceOffset;
+  /**
+   * \brief The number of bases of the record
+   */
+  uint64_t length;
+};
+
+/**
+ * \brief Streaming reader for (possibly compressed) multi record
+ * fasta files.
+ *
+ * Differently from FastFormat, which merges the whole file in a single
+ * string, the records are returned one at a time with nextRecord(),
+ * so that only one record needs to be kept in memory. Bases can be
+ * returned either as a string or directly packed (two bits per base,
+ * see DNAAlphabet2Bits) into a CompressedSequence, in the latter case
+ * the unpacked record is never built and the memory required is one
+ * fourth of the number of bases. Symbols other than \c ACGT (e.g. \c N)
+ * can not be represented with two bits and are packed as \c A.
+ *
+ * For every record returned the reader keeps its name, its offsets
+ * and its length (see getRecords()).
+ *
+ * \code
+ * FastaStreamReader reader("genome.fa.gz");
+ * std::string name;
+ * CompressedSequence packed;
+ * while (reader.nextRecord(name, packed)) {
+ *   // ...
+ * }
+ * \endcode
+ *
+ * \sa FastaRecordInfo
+ * \sa FastFormat
+ */
+class FastaStreamReader {
+ private:
+  CompressedInputStream input;
+  std::string line;
+  // header of the next record (already read from the input)
+  std::string nextHeader;
+  uint64_t nextHeaderOffset;
+  uint64_t bytesRead;
+  bool pending;
+  std::vector< FastaRecordInfo > records;
+  std::vector< uint8_t > packed;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  FastaStreamReader();
+  /**
+   * \brief Creates the reader and opens the file
+   *
+   * \sa openFile()
+   */
+  explicit FastaStreamReader(const std::string& filePath);
+
+  // ---------------------------------------------------------
+  //                       LOAD METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Opens a (plain or gzip/BGZF compressed) fasta file
+   *
+   * Lines preceding the first header are ignored.
+   *
+   * \param filePath The path of the fasta file
+   * \return \c true if the file has been opened
+   */
+  bool openFile(const std::string& filePath);
+  void close();
+  /**
+   * \brief Checks whether the file contains more records
+   */
+  bool hasNextRecord() const;
+  /**
+   * \brief Loads the next record as a string of bases
+   *
+   * \param name Set to the name of the record
+   * \param bases Set to the bases of the record (line terminators
+   * are removed)
+   * \return \c false if there are no more records
+   */
+  bool nextRecord(std::string& name, std::string& bases);
+  /**
+   * \brief Loads the next record packing its bases (two bits per
+   * base) into a CompressedSequence
+   *
+   * \param name Set to the name of the record
+   * \param sequence Set to the packed bases of the record
+   * \return \c false if there are no more records
+   */
+  bool nextRecord(std::string& name, CompressedSequence& sequence);
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Returns the information on the records loaded so far
+   */
+  const std::vector< FastaRecordInfo >& getRecords() const;
+
+ private:
+  // ---------------------------------------------------------
+  //                     UTILITY METHODS
+  // ---------------------------------------------------------
+  bool nextLine();
+  bool beginRecord(std::string& name);
+  void endRecord(uint64_t length);
+};
+
+#endif
@@ -19,7 +19,7 @@ FastqFormat::~FastqFormat() {
 /*********************** LOAD METHODS ***********************/
 
 string FastqFormat::loadFromFile(const string &fileName) {
-  ifstream ifs(fileName.c_str(), ifstream::in);
+  CompressedInputStream ifs(fileName);
   char buffer[MAX_BUFFER_SIZE];
   while(!ifs.eof()) {
     ifs.getline(buffer,MAX_BUFFER_SIZE);
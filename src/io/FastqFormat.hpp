@@ -2,6 +2,7 @@
 #define FASTQ_FORMAT_H
 
 #include "../io.h"
+#include "CompressedInputStream.hpp"
 
 #include <string>
 #include <iostream>
@@ -32,7 +33,7 @@ class FastqFormat : public Format {
  private:
   std::string sequence;
   std::string header;
-  std::ifstream inFile;
+  CompressedInputStream inFile;
   FastqRead nextRead;
 
 
@@ -61,7 +62,8 @@ class FastqFormat : public Format {
    * The method doesn't perform any check on the availability
    * and on the content of the file, it simply returns a \c bool
    * indicating whether or not opening an input stream on the
-   * indicated file has been succesfull
+   * indicated file has been succesfull. The file may be plain or
+   * gzip/BGZF compressed (see CompressedInputStream).
    *
    * \param fileName The full path of the fastq file
    * \return \c true if opening an input stream on the file
@@ -4,11 +4,21 @@
 #include <fstream>
 #include <list>
 
+#include "CompressedInputStream.hpp"
 #include "FastqRead.hpp"
 
+/**
+ * \brief Loads reads from a fastq file in groups of M reads.
+ *
+ * Each call to getNextReads() copies the reads into a new \c std::list
+ * on the calling thread. For large inputs FastqReadPipeline should be
+ * preferred since it loads recycled batches in background.
+ *
+ * \sa FastqReadPipeline
+ */
 class FastqLazyLoader {
 private:
-  std::ifstream input;
+  CompressedInputStream input;
 public:
   explicit FastqLazyLoader(const string& filePath); 
   ~FastqLazyLoader();
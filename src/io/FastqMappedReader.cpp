@@ -0,0 +1,127 @@
+#include "FastqMappedReader.hpp"
+
+#include <cstring>
+#include <iostream>
+
+/******************** FASTQ RECORD VIEW *********************/
+
+void FastqRecordView::copyTo(FastqRead& read) const {
+  read.setHeader(header.data(), header.size());
+  read.setBases(bases.data(), bases.size());
+  read.setQualities(qualities.data(), qualities.size());
+}
+
+FastqRead FastqRecordView::toRead() const {
+  FastqRead read;
+  copyTo(read);
+  return read;
+}
+
+/*************** CONSTRUCTORS AND DESTRUCTOR ****************/
+
+FastqMappedReader::FastqMappedReader()
+  : file(), cursor(NULL), end(NULL), limit(NULL), malformed(false)
+{
+}
+
+FastqMappedReader::FastqMappedReader(const std::string& filePath)
+  : file(), cursor(NULL), end(NULL), limit(NULL), malformed(false)
+{
+  openFile(filePath);
+}
+
+/*********************** LOAD METHODS ***********************/
+
+bool FastqMappedReader::openFile(const std::string& filePath) {
+  close();
+  if (!file.open(filePath, lbio::mapped_file::sequential)) {
+    return false;
+  }
+  cursor = file.begin();
+  end = limit = file.end();
+  return true;
+}
+
+void FastqMappedReader::close() {
+  file.close();
+  cursor = end = limit = NULL;
+  malformed = false;
+}
+
+void FastqMappedReader::setRange(size_t begin, size_t stop) {
+  size_t n = file.size();
+  begin = (begin < n) ? begin : n;
+  stop = (stop < n) ? stop : n;
+  cursor = file.begin() + begin;
+  limit = file.begin() + ((stop > begin) ? stop : begin);
+  malformed = false;
+}
+
+bool FastqMappedReader::hasNextRead() const {
+  return (cursor < limit);
+}
+
+bool FastqMappedReader::nextRecord(FastqRecordView& record) {
+  // blank lines between records are tolerated
+  while (cursor < limit && (*cursor == '\n' || *cursor == '\r')) {
+    ++cursor;
+  }
+  if (cursor >= limit) {
+    return false;
+  }
+  const char* recordBegin = cursor;
+  lbio::char_span plus;
+  if ( *cursor != '@' ||
+       !nextLine(record.header) || !nextLine(record.bases) ||
+       !nextLine(plus) || plus.empty() || plus[0] != '+' ||
+       !nextLine(record.qualities) ) {
+    std::cerr << "[ERROR] - Malformed fastq record at byte "
+	      << (recordBegin - file.begin()) << "\n";
+    malformed = true;
+    cursor = limit = end;
+    return false;
+  }
+  return true;
+}
+
+FastqRead FastqMappedReader::getNextRead() {
+  FastqRecordView record;
+  if (nextRecord(record)) {
+    return record.toRead();
+  }
+  return FastqRead();
+}
+
+/********************** QUERY METHODS ***********************/
+
+bool FastqMappedReader::isMalformed() const {
+  return malformed;
+}
+
+size_t FastqMappedReader::tell() const {
+  return (size_t)(cursor - file.begin());
+}
+
+size_t FastqMappedReader::fileSize() const {
+  return file.size();
+}
+
+/********************* UTILITY METHODS **********************/
+
+bool FastqMappedReader::nextLine(lbio::char_span& line) {
+  if (cursor >= end) {
+    return false;
+  }
+  const char* eol = (const char*)memchr(cursor, '\n', end - cursor);
+  const char* next = (eol != NULL) ? eol + 1 : end;
+  eol = (eol != NULL) ? eol : end;
+  // strip the carriage return of DOS line terminators
+  if (eol > cursor && *(eol - 1) == '\r') {
+    --eol;
+  }
+  line = lbio::char_span(cursor, eol - cursor);
+  cursor = next;
+  return true;
+}
+
+/************************************************************/
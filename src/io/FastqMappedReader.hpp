@@ -0,0 +1,190 @@
+#ifndef FASTQ_MAPPED_READER_H
+#define FASTQ_MAPPED_READER_H
+
+#include "FastqRead.hpp"
+
+#include <util/char_span.hpp>
+#include <util/mapped_file.hpp>
+
+#include <string>
+
+/**
+ * \brief A lightweight view of a single fastq record.
+ *
+ * The three fields point directly into the buffer the record was
+ * parsed from (usually a memory mapped file) and are therefore valid
+ * only as long as such buffer is. The header includes the leading
+ * \c \@ character (exactly as it is stored by FastqRead) while line
+ * terminators (both \c \\n and \c \\r\\n ) are never part of the
+ * spans.
+ *
+ * \sa FastqMappedReader
+ */
+struct FastqRecordView {
+  /**
+   * \brief The header line (including the leading \c \@)
+   */
+  lbio::char_span header;
+  /**
+   * \brief The base sequence
+   */
+  lbio::char_span bases;
+  /**
+   * \brief The quality string
+   */
+  lbio::char_span qualities;
+
+  /**
+   * \brief Copies the record into an existing FastqRead
+   *
+   * The strings of the target read are reassigned in place, so
+   * reusing the same FastqRead for many records avoids most of the
+   * allocations.
+   *
+   * \param read The FastqRead to be (over)written
+   */
+  void copyTo(FastqRead& read) const;
+
+  /**
+   * \brief Materializes the record into a new FastqRead
+   *
+   * \return A FastqRead owning a copy of the record
+   */
+  FastqRead toRead() const;
+};
+
+/**
+ * \brief Zero-copy reader for (uncompressed) fastq files.
+ *
+ * The whole file is memory mapped and records are returned as
+ * FastqRecordView objects pointing into the mapping, no allocation or
+ * copy is performed while scanning the file. A FastqRead is built
+ * only when explicitly requested (see FastqRecordView::copyTo() and
+ * getNextRead()).
+ *
+ * The parsing rules are the same as FastqRead::operator>>() (four
+ * lines per record, single line sequence and quality), with the
+ * difference that malformed records (i.e. missing \c \@ or \c +
+ * lines) stop the scan and are reported by isMalformed().
+ *
+ * \code
+ * FastqMappedReader reader;
+ * if (reader.openFile("reads.fastq")) {
+ *   FastqRecordView rec;
+ *   while (reader.nextRecord(rec)) {
+ *     // use rec.bases, rec.qualities, ...
+ *   }
+ * }
+ * \endcode
+ *
+ * \sa FastqRecordView
+ * \sa FastqFormat
+ */
+class FastqMappedReader {
+ private:
+  lbio::mapped_file file;
+  const char* cursor;
+  const char* end;
+  const char* limit;
+  bool malformed;
+
+ public:
+  // ---------------------------------------------------------
+  //                CONSTRUCTORS AND DESTRUCTOR
+  // ---------------------------------------------------------
+  /**
+   * \brief Creates a reader not associated to any file
+   *
+   * \sa openFile()
+   */
+  FastqMappedReader();
+  /**
+   * \brief Creates a reader and maps the given file
+   *
+   * \param filePath The full path of the fastq file
+   */
+  explicit FastqMappedReader(const std::string& filePath);
+
+  // ---------------------------------------------------------
+  //                       LOAD METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Maps the fastq file for reading
+   *
+   * Any previously opened file is closed and the cursor is moved
+   * at the beginning of the new file.
+   *
+   * \param filePath The full path of the fastq file
+   * \return \c true if the file has been succesfully mapped
+   */
+  bool openFile(const std::string& filePath);
+  /**
+   * \brief Releases the mapping, all views previously returned
+   * become invalid
+   */
+  void close();
+  /**
+   * \brief Restricts the scan to the records starting in the byte
+   * range [begin, stop)
+   *
+   * Both offsets are expected to be aligned to the beginning of a
+   * record (e.g. as returned by FastqRead::splitReads()). A record
+   * starting before \c stop is always parsed completely, even if it
+   * ends after \c stop. Offsets are clamped to the file size.
+   *
+   * \param begin The offset of the first record to be parsed
+   * \param stop The offset where the scan stops
+   */
+  void setRange(size_t begin, size_t stop);
+  /**
+   * \brief Checks whether more characters are available
+   *
+   * \return \c true if the cursor did not reach the end of the file
+   * (or of the range set with setRange())
+   */
+  bool hasNextRead() const;
+  /**
+   * \brief Parses the next record
+   *
+   * \param record The view to be filled with the parsed record
+   * \return \c true if a record has been parsed, \c false when the
+   * end of the file is reached or a malformed record is found
+   */
+  bool nextRecord(FastqRecordView& record);
+  /**
+   * \brief Parses the next record and materializes it
+   *
+   * This is a convenience method equivalent to nextRecord()
+   * followed by FastqRecordView::toRead(), if no record is
+   * available an empty FastqRead is returned.
+   *
+   * \return The next read (or an empty one)
+   */
+  FastqRead getNextRead();
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Returns \c true if the last scan stopped on a malformed
+   * record
+   */
+  bool isMalformed() const;
+  /**
+   * \brief Returns the offset (in bytes from the beginning of the
+   * file) of the next record to be parsed
+   */
+  size_t tell() const;
+  /**
+   * \brief Returns the size (in bytes) of the mapped file
+   */
+  size_t fileSize() const;
+
+ private:
+  // ---------------------------------------------------------
+  //                      UTILITY METHODS
+  // ---------------------------------------------------------
+  bool nextLine(lbio::char_span& line);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "FastqParallelReader.hpp"
+
+#include <thread>
+
+// Remove when 'getFileLength' will be moved to new util sub-project
+size_t getFileLength(const std::string& filePath);
+
+/******************** SUPPORT FUNCTIONS *********************/
+
+// Parses all records of the block [begin, end) of the file
+size_t scanBlock(const std::string& filePath, size_t t, size_t begin, size_t end,
+		 const FastqRecordCallback& callback) {
+  size_t count = 0;
+  if (begin >= end) {
+    return count;
+  }
+  FastqMappedReader reader;
+  if (!reader.openFile(filePath)) {
+    return count;
+  }
+  reader.setRange(begin, end);
+  FastqRecordView record;
+  while (reader.nextRecord(record)) {
+    callback(t, record);
+    ++count;
+  }
+  return count;
+}
+
+/*********************** CONSTRUCTORS ***********************/
+
+FastqParallelReader::FastqParallelReader(const std::string& filePath, size_t T)
+  : filePath(filePath)
+{
+  this->offsets = FastqRead::splitReads(filePath, T);
+  this->fileLength = getFileLength(filePath);
+}
+
+/********************** QUERY METHODS ***********************/
+
+size_t FastqParallelReader::getThreadCount() const {
+  return offsets.size();
+}
+
+const std::vector< size_t >& FastqParallelReader::getOffsets() const {
+  return offsets;
+}
+
+std::pair< size_t, size_t > FastqParallelReader::getRange(size_t t) const {
+  size_t end = (t + 1 < offsets.size()) ? offsets[t + 1] : fileLength;
+  return std::make_pair(offsets[t], end);
+}
+
+/********************** PARALLEL SCAN ***********************/
+
+size_t FastqParallelReader::forEachRecord(const FastqRecordCallback& callback) const {
+  size_t T = offsets.size();
+  std::vector< size_t > counts(T, 0);
+  std::vector< std::thread > workers;
+  for (size_t t = 0; t < T; ++t) {
+    std::pair< size_t, size_t > range = getRange(t);
+    workers.push_back(std::thread([this, t, range, &callback, &counts]() {
+	  counts[t] = scanBlock(filePath, t, range.first, range.second, callback);
+	}));
+  }
+  size_t total = 0;
+  for (size_t t = 0; t < T; ++t) {
+    workers[t].join();
+    total += counts[t];
+  }
+  return total;
+}
+
+size_t FastqParallelReader::forEachRead(const FastqReadCallback& callback) const {
+  // one reusable read per worker
+  std::vector< FastqRead > reads(offsets.size());
+  return forEachRecord([&reads, &callback](size_t t, const FastqRecordView& record) {
+      record.copyTo(reads[t]);
+      callback(t, reads[t]);
+    });
+}
+
+size_t FastqParallelReader::forEachRecordInBlock(size_t b, const FastqRecordCallback& callback) const {
+  std::pair< size_t, size_t > range = getRange(b);
+  return scanBlock(filePath, b, range.first, range.second, callback);
+}
+
+/************************************************************/
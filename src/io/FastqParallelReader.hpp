@@ -0,0 +1,131 @@
+#ifndef FASTQ_PARALLEL_READER_H
+#define FASTQ_PARALLEL_READER_H
+
+#include "FastqMappedReader.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Callback invoked for each parsed record, the first argument
+ * is the index of the worker (in [0,T)) that parsed the record.
+ */
+typedef std::function<void(size_t, const FastqRecordView&)> FastqRecordCallback;
+
+/**
+ * \brief Callback invoked for each materialized read, the first
+ * argument is the index of the worker (in [0,T)) that loaded the read.
+ */
+typedef std::function<void(size_t, FastqRead&)> FastqReadCallback;
+
+/**
+ * \brief Parallel ingestion engine for fastq files.
+ *
+ * The input file is split into T blocks of roughly the same size
+ * using FastqRead::splitReads() (so that every block begins exactly at
+ * the beginning of a record), then T worker threads are started, each
+ * with its own FastqMappedReader restricted to its block, and every
+ * record is passed to the user supplied callback.
+ *
+ * The callback is invoked concurrently by different workers, it is
+ * therefore responsibility of the caller to synchronize any shared
+ * state. A typical pattern is to keep per worker state indexed by
+ * the worker index passed as first argument of the callback: since
+ * blocks are contiguous and assigned in order, concatenating per
+ * worker results from 0 to T-1 gives the same order as the input file.
+ *
+ * \code
+ * FastqParallelReader reader("reads.fastq", 4);
+ * std::vector<size_t> bases(reader.getThreadCount(), 0);
+ * reader.forEachRecord([&bases](size_t t, const FastqRecordView& r) {
+ *   bases[t] += r.bases.size();
+ * });
+ * \endcode
+ *
+ * Both forEachRecord() and forEachRead() are blocking: they return
+ * only when all workers have completed their block.
+ *
+ * The file can also be split in more blocks than threads, the caller
+ * then schedules the blocks itself with forEachRecordInBlock() (e.g.
+ * to write results in the order of the input, see
+ * taskKmerScoreReads()).
+ *
+ * \sa FastqRead::splitReads()
+ * \sa FastqMappedReader
+ */
+class FastqParallelReader {
+ private:
+  std::string filePath;
+  std::vector< size_t > offsets;
+  size_t fileLength;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  /**
+   * \brief Prepares the parallel scan of a fastq file
+   *
+   * The block offsets are computed once by the constructor, so the
+   * same object can be used for several scans of the file.
+   *
+   * \param filePath The path of the fastq file
+   * \param T The number of worker threads (0 is interpreted as 1)
+   */
+  FastqParallelReader(const std::string& filePath, size_t T);
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Returns the number of workers (and blocks)
+   */
+  size_t getThreadCount() const;
+  /**
+   * \brief Returns the offset of the first record of each block
+   */
+  const std::vector< size_t >& getOffsets() const;
+  /**
+   * \brief Returns the byte range [begin, end) assigned to worker t
+   */
+  std::pair< size_t, size_t > getRange(size_t t) const;
+
+  // ---------------------------------------------------------
+  //                     PARALLEL SCAN
+  // ---------------------------------------------------------
+  /**
+   * \brief Scans the file in parallel passing every record (as a
+   * zero-copy view) to the callback
+   *
+   * Views are valid only during the callback invocation.
+   *
+   * \param callback The function invoked for each record
+   * \return The total number of records parsed
+   */
+  size_t forEachRecord(const FastqRecordCallback& callback) const;
+  /**
+   * \brief Scans the file in parallel passing every record (as a
+   * FastqRead) to the callback
+   *
+   * Each worker reuses the same FastqRead object for all the records
+   * of its block, the callback may modify it but should copy it if
+   * it must outlive the invocation.
+   *
+   * \param callback The function invoked for each read
+   * \return The total number of reads loaded
+   */
+  size_t forEachRead(const FastqReadCallback& callback) const;
+  /**
+   * \brief Parses the records of block \c b only, in the calling
+   * thread
+   *
+   * \param b The block, in [0, getThreadCount())
+   * \param callback The function invoked for each record (with \c b
+   * as first argument)
+   * \return The number of records parsed
+   */
+  size_t forEachRecordInBlock(size_t b, const FastqRecordCallback& callback) const;
+};
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <core/ProbabilisticQuality.hpp>
 
+#include <algorithm>
 #include <fstream>
 
 // Remove when 'getFileLength' will be moved to new util sub-project
@@ -18,31 +19,64 @@ size_t getFileLength(const std::string& filePath) {
 }
 
 
-#define MAX_BUFFER_SIZE 4096
-
 /******************** SUPPORT FUNCTIONS *********************/
+
+// Returns the offset of the first record starting at or after 'off'.
+//
+// A line starting with '@' is not necessarily a header since quality
+// strings may start with '@' as well. The ambiguity is resolved by
+// looking at the two following lines: a header is followed by the
+// bases (which never start with '@') and then by the '+' separator,
+// while a quality line starting with '@' is followed by the header of
+// the next record. If no record starts after 'off' the length of the
+// file is returned.
 size_t nextReadPosition(std::ifstream& ifs, size_t off = 0) {
-  ifs.seekg(off);
-  size_t candidate = off;
-  char line[MAX_BUFFER_SIZE];
-  line[0] = 0;
-  // look for the first occurance of '@' at the beginning of a line
-  while(line[0] != '@' && !ifs.eof()) {
-    candidate = ifs.tellg();
-    ifs.getline(line, MAX_BUFFER_SIZE);
+  ifs.clear();
+  ifs.seekg(0, ifs.end);
+  size_t n = ifs.tellg();
+  if (off >= n) {
+    return n;
   }
-  // end of file reached and no reads have been found
-  if (ifs.eof()) {
-    return off;
+  // align to the beginning of a line
+  std::string line;
+  if (off > 0) {
+    ifs.seekg(off - 1);
+    if (ifs.get() != '\n') {
+      std::getline(ifs, line);
+    }
+  } else {
+    ifs.seekg(0);
+  }
+  // sliding window over three consecutive lines (and their offsets)
+  std::string lines[3];
+  size_t positions[3];
+  size_t available = 0;
+  while (true) {
+    while (available < 3 && !ifs.eof()) {
+      positions[available] = ifs.tellg();
+      if (!std::getline(ifs, lines[available])) {
+	break;
+      }
+      ++available;
+    }
+    if (available < 3) {
+      return n;
+    }
+    bool isHeader = ( !lines[0].empty() && lines[0][0] == '@' ) &&
+      ( lines[1].empty() || lines[1][0] != '@' ) &&
+      ( !lines[2].empty() && lines[2][0] == '+' );
+    if (isHeader) {
+      return positions[0];
+    }
+    // shift the window by one line
+    lines[0].swap(lines[1]);
+    lines[1].swap(lines[2]);
+    positions[0] = positions[1];
+    positions[1] = positions[2];
+    available = 2;
   }
-  size_t tmp = ifs.tellg();  
-  // read the next line to double check that '@' defines a proper start of a read
-  ifs.getline(line, MAX_BUFFER_SIZE);
-  candidate = (line[0] != '@') ? candidate : tmp;
-  return candidate;
 }
 
-
 /********************** CONSTRUCTOR(S) **********************/
 
 FastqRead::FastqRead() 
@@ -94,14 +128,15 @@ std::ostream& operator<<(std::ostream& os, const FastqRead& read) {
 /********************** STATIC METHODS **********************/
 
 std::vector< size_t > FastqRead::splitReads(const std::string& filePath, size_t T) {
-  std::vector< size_t > offsets(T);  
+  T = (T > 0) ? T : 1;
+  std::vector< size_t > offsets(T, 0);
   std::ifstream ifs(filePath);
   size_t n = getFileLength(filePath);
   size_t step = n / T;
-  offsets[0] = 0;
   size_t i = 1;
   while(i < T) {
-    offsets[i] = nextReadPosition(ifs, offsets[i-1] + step);
+    // offsets are kept non decreasing, a block may therefore be empty
+    offsets[i] = nextReadPosition(ifs, std::max(offsets[i-1], i * step));
     ++i;
   }
   return offsets;
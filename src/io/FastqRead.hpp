@@ -103,6 +103,25 @@ class FastqRead : public Read {
   // ---------------------------------------------------------
   //                        STATIC METHODS
   // ---------------------------------------------------------
+  /**
+   * \brief Splits a fastq file into T blocks of (roughly) the same
+   * size in bytes.
+   *
+   * The returned vector contains T non decreasing offsets, the i-th
+   * offset is the position of the first record of the i-th block
+   * (the first offset is always 0), the i-th block ends where the
+   * (i+1)-th begins (the last one at the end of the file). Offsets
+   * are always aligned to the beginning of a record, also when the
+   * quality string of the previous record starts with \c \@.
+   * Blocks may be empty when the file contains fewer records than
+   * requested blocks.
+   *
+   * \param filePath The path of the fastq file
+   * \param T The number of blocks
+   * \return The offsets of the beginning of each block
+   *
+   * \sa FastqParallelReader
+   */
   static std::vector< size_t > splitReads(const std::string& filePath, size_t T);
 
   // ---------------------------------------------------------
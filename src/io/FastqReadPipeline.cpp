@@ -0,0 +1,232 @@
+#include "FastqReadPipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+/******************** SUPPORT FUNCTIONS *********************/
+
+// Waits a little longer at each failed attempt: yield for the first
+// attempts then sleep, so that idle threads do not burn a core
+static void backoff(size_t& attempt) {
+  if (attempt < 64) {
+    std::this_thread::yield();
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+  ++attempt;
+}
+
+// Removes the carriage return of DOS line terminators
+static void chompCarriageReturn(std::string& line) {
+  if (!line.empty() && line[line.size() - 1] == '\r') {
+    line.resize(line.size() - 1);
+  }
+}
+
+/********************* FASTQ READ BATCH *********************/
+
+FastqReadBatch::FastqReadBatch(size_t capacity, size_t bytesHint)
+  : data(bytesHint), used(0), offsets(3 * capacity + 1, 0), count(0),
+    maxCount(capacity), firstIndex(0)
+{
+}
+
+size_t FastqReadBatch::size() const {
+  return count;
+}
+
+size_t FastqReadBatch::capacity() const {
+  return maxCount;
+}
+
+bool FastqReadBatch::empty() const {
+  return (count == 0);
+}
+
+bool FastqReadBatch::full() const {
+  return (count >= maxCount);
+}
+
+size_t FastqReadBatch::getFirstIndex() const {
+  return firstIndex;
+}
+
+FastqRecordView FastqReadBatch::getRecord(size_t i) const {
+  const size_t* o = &offsets[3 * i];
+  const char* base = data.data();
+  FastqRecordView record;
+  record.header = lbio::char_span(base + o[0], o[1] - o[0]);
+  record.bases = lbio::char_span(base + o[1], o[2] - o[1]);
+  record.qualities = lbio::char_span(base + o[2], o[3] - o[2]);
+  return record;
+}
+
+void FastqReadBatch::copyTo(size_t i, FastqRead& read) const {
+  getRecord(i).copyTo(read);
+}
+
+void FastqReadBatch::clear(size_t first) {
+  used = 0;
+  count = 0;
+  offsets[0] = 0;
+  firstIndex = first;
+}
+
+bool FastqReadBatch::append(const char* header, size_t headerLength,
+			    const char* bases, size_t basesLength,
+			    const char* qualities, size_t qualitiesLength) {
+  if (full()) {
+    return false;
+  }
+  size_t total = headerLength + basesLength + qualitiesLength;
+  std::vector< char > previous;
+  if (used + total > data.size()) {
+    // geometric growth, the buffer is never shrunk; the previous buffer
+    // is released only after the copy since the fields may be views of
+    // records of this batch
+    previous.resize(std::max(2 * data.size(), used + total));
+    if (used > 0) {
+      memcpy(previous.data(), data.data(), used);
+    }
+    data.swap(previous);
+  }
+  size_t* o = &offsets[3 * count];
+  appendField(header, headerLength);
+  o[1] = used;
+  appendField(bases, basesLength);
+  o[2] = used;
+  appendField(qualities, qualitiesLength);
+  o[3] = used;
+  ++count;
+  return true;
+}
+
+bool FastqReadBatch::append(const FastqRecordView& record) {
+  return append(record.header.data(), record.header.size(),
+		record.bases.data(), record.bases.size(),
+		record.qualities.data(), record.qualities.size());
+}
+
+void FastqReadBatch::appendField(const char* field, size_t n) {
+  if (n > 0) {
+    memcpy(data.data() + used, field, n);
+  }
+  used += n;
+}
+
+/*************** CONSTRUCTORS AND DESTRUCTOR ****************/
+
+FastqReadPipeline::FastqReadPipeline(const std::string& filePath, size_t batchSize,
+				     size_t poolSize)
+  : input(filePath), pool(), freeBatches(poolSize), filledBatches(poolSize),
+    finished(false), stopRequested(false), malformed(false)
+{
+  batchSize = (batchSize > 0) ? batchSize : 1;
+  poolSize = (poolSize > 0) ? poolSize : 1;
+  for (size_t i = 0; i < poolSize; ++i) {
+    pool.push_back(new FastqReadBatch(batchSize));
+    freeBatches.try_push(pool.back());
+  }
+  reader = std::thread(&FastqReadPipeline::readerLoop, this);
+}
+
+FastqReadPipeline::~FastqReadPipeline() {
+  stopRequested = true;
+  if (reader.joinable()) {
+    reader.join();
+  }
+  for (FastqReadBatch* batch : pool) {
+    delete batch;
+  }
+}
+
+/********************* CONSUMER METHODS *********************/
+
+FastqReadBatch* FastqReadPipeline::nextBatch() {
+  FastqReadBatch* batch = NULL;
+  size_t attempt = 0;
+  while (!filledBatches.try_pop(batch)) {
+    // the reader publishes its last batch before setting the flag,
+    // so a second attempt is needed to not miss it
+    if (finished.load() && !filledBatches.try_pop(batch)) {
+      return NULL;
+    }
+    if (batch != NULL) {
+      break;
+    }
+    backoff(attempt);
+  }
+  return batch;
+}
+
+void FastqReadPipeline::releaseBatch(FastqReadBatch* batch) {
+  if (batch == NULL) {
+    return;
+  }
+  // the pool has room for all the batches, so this never fails
+  freeBatches.try_push(batch);
+}
+
+/********************** QUERY METHODS ***********************/
+
+bool FastqReadPipeline::isMalformed() const {
+  return malformed.load();
+}
+
+/********************** READER THREAD ***********************/
+
+void FastqReadPipeline::readerLoop() {
+  std::string header, bases, plus, qualities;
+  size_t readIndex = 0;
+  bool eof = !input.good();
+  while (!eof && !stopRequested.load()) {
+    FastqReadBatch* batch = NULL;
+    size_t attempt = 0;
+    while (!freeBatches.try_pop(batch)) {
+      if (stopRequested.load()) {
+	finished = true;
+	return;
+      }
+      backoff(attempt);
+    }
+    batch->clear(readIndex);
+    while (!batch->full()) {
+      if (!std::getline(input, header)) {
+	eof = true;
+	break;
+      }
+      chompCarriageReturn(header);
+      if (header.empty()) {
+	continue;
+      }
+      // the record must be complete and framed by '@' and '+' (as
+      // FastqMappedReader requires)
+      if (header[0] != '@' || !std::getline(input, bases) ||
+	  !std::getline(input, plus) || plus.empty() || plus[0] != '+' ||
+	  !std::getline(input, qualities)) {
+	std::cerr << "[ERROR] - Malformed fastq record " << readIndex << "\n";
+	malformed = true;
+	eof = true;
+	break;
+      }
+      chompCarriageReturn(bases);
+      chompCarriageReturn(qualities);
+      batch->append(header.data(), header.size(), bases.data(), bases.size(),
+		    qualities.data(), qualities.size());
+      ++readIndex;
+    }
+    if (batch->empty()) {
+      freeBatches.try_push(batch);
+    } else {
+      size_t attempt = 0;
+      while (!filledBatches.try_push(batch)) {
+	backoff(attempt);
+      }
+    }
+  }
+  finished = true;
+}
+
+/************************************************************/
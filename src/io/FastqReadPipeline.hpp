@@ -0,0 +1,215 @@
+#ifndef FASTQ_READ_PIPELINE_H
+#define FASTQ_READ_PIPELINE_H
+
+#include "CompressedInputStream.hpp"
+#include "FastqMappedReader.hpp"
+
+#include <structures/bounded_queue.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief A batch of fastq records stored contiguously.
+ *
+ * Headers, bases and qualities of all the records in the batch are
+ * stored back to back in one single character buffer, while a second
+ * array keeps the offsets of each field. The batch has a fixed
+ * capacity (in records) and is meant to be recycled: clear() resets
+ * the content but keeps the allocated memory, so that once the
+ * buffers have grown to fit a typical batch no more allocations are
+ * performed.
+ *
+ * Records are accessed as FastqRecordView objects pointing into the
+ * batch buffer, they remain valid until the batch is cleared or
+ * modified.
+ *
+ * \sa FastqReadPipeline
+ */
+class FastqReadBatch {
+ private:
+  std::vector< char > data;
+  size_t used;
+  // 3 offsets per record (header, bases, qualities) plus the end
+  std::vector< size_t > offsets;
+  size_t count;
+  size_t maxCount;
+  size_t firstIndex;
+
+ public:
+  // ---------------------------------------------------------
+  //                       CONSTRUCTORS
+  // ---------------------------------------------------------
+  /**
+   * \brief Creates an empty batch for (at most) \c capacity records
+   *
+   * \param capacity The maximum number of records in the batch
+   * \param bytesHint The initial size (in bytes) of the buffer
+   */
+  FastqReadBatch(size_t capacity, size_t bytesHint = 0);
+
+  // ---------------------------------------------------------
+  //                     QUERY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Returns the number of records stored in the batch
+   */
+  size_t size() const;
+  /**
+   * \brief Returns the maximum number of records of the batch
+   */
+  size_t capacity() const;
+  bool empty() const;
+  bool full() const;
+  /**
+   * \brief Returns the index (in the input file) of the first record
+   * of the batch
+   */
+  size_t getFirstIndex() const;
+  /**
+   * \brief Returns a view of the i-th record of the batch
+   *
+   * \param i The index of the record in [0,size())
+   * \return The view of the record
+   */
+  FastqRecordView getRecord(size_t i) const;
+  /**
+   * \brief Copies the i-th record into an existing FastqRead
+   */
+  void copyTo(size_t i, FastqRead& read) const;
+
+  // ---------------------------------------------------------
+  //                    MODIFY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Removes all records (allocated memory is kept)
+   *
+   * \param first The index in the input file of the next record
+   * that will be appended
+   */
+  void clear(size_t first = 0);
+  /**
+   * \brief Appends a record to the batch
+   *
+   * The fields may be views of records of this batch.
+   *
+   * \return \c false if the batch is already full
+   */
+  bool append(const char* header, size_t headerLength,
+	      const char* bases, size_t basesLength,
+	      const char* qualities, size_t qualitiesLength);
+  /**
+   * \brief Appends a copy of a record view to the batch
+   *
+   * \return \c false if the batch is already full
+   */
+  bool append(const FastqRecordView& record);
+
+ private:
+  void appendField(const char* field, size_t n);
+};
+
+/**
+ * \brief Pipelined fastq loader based on a bounded pool of recycled
+ * batches.
+ *
+ * A background reader thread parses the input file and fills
+ * FastqReadBatch objects taken from a fixed size pool, filled batches
+ * are published on a lock free bounded queue from which one or more
+ * consumers pull them with nextBatch(). When a consumer is done with a
+ * batch it must give it back with releaseBatch() so that the reader
+ * can reuse it. Since the pool is bounded the reader never runs more
+ * than \c poolSize batches ahead of the consumers, while I/O and
+ * parsing overlap with the processing of the batches already loaded.
+ *
+ * \code
+ * FastqReadPipeline pipeline("reads.fastq", 4096, 8);
+ * FastqReadBatch* batch;
+ * while ((batch = pipeline.nextBatch()) != NULL) {
+ *   for (size_t i = 0; i < batch->size(); ++i) {
+ *     FastqRecordView r = batch->getRecord(i);
+ *     // ...
+ *   }
+ *   pipeline.releaseBatch(batch);
+ * }
+ * \endcode
+ *
+ * This class replaces FastqLazyLoader, which copies each read into a
+ * new \c std::list node and performs no I/O while the caller works.
+ *
+ * \sa FastqReadBatch
+ * \sa FastqLazyLoader
+ */
+class FastqReadPipeline {
+ private:
+  CompressedInputStream input;
+  std::vector< FastqReadBatch* > pool;
+  lbio::bounded_queue< FastqReadBatch* > freeBatches;
+  lbio::bounded_queue< FastqReadBatch* > filledBatches;
+  std::atomic< bool > finished;
+  std::atomic< bool > stopRequested;
+  std::atomic< bool > malformed;
+  std::thread reader;
+
+ public:
+  // ---------------------------------------------------------
+  //                CONSTRUCTORS AND DESTRUCTOR
+  // ---------------------------------------------------------
+  /**
+   * \brief Opens the file and starts the reader thread
+   *
+   * \param filePath The path of the (possibly compressed) fastq file
+   * \param batchSize The number of records per batch
+   * \param poolSize The number of batches in the pool
+   */
+  FastqReadPipeline(const std::string& filePath, size_t batchSize = 4096,
+		    size_t poolSize = 8);
+  /**
+   * \brief Stops the reader thread (if still running) and frees
+   * all the batches, batches must not be used afterwards
+   */
+  ~FastqReadPipeline();
+
+  FastqReadPipeline(const FastqReadPipeline&) = delete;
+  FastqReadPipeline& operator=(const FastqReadPipeline&) = delete;
+
+  // ---------------------------------------------------------
+  //                    CONSUMER METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Returns the next filled batch, waiting for the reader
+   * if none is available yet
+   *
+   * Batches are returned in file order (when more consumers are
+   * used each batch is returned to exactly one of them). The
+   * returned batch is owned by the pipeline and must be given back
+   * with releaseBatch().
+   *
+   * \return The next batch or \c NULL when the whole file has been
+   * consumed (or a malformed record has been found, see
+   * isMalformed())
+   */
+  FastqReadBatch* nextBatch();
+  /**
+   * \brief Gives a batch back to the pipeline for reuse
+   *
+   * \param batch A batch obtained from nextBatch()
+   */
+  void releaseBatch(FastqReadBatch* batch);
+
+  // ---------------------------------------------------------
+  //                      QUERY METHODS
+  // ---------------------------------------------------------
+  /**
+   * \brief Returns \c true if the reader stopped on a malformed (or
+   * truncated) record, the records before it are still returned
+   */
+  bool isMalformed() const;
+
+ private:
+  void readerLoop();
+};
+
+#endif
@@ -23,10 +23,48 @@ void testFastqRead(const std::string& fastqPath) {
   ifs.close();
 }
 
+void testFastqMappedReader(const std::string& fastqPath) {
+  logInfo("Mapped fastq test on file " + fastqPath);
+
+  FastqMappedReader reader;
+  if (!reader.openFile(fastqPath)) {
+    logInfo("Unable to map " + fastqPath);
+    return;
+  }
+  size_t count = 0;
+  size_t bases = 0;
+  FastqRecordView record;
+  while (reader.nextRecord(record)) {
+    bases += record.bases.size();
+    ++count;
+  }
+  logInfo(std::to_string(count) + " reads, " + std::to_string(bases) + " bases");
+}
+
+void testFastaStreamReader(const std::string& fastaPath) {
+  logInfo("Streaming fasta test on file " + fastaPath);
+
+  FastaStreamReader reader;
+  if (!reader.openFile(fastaPath)) {
+    logInfo("Unable to open " + fastaPath);
+    return;
+  }
+  std::string name;
+  CompressedSequence packed;
+  while (reader.nextRecord(name, packed)) {
+    logInfo(name + ": " + std::to_string(packed.getElementCount()) + " bases");
+  }
+}
+
 int main(int argc, char** argv) {
 
-  testFastqRead(argc > 1 ? std::string {argv[1]} :
-		std::string {"/tmp/in.fastq"} );
+  std::string fastqPath = (argc > 1) ? std::string {argv[1]} :
+    std::string {"/tmp/in.fastq"};
+  testFastqRead(fastqPath);
+  testFastqMappedReader(fastqPath);
+  if (argc > 2) {
+    testFastaStreamReader(argv[2]);
+  }
     
   return 0;
 }
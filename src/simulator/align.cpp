@@ -23,6 +23,13 @@ evaluateAlignmentScore(const Options& opts)
   
   // load SAM
   std::list<AlignPair> aligns;
-  loadAlignFromSAM(opts.inputSAM, aligns);
+  if (opts.inputRegion.empty())
+    {
+      loadAlignFromSAM(opts.inputSAM, aligns);
+    }
+  else
+    {
+      loadAlignFromSAM(opts.inputSAM, opts.inputRegion, aligns);
+    }
   std::cout << aligns.size() << std::endl;
 }
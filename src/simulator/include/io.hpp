@@ -8,5 +8,9 @@ typedef std::pair< std::string, int64_t> AlignPair;
 
 std::string loadFromFile(const std::string &fileName);
 void loadAlignFromSAM(const std::string& filePath, std::list<AlignPair>& aligns);
+// only the alignments overlapping the region (e.g. "chr1:1000-2000"),
+// the file must be indexed (.bai or .csi)
+void loadAlignFromSAM(const std::string& filePath, const std::string& region,
+		      std::list<AlignPair>& aligns);
 
 #endif
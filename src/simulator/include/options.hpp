@@ -22,6 +22,7 @@ struct Options {
 
   std::string inputReference; // -i
   std::string inputSAM; // -S
+  std::string inputRegion; // -R
   std::string outputDistribution; // -D
   std::string outputCDF; //-C
 
@@ -46,3 +46,39 @@ loadAlignFromSAM(const std::string& filePath, std::list<AlignPair>& aligns)
   bam_hdr_destroy(head);
   sam_close(inFile);
 }
+
+void
+loadAlignFromSAM(const std::string& filePath, const std::string& region,
+		 std::list<AlignPair>& aligns)
+{
+  aligns.clear();
+  htsFile* inFile = sam_open(filePath.c_str(), "r");
+  if (inFile == NULL) {
+    return;
+  }
+  bam_hdr_t* head = sam_hdr_read(inFile);
+  hts_idx_t* index = sam_index_load(inFile, filePath.c_str());
+  if (head == NULL || index == NULL) {
+    if (head != NULL) {
+      bam_hdr_destroy(head);
+    }
+    sam_close(inFile);
+    return;
+  }
+  hts_itr_t* iter = sam_itr_querys(index, head, region.c_str());
+  bam1_t* content = bam_init1();
+
+  while(iter != NULL && sam_itr_next(inFile, iter, content) >= 0) {
+    AlignPair a;
+    a.second = content->core.pos;
+    aligns.push_back(a);
+  }
+
+  bam_destroy1(content);
+  if (iter != NULL) {
+    hts_itr_destroy(iter);
+  }
+  hts_idx_destroy(index);
+  bam_hdr_destroy(head);
+  sam_close(inFile);
+}
@@ -94,6 +94,7 @@ setDefualtParams() {
     
   Options::opts.inputReference = "";
   Options::opts.inputSAM = "";
+  Options::opts.inputRegion = "";
   Options::opts.outputDistribution = "";
   Options::opts.outputCDF = "";
   Options::opts.approxLevel = -1;
@@ -180,7 +181,7 @@ void parseArguments(int argc, char** argv) {
   setDefualtParams();
   
   char c;
-  while ((c = getopt(argc, argv, "N:m:M:e:P:c:d:k:a:i:S:D:C:A:O:B:f:t:phv")) != -1) {
+  while ((c = getopt(argc, argv, "N:m:M:e:P:c:d:k:a:i:S:R:D:C:A:O:B:f:t:phv")) != -1) {
     switch(c) {
     case 'N':
       Options::opts.N = atoi(optarg);
@@ -214,6 +215,9 @@ void parseArguments(int argc, char** argv) {
     case 'S':
       Options::opts.inputSAM = optarg;
       break;
+    case 'R':
+      Options::opts.inputRegion = optarg;
+      break;
     case 'D':
       Options::opts.outputDistribution = optarg;
       break;
@@ -298,6 +302,9 @@ parseArgumentsBoost(int argc, char** argv) {
     ("input-sam,S", po::value<std::string>(&Options::opts.inputSAM), // -S, --input-sam
      "Sam alignment input file")
 
+    ("region,R", po::value<std::string>(&Options::opts.inputRegion), // -R, --region
+     "Only alignments overlapping the region (e.g. chr1:1000-2000) of the indexed input SAM/BAM")
+
     ("output-density,D", po::value<std::string>(&Options::opts.outputDistribution), // -D, --output-density
      "File were density will be written. If left unspecified, no output will be produced")
 
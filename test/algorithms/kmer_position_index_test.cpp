@@ -0,0 +1,205 @@
+// kmer_position_index_test.cpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define BOOST_TEST_MODULE kmer_position_index_test
+#include <boost/test/included/unit_test.hpp>
+using namespace boost::unit_test;
+
+#include <algorithms/KmerPositionIndex.hpp>
+#include <core/Reference.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef KmerPositionIndex< uint32_t > Index;
+typedef std::map< uint64_t, std::vector< uint32_t > > NaiveIndex;
+
+const std::string IndexFile = "kmer_position_index_test.kidx";
+
+// naive index: the position of a k-mer follows its last base, k-mers
+// with bases other than A, C, G and T are skipped
+NaiveIndex naive_index(const std::string& s, size_t k) {
+  NaiveIndex m;
+  for (size_t i = 0; i + k <= s.size(); ++i) {
+    uint64_t code = 0;
+    bool valid = true;
+    for (size_t j = 0; j < k; ++j) {
+      size_t c = std::string("ACGT").find(s[i + j]);
+      valid = valid && (c != std::string::npos);
+      code = (code << 2) | (c & 3);
+    }
+    if (valid) {
+      m[code].push_back((uint32_t)(i + k));
+    }
+  }
+  return m;
+}
+
+std::string random_bases(std::mt19937_64& g, size_t n) {
+  std::string s;
+  for (size_t i = 0; i < n; ++i) {
+    s += (g() % 97 == 0) ? 'N' : "ACGT"[g() % 4];
+  }
+  return s;
+}
+
+template <typename I>
+bool same_index(const I& index, const NaiveIndex& m, size_t k, std::mt19937_64& g) {
+  size_t positions = 0;
+  for (const auto& e : m) {
+    typename I::Positions p = index.getPositions(e.first);
+    if (std::vector< uint32_t >(p.begin(), p.end()) != e.second) {
+      return false;
+    }
+    positions += e.second.size();
+  }
+  // random k-mers (most of them not in the reference)
+  uint64_t mask = (k == 32) ? ~(uint64_t)0 : (((uint64_t)1 << (2 * k)) - 1);
+  for (size_t i = 0; i < 1000; ++i) {
+    uint64_t kmer = g() & mask;
+    NaiveIndex::const_iterator it = m.find(kmer);
+    if (index.count(kmer) != ((it == m.end()) ? 0 : it->second.size())) {
+      return false;
+    }
+  }
+  return index.size() == m.size() && index.getPositionCount() == positions;
+}
+
+std::string read_file(const std::string& path) {
+  std::ifstream ifs(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::string& content) {
+  std::ofstream ofs(path, std::ios::binary);
+  ofs.write(content.data(), content.size());
+}
+
+BOOST_AUTO_TEST_CASE( built_index_matches_naive_index )
+{
+  std::mt19937_64 g(37);
+  for (size_t n : {0, 1, 7, 4097, 100000}) {
+    std::string s = random_bases(g, n);
+    // a low complexity region gives buckets much larger than the others
+    if (n > 1000) {
+      s.replace(n / 2, 500, std::string(500, 'A'));
+    }
+    Reference ref(s);
+    for (size_t k : {1, 2, 5, 12, 20, 32}) {
+      NaiveIndex m = naive_index(s, k);
+      for (size_t threads : {1, 2, 3, 8}) {
+	Index index(ref, k, threads);
+	BOOST_TEST( index.getK() == k );
+	BOOST_TEST( same_index(index, m, k, g) );
+      }
+      KmerPositionIndex< uint64_t > wide(ref, k, 3);
+      BOOST_TEST( same_index(wide, m, k, g) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( mapped_index_matches_written_index )
+{
+  std::mt19937_64 g(41);
+  for (size_t n : {0, 10, 1000, 50000}) {
+    std::string s = random_bases(g, n);
+    Reference ref(s);
+    for (size_t k : {3, 11, 32}) {
+      Index built(ref, k, 2);
+      KmerIndexReference stamp = { n, 1234567890, g() };
+      BOOST_TEST( built.writeToFile(IndexFile, stamp) );
+      Index mapped;
+      BOOST_TEST( mapped.mapFile(IndexFile) );
+      BOOST_TEST( mapped.isMapped() );
+      BOOST_TEST( mapped.getK() == k );
+      BOOST_TEST( mapped.getReference().size == stamp.size );
+      BOOST_TEST( mapped.getReference().modified == stamp.modified );
+      BOOST_TEST( mapped.getReference().checksum == stamp.checksum );
+      BOOST_TEST( same_index(mapped, naive_index(s, k), k, g) );
+      // the mapping is moved with the index
+      Index moved = std::move(mapped);
+      BOOST_TEST( same_index(moved, naive_index(s, k), k, g) );
+    }
+  }
+  std::remove(IndexFile.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( invalid_files_are_rejected )
+{
+  std::mt19937_64 g(43);
+  std::string s = random_bases(g, 20000);
+  Index built(Reference(s), 12, 1);
+  BOOST_TEST( built.writeToFile(IndexFile) );
+  std::string content = read_file(IndexFile);
+  KmerIndexHeader header;
+  memcpy(&header, content.data(), sizeof(header));
+
+  std::vector< std::string > invalid;
+  // truncated file and header
+  invalid.push_back(content.substr(0, content.size() - 1));
+  invalid.push_back(content.substr(0, sizeof(header) - 1));
+  // wrong magic number
+  invalid.push_back(content);
+  invalid.back()[0] = 'X';
+  // wrong position size
+  invalid.push_back(content);
+  invalid.back()[offsetof(KmerIndexHeader, positionSize)] = 8;
+  // directory not monotone
+  invalid.push_back(content);
+  uint32_t large = (uint32_t)header.keyCount + 1;
+  memcpy(&invalid.back()[header.directoryOffset + sizeof(uint32_t)], &large, sizeof(large));
+  // directory not starting at 0
+  invalid.push_back(content);
+  uint32_t one = 1;
+  memcpy(&invalid.back()[header.directoryOffset], &one, sizeof(one));
+  // offsets past the positions or decreasing
+  invalid.push_back(content);
+  uint32_t past = (uint32_t)header.positionCount + 100;
+  memcpy(&invalid.back()[header.offsetsOffset + sizeof(uint32_t)], &past, sizeof(past));
+  invalid.push_back(content);
+  uint32_t offsets[2];
+  memcpy(offsets, &content[header.offsetsOffset + sizeof(uint32_t)], sizeof(offsets));
+  std::swap(offsets[0], offsets[1]);
+  memcpy(&invalid.back()[header.offsetsOffset + sizeof(uint32_t)], offsets, sizeof(offsets));
+  // sizes that overflow the bound checks
+  invalid.push_back(content);
+  uint64_t huge = ~(uint64_t)0 - 7;
+  memcpy(&invalid.back()[offsetof(KmerIndexHeader, positionsOffset)], &huge, sizeof(huge));
+  invalid.push_back(content);
+  huge = (uint64_t)1 << 62;
+  memcpy(&invalid.back()[offsetof(KmerIndexHeader, positionCount)], &huge, sizeof(huge));
+  invalid.push_back(content);
+  huge = ~(uint64_t)0;
+  memcpy(&invalid.back()[offsetof(KmerIndexHeader, keyCount)], &huge, sizeof(huge));
+
+  for (const std::string& c : invalid) {
+    write_file(IndexFile, c);
+    Index mapped;
+    BOOST_TEST( !mapped.mapFile(IndexFile) );
+    BOOST_TEST( mapped.empty() );
+    BOOST_TEST( !mapped.isMapped() );
+    BOOST_TEST( mapped.count(0) == 0 );
+  }
+  BOOST_TEST( !Index().mapFile("missing.kidx") );
+  std::remove(IndexFile.c_str());
+}
@@ -0,0 +1,186 @@
+// base_encoder_test.cpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define BOOST_TEST_MODULE base_encoder_test
+#include <boost/test/included/unit_test.hpp>
+using namespace boost::unit_test;
+
+#include <core/BaseEncoder.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+const std::string Upper2 = "ACGT";
+const std::string Lower2 = "acgt";
+const std::string Upper4 = "-ACMGRSVTWYHKDBN";
+const std::string Lower4 = ".acmgrsvtwyhkdbn";
+
+// naive conversions, one base at a time
+
+size_t naive_code(const std::string& upper, const std::string& lower, char c) {
+  size_t i = upper.find(c);
+  return (i != std::string::npos) ? i : lower.find(c);
+}
+
+void naive_encode_2bits(const std::string& s, std::vector< uint8_t >& packed,
+			std::vector< uint64_t >& ambiguous) {
+  packed.assign((s.size() + 3) / 4, 0);
+  ambiguous.assign((s.size() + 63) / 64, 0);
+  for (size_t i = 0; i < s.size(); ++i) {
+    size_t c = naive_code(Upper2, Lower2, s[i]);
+    if (c == std::string::npos) {
+      c = 0;
+      ambiguous[i / 64] |= (uint64_t)1 << (i % 64);
+    }
+    packed[i / 4] |= c << (2 * (3 - i % 4));
+  }
+}
+
+std::vector< uint8_t > naive_encode_4bits(const std::string& s) {
+  std::vector< uint8_t > packed((s.size() + 1) / 2, 0);
+  for (size_t i = 0; i < s.size(); ++i) {
+    size_t c = naive_code(Upper4, Lower4, s[i]);
+    c = (c == std::string::npos) ? 0 : c;
+    packed[i / 2] |= c << (4 * (1 - i % 2));
+  }
+  return packed;
+}
+
+// all the 256 characters or (mostly) bases
+std::string random_text(std::mt19937_64& g, size_t n, bool bases) {
+  const std::string symbols = "ACGTACGTACGTacgtNnRYKM-.";
+  std::string s;
+  for (size_t i = 0; i < n; ++i) {
+    s += bases ? symbols[g() % symbols.size()] : (char)(g() % 256);
+  }
+  return s;
+}
+
+BOOST_AUTO_TEST_CASE( encode_2bits_matches_naive )
+{
+  std::mt19937_64 g(15);
+  for (size_t n = 0; n <= 300; ++n) {
+    for (bool bases : {true, false}) {
+      // the input does not start at an aligned address
+      std::string s = random_text(g, n + 3, bases).substr(3);
+      std::vector< uint8_t > expected;
+      std::vector< uint64_t > expectedMask;
+      naive_encode_2bits(s, expected, expectedMask);
+      std::vector< uint8_t > packed(expected.size() + 1, 0xA5);
+      std::vector< uint64_t > mask(expectedMask.size() + 1, ~(uint64_t)0);
+      BaseEncoder::encode2Bits(s.data(), n, packed.data(), mask.data());
+      BOOST_TEST( (std::vector< uint8_t >(packed.begin(), packed.end() - 1) == expected) );
+      BOOST_TEST( (std::vector< uint64_t >(mask.begin(), mask.end() - 1) == expectedMask) );
+      // nothing is written past the end
+      BOOST_TEST( packed.back() == 0xA5 );
+      BOOST_TEST( mask.back() == ~(uint64_t)0 );
+      std::vector< uint8_t > unmasked(expected.size(), 0);
+      BaseEncoder::encode2Bits(s.data(), n, unmasked.data());
+      BOOST_TEST( (unmasked == expected) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( decode_2bits_matches_naive )
+{
+  std::mt19937_64 g(16);
+  for (size_t n = 0; n <= 300; ++n) {
+    std::vector< uint8_t > packed((n + 3) / 4);
+    std::vector< uint64_t > mask((n + 63) / 64);
+    for (uint8_t& b : packed) {
+      b = (uint8_t)g();
+    }
+    for (uint64_t& w : mask) {
+      w = g() & g();
+    }
+    std::string expected(n, ' ');
+    std::string expectedMasked(n, ' ');
+    for (size_t i = 0; i < n; ++i) {
+      expected[i] = Upper2[(packed[i / 4] >> (2 * (3 - i % 4))) & 3];
+      expectedMasked[i] = ((mask[i / 64] >> (i % 64)) & 1) ? 'N' : expected[i];
+    }
+    std::string bases(n + 1, '#');
+    BaseEncoder::decode2Bits(packed.data(), n, &bases[0]);
+    BOOST_TEST( bases.substr(0, n) == expected );
+    BOOST_TEST( bases[n] == '#' );
+    BaseEncoder::decode2Bits(packed.data(), n, &bases[0], mask.data());
+    BOOST_TEST( bases.substr(0, n) == expectedMasked );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( encode_4bits_matches_naive )
+{
+  std::mt19937_64 g(17);
+  for (size_t n = 0; n <= 300; ++n) {
+    for (bool bases : {true, false}) {
+      std::string s = random_text(g, n + 1, bases).substr(1);
+      std::vector< uint8_t > expected = naive_encode_4bits(s);
+      std::vector< uint8_t > packed(expected.size() + 1, 0xA5);
+      BaseEncoder::encode4Bits(s.data(), n, packed.data());
+      BOOST_TEST( (std::vector< uint8_t >(packed.begin(), packed.end() - 1) == expected) );
+      BOOST_TEST( packed.back() == 0xA5 );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( decode_4bits_matches_naive )
+{
+  std::mt19937_64 g(18);
+  for (size_t n = 0; n <= 300; ++n) {
+    std::vector< uint8_t > packed((n + 1) / 2);
+    for (uint8_t& b : packed) {
+      b = (uint8_t)g();
+    }
+    std::string expected(n, ' ');
+    for (size_t i = 0; i < n; ++i) {
+      expected[i] = Upper4[(packed[i / 2] >> (4 * (1 - i % 2))) & 15];
+    }
+    std::string bases(n + 1, '#');
+    BaseEncoder::decode4Bits(packed.data(), n, &bases[0]);
+    BOOST_TEST( bases.substr(0, n) == expected );
+    BOOST_TEST( bases[n] == '#' );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( bases_survive_round_trip )
+{
+  std::mt19937_64 g(19);
+  std::string s = random_text(g, 10000, true);
+  std::string upper = s;
+  for (char& c : upper) {
+    c = (c == '.') ? '-' : (char)toupper(c);
+  }
+  std::vector< uint8_t > packed4((s.size() + 1) / 2);
+  BaseEncoder::encode4Bits(s.data(), s.size(), packed4.data());
+  std::string decoded(s.size(), ' ');
+  BaseEncoder::decode4Bits(packed4.data(), s.size(), &decoded[0]);
+  BOOST_TEST( decoded == upper );
+
+  // with the mask, 2 bits codes keep A, C, G, T and turn the rest to N
+  std::vector< uint8_t > packed2((s.size() + 3) / 4);
+  std::vector< uint64_t > mask((s.size() + 63) / 64);
+  BaseEncoder::encode2Bits(s.data(), s.size(), packed2.data(), mask.data());
+  BaseEncoder::decode2Bits(packed2.data(), s.size(), &decoded[0], mask.data());
+  for (char& c : upper) {
+    c = (Upper2.find(c) == std::string::npos) ? 'N' : c;
+  }
+  BOOST_TEST( decoded == upper );
+
+  std::string set = BaseEncoder::getInstructionSet();
+  BOOST_TEST( (set == "avx2" || set == "sse4.1" || set == "scalar") );
+}
@@ -0,0 +1,130 @@
+// compressed_variable_read_set_test.cpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define BOOST_TEST_MODULE compressed_variable_read_set_test
+#include <boost/test/included/unit_test.hpp>
+using namespace boost::unit_test;
+
+#include <core/CompressedVariableReadSet.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+const std::string SetFile = "compressed_variable_read_set_test.vset";
+
+// reads of any length (empty ones included)
+std::vector< Read > random_reads(std::mt19937_64& g, size_t n) {
+  std::vector< Read > reads(n);
+  for (size_t i = 0; i < n; ++i) {
+    size_t length = (g() % 10 == 0) ? 0 : g() % 300;
+    std::string s;
+    for (size_t j = 0; j < length; ++j) {
+      s += (g() % 50 == 0) ? 'N' : "ACGT"[g() % 4];
+    }
+    reads[i].setBases(s);
+  }
+  return reads;
+}
+
+// the bases as stored with 2 bits (other bases become A)
+std::string expected_bases(const Read& read, size_t bits) {
+  std::string s = read.getBases();
+  for (char& c : s) {
+    c = (bits == 2 && c == 'N') ? 'A' : c;
+  }
+  return s;
+}
+
+bool same_reads(const CompressedVariableReadSet& set, const std::vector< Read >& reads,
+		size_t bits) {
+  if (set.getReadCount() != reads.size()) {
+    return false;
+  }
+  size_t offset = 0;
+  size_t longest = 0;
+  for (size_t i = 0; i < reads.size(); ++i) {
+    std::string s = expected_bases(reads[i], bits);
+    if (set.getReadOffset(i) != offset || set.getReadLength(i) != s.size() ||
+	set.getBases(i) != s) {
+      return false;
+    }
+    offset += s.size();
+    longest = std::max(longest, s.size());
+  }
+  if (set.getBaseCount() != offset || set.getMaxReadLength() != longest) {
+    return false;
+  }
+  // the iterator visits the same reads
+  std::vector< char > buffer(longest + 1);
+  CompressedVariableReadIterator it(set, buffer.data());
+  size_t i = 0;
+  while (it.next()) {
+    lbio::char_span bases = it.getBases();
+    if (i >= reads.size() || it.getIndex() != i ||
+	std::string(bases.data(), bases.size()) != expected_bases(reads[i], bits)) {
+      return false;
+    }
+    ++i;
+  }
+  return i == reads.size();
+}
+
+BOOST_AUTO_TEST_CASE( reads_match_appended_reads )
+{
+  std::mt19937_64 g(16);
+  for (size_t bits : {2, 4}) {
+    for (size_t n : {0, 1, 5, 300, 2000}) {
+      std::vector< Read > reads = random_reads(g, n);
+      CompressedVariableReadSet set(reads, bits);
+      BOOST_TEST( same_reads(set, reads, bits) );
+      // appended one at a time, after a reserve
+      CompressedVariableReadSet one(bits);
+      one.reserve(100);
+      for (const Read& r : reads) {
+	one.append(r);
+      }
+      BOOST_TEST( same_reads(one, reads, bits) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( reads_survive_file_round_trip )
+{
+  std::mt19937_64 g(17);
+  for (size_t bits : {2, 4}) {
+    std::vector< Read > reads = random_reads(g, 1000);
+    CompressedVariableReadSet set(reads, bits);
+    set.writeToFile(SetFile);
+    CompressedVariableReadSet loaded(bits);
+    BOOST_TEST( loaded.loadFromFile(SetFile) );
+    BOOST_TEST( same_reads(loaded, reads, bits) );
+  }
+
+  // a truncated file leaves the set empty
+  std::ifstream ifs(SetFile, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  ifs.close();
+  std::ofstream(SetFile, std::ios::binary) << content.substr(0, content.size() - 1);
+  CompressedVariableReadSet truncated(random_reads(g, 10), 4);
+  BOOST_TEST( !truncated.loadFromFile(SetFile) );
+  BOOST_TEST( truncated.getReadCount() == 0 );
+  BOOST_TEST( !truncated.loadFromFile("missing.vset") );
+  std::remove(SetFile.c_str());
+}
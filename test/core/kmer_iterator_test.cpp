@@ -0,0 +1,150 @@
+// kmer_iterator_test.cpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define BOOST_TEST_MODULE kmer_iterator_test
+#include <boost/test/included/unit_test.hpp>
+using namespace boost::unit_test;
+
+#include <core/KMerIterator.hpp>
+#include <core/CompressedSequence.h>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::vector< std::pair< uint64_t, size_t > > KMerList;
+
+// naive scan: every substring of k bases made only of A, C, G and T
+KMerList naive_kmers(const std::string& s, size_t k) {
+  KMerList v;
+  for (size_t i = 0; i + k <= s.size(); ++i) {
+    uint64_t code = 0;
+    bool valid = true;
+    for (size_t j = 0; j < k; ++j) {
+      size_t c = std::string("ACGT").find(s[i + j]);
+      valid = valid && (c != std::string::npos);
+      code = (code << 2) | (c & 3);
+    }
+    if (valid) {
+      v.push_back(std::make_pair(code, i));
+    }
+  }
+  return v;
+}
+
+template <typename T>
+KMerList iterator_kmers(KMerIterator<T>& it) {
+  KMerList v;
+  while (it.next()) {
+    v.push_back(std::make_pair(it.getForward(), it.getPosition()));
+  }
+  return v;
+}
+
+std::string random_bases(std::mt19937_64& g, size_t n, bool with_n) {
+  std::string s;
+  for (size_t i = 0; i < n; ++i) {
+    s += (with_n && g() % 17 == 0) ? 'N' : "ACGT"[g() % 4];
+  }
+  return s;
+}
+
+// 2 bits codes (A, C, G, T) or IUPAC numbers (4 bits)
+CompressedSequence compress(const std::string& s, size_t el_size) {
+  CompressedSequence c(s.size(), el_size);
+  for (size_t i = 0; i < s.size(); ++i) {
+    size_t b = std::string("ACGT").find(s[i]);
+    if (el_size == 2) {
+      c.setElementAt(i, (uint8_t)b);
+    } else {
+      c.setElementAt(i, (b == std::string::npos) ? 15 : (uint8_t)(1 << b));
+    }
+  }
+  return c;
+}
+
+BOOST_AUTO_TEST_CASE( characters_match_naive_scan )
+{
+  std::mt19937_64 g(19);
+  for (size_t n : {0, 1, 5, 31, 32, 33, 64, 65, 200, 1000}) {
+    std::string s = random_bases(g, n, true);
+    for (size_t k : {1, 3, 16, 31, 32}) {
+      KMerIterator<std::string> it(s, k);
+      BOOST_TEST( (iterator_kmers(it) == naive_kmers(s, k)) );
+      KMerIterator<const char*> raw(s.data(), s.size(), k);
+      BOOST_TEST( (iterator_kmers(raw) == naive_kmers(s, k)) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( compressed_sequence_matches_naive_scan )
+{
+  std::mt19937_64 g(23);
+  for (size_t n : {0, 1, 3, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65, 500}) {
+    for (size_t k : {1, 4, 15, 32}) {
+      std::string s2 = random_bases(g, n, false);
+      CompressedSequence c2 = compress(s2, 2);
+      KMerIterator<CompressedSequence> it2(c2, k);
+      BOOST_TEST( (iterator_kmers(it2) == naive_kmers(s2, k)) );
+
+      std::string s4 = random_bases(g, n, true);
+      CompressedSequence c4 = compress(s4, 4);
+      KMerIterator<CompressedSequence> it4(c4, k);
+      BOOST_TEST( (iterator_kmers(it4) == naive_kmers(s4, k)) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( compressed_range_matches_substring )
+{
+  std::mt19937_64 g(29);
+  std::string s = random_bases(g, 300, false);
+  CompressedSequence c = compress(s, 2);
+  for (size_t begin : {0, 1, 31, 32, 33, 100}) {
+    for (size_t length : {0, 10, 64, 150}) {
+      KMerIterator<CompressedSequence> it(c, begin, length, 12);
+      BOOST_TEST( (iterator_kmers(it) == naive_kmers(s.substr(begin, length), 12)) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( wide_codes_match_narrow_codes )
+{
+  std::mt19937_64 g(31);
+  std::string s = random_bases(g, 400, true);
+  KMerIterator<std::string, 2> wide(s, 20);
+  KMerIterator<std::string> narrow(s, 20);
+  while (narrow.next()) {
+    BOOST_TEST( wide.next() );
+    BOOST_TEST( (uint64_t)wide.getForward() == narrow.getForward() );
+    BOOST_TEST( (uint64_t)wide.getReverse() == narrow.getReverse() );
+    BOOST_TEST( wide.getPosition() == narrow.getPosition() );
+  }
+  BOOST_TEST( !wide.next() );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_parameters_are_rejected )
+{
+  std::string s = "ACGTACGT";
+  BOOST_CHECK_THROW( KMerIterator<std::string>(s, 0), std::domain_error );
+  BOOST_CHECK_THROW( KMerIterator<std::string>(s, 33), std::domain_error );
+  CompressedSequence bytes(10, 8);
+  BOOST_CHECK_THROW( KMerIterator<CompressedSequence>(bytes, 3), std::domain_error );
+  CompressedSequence c = compress(s, 2);
+  BOOST_CHECK_THROW( KMerIterator<CompressedSequence>(c, 4, 10, 3), std::domain_error );
+}
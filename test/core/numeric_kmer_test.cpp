@@ -0,0 +1,165 @@
+// numeric_kmer_test.cpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define BOOST_TEST_MODULE numeric_kmer_test
+#include <boost/test/included/unit_test.hpp>
+using namespace boost::unit_test;
+
+#include <core/NumericKMer.hpp>
+#include <core/KMerIterator.hpp>
+
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+
+using seq::BasicNumericKMer;
+using seq::KMerHash;
+using seq::KMerWord;
+
+std::string random_bases(std::mt19937_64& g, size_t n) {
+  std::string s;
+  for (size_t i = 0; i < n; ++i) {
+    s += "ACGT"[g() % 4];
+  }
+  return s;
+}
+
+std::string reverse_complement(const std::string& s) {
+  std::string r(s.rbegin(), s.rend());
+  for (char& c : r) {
+    c = "TGCA"[std::string("ACGT").find(c)];
+  }
+  return r;
+}
+
+// the lowest 64 bits of a code
+uint64_t low_word(uint64_t code) {
+  return code;
+}
+
+#ifdef __SIZEOF_INT128__
+uint64_t low_word(unsigned __int128 code) {
+  return (uint64_t)code;
+}
+#endif
+
+template <size_t W>
+uint64_t low_word(const std::array< uint64_t, W >& code) {
+  return code[W - 1];
+}
+
+template <size_t W>
+void check_strings(std::mt19937_64& g) {
+  typedef BasicNumericKMer<W> KMer;
+  for (size_t k = 1; k <= KMer::KMax; ++k) {
+    std::string s = random_bases(g, k);
+    KMer kmer = KMer::fromChars(s.data(), k);
+    BOOST_TEST( kmer.getK() == k );
+    BOOST_TEST( kmer.toString() == s );
+    BOOST_TEST( (KMer(kmer.getCode(), k) == kmer) );
+    // the 64 bits reference for the last 32 bases
+    size_t last = std::min(k, (size_t)32);
+    BOOST_TEST( low_word(kmer.getCode()) ==
+		seq::NumericKMer::fromChars(s.data() + k - last, last) );
+  }
+}
+
+template <size_t W>
+void check_rolling(std::mt19937_64& g) {
+  typedef BasicNumericKMer<W> KMer;
+  std::string s = random_bases(g, 1000);
+  for (size_t k : {(size_t)1, (size_t)31, 32 * W - 1, 32 * W}) {
+    KMer kmer = KMer::fromChars(s.data(), k);
+    for (size_t i = k; i < s.size(); ++i) {
+      kmer.roll(s[i]);
+      BOOST_TEST( kmer.toString() == s.substr(i - k + 1, k) );
+    }
+    // the reverse complement is rolled by KMerIterator
+    KMerIterator<std::string, W> it(s, k);
+    while (it.next()) {
+      std::string expected = s.substr(it.getPosition(), k);
+      BOOST_TEST( KMer(it.getForward(), k).toString() == expected );
+      BOOST_TEST( KMer(it.getReverse(), k).toString() == reverse_complement(expected) );
+    }
+  }
+}
+
+template <size_t W>
+void check_order_and_hash(std::mt19937_64& g) {
+  typedef BasicNumericKMer<W> KMer;
+  size_t k = 32 * W - 3;
+  std::vector< std::string > strings;
+  for (size_t i = 0; i < 500; ++i) {
+    // few distinct prefixes, so that the codes differ in the low words
+    std::string s = random_bases(g, k);
+    s.replace(0, k - 5, std::string(k - 5, "AT"[g() % 2]));
+    strings.push_back(s);
+  }
+  std::set< std::string > distinct;
+  std::unordered_set< KMer, KMerHash<W> > kmers;
+  std::unordered_set< typename KMer::CodeType, KMerHash<W> > codes;
+  for (const std::string& a : strings) {
+    KMer ka = KMer::fromChars(a.data(), k);
+    const std::string& b = strings[g() % strings.size()];
+    KMer kb = KMer::fromChars(b.data(), k);
+    // bases are ordered as their codes, A < C < G < T
+    BOOST_TEST( (ka < kb) == (a < b) );
+    BOOST_TEST( (ka == kb) == (a == b) );
+    BOOST_TEST( (ka != kb) == (a != b) );
+    BOOST_TEST( (a != b || ka.hash() == kb.hash()) );
+    distinct.insert(a);
+    kmers.insert(ka);
+    codes.insert(ka.getCode());
+  }
+  BOOST_TEST( kmers.size() == distinct.size() );
+  BOOST_TEST( codes.size() == distinct.size() );
+}
+
+BOOST_AUTO_TEST_CASE( codes_match_bases )
+{
+  std::mt19937_64 g(20);
+  check_strings<1>(g);
+  check_strings<2>(g);
+  check_strings<3>(g);
+  check_strings<4>(g);
+}
+
+BOOST_AUTO_TEST_CASE( rolled_codes_match_substrings )
+{
+  std::mt19937_64 g(21);
+  check_rolling<1>(g);
+  check_rolling<2>(g);
+  check_rolling<3>(g);
+  check_rolling<4>(g);
+}
+
+BOOST_AUTO_TEST_CASE( order_and_hash_match_strings )
+{
+  std::mt19937_64 g(22);
+  check_order_and_hash<1>(g);
+  check_order_and_hash<2>(g);
+  check_order_and_hash<3>(g);
+}
+
+BOOST_AUTO_TEST_CASE( other_symbols_are_taken_as_a )
+{
+  std::string s = "ACNGTnacgtXA";
+  BasicNumericKMer<2> kmer = BasicNumericKMer<2>::fromChars(s.data(), s.size());
+  BOOST_TEST( kmer.toString() == "ACAGTAACGTAA" );
+  BOOST_TEST( low_word(kmer.getCode()) == seq::NumericKMer::fromChars(s.data(), s.size()) );
+}
@@ -0,0 +1,65 @@
+// phred_quality_test.cpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define BOOST_TEST_MODULE phred_quality_test
+#include <boost/test/included/unit_test.hpp>
+using namespace boost::unit_test;
+
+#include <core/PhredQuality.hpp>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE( values_are_parsed )
+{
+  std::string line = " 20\t-1,33  +7 12x 0\r\n";
+  std::vector< int > values(10, 99);
+  size_t found = PhredQuality::parseQualityValues(line.data(), line.size(),
+						  values.data(), values.size());
+  BOOST_TEST( found == 6 );
+  BOOST_TEST( (std::vector< int >(values.begin(), values.begin() + 6) ==
+	       std::vector< int >({ 20, -1, 33, 7, 12, 0 })) );
+  // values past the output are counted but not stored
+  BOOST_TEST( PhredQuality::parseQualityValues(line.data(), line.size(), values.data(), 2) == 6 );
+  BOOST_TEST( values[2] == 33 );
+}
+
+BOOST_AUTO_TEST_CASE( missing_calls_have_lowest_quality )
+{
+  // a .qual line of a read with two missing calls
+  PhredQuality q("27 -1 14 30 -1 5", 6);
+  BOOST_TEST( q.length() == 6 );
+  int* quals = q.getQualities();
+  BOOST_TEST( (std::vector< int >(quals, quals + 6) ==
+	       std::vector< int >({ 27, 0, 14, 30, 0, 5 })) );
+  delete[] quals;
+  double* probs = q.getProbabilities();
+  for (size_t i = 0; i < 6; ++i) {
+    int expected[] = { 27, 0, 14, 30, 0, 5 };
+    BOOST_TEST( std::fabs(probs[i] - std::pow(10.0, -expected[i] / 10.0)) < 1e-9 );
+  }
+  delete[] probs;
+}
+
+BOOST_AUTO_TEST_CASE( short_lines_are_padded_with_zeros )
+{
+  PhredQuality q("10 -1", 4);
+  int* quals = q.getQualities();
+  BOOST_TEST( (std::vector< int >(quals, quals + 4) == std::vector< int >({ 10, 0, 0, 0 })) );
+  delete[] quals;
+}
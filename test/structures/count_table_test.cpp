@@ -0,0 +1,144 @@
+// count_table_test.cpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define BOOST_TEST_MODULE count_table_test
+#include <boost/test/included/unit_test.hpp>
+using namespace boost::unit_test;
+
+#include <structures/count_table.hpp>
+
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+typedef std::unordered_map< uint64_t, uint64_t > NaiveTable;
+
+// keys sharing the same hash in groups of 64, so that long clusters
+// cross the ranges moved by each thread during the rehash
+struct clustered_hash {
+  size_t operator()(uint64_t key) const { return (size_t)(key / 64); }
+};
+
+template <typename T>
+bool same_counts(const T& table, const NaiveTable& m, std::mt19937_64& g) {
+  typedef typename T::count_type C;
+  const uint64_t max = std::numeric_limits<C>::max();
+  if (table.size() != m.size() || table.empty() != m.empty() ||
+      table.load_factor() > 0.7) {
+    return false;
+  }
+  for (const auto& e : m) {
+    if (table.count(e.first) != std::min(e.second, max)) {
+      return false;
+    }
+  }
+  // keys not in the table
+  for (size_t i = 0; i < 1000; ++i) {
+    uint64_t key = g();
+    if (m.count(key) == 0 && table.count(key) != 0) {
+      return false;
+    }
+  }
+  // every key is visited once
+  size_t visited = 0;
+  bool found = true;
+  table.for_each([&](uint64_t key, C n) {
+      NaiveTable::const_iterator it = m.find(key);
+      found = found && (it != m.end()) && (n == std::min(it->second, max));
+      visited++;
+    });
+  return found && visited == m.size();
+}
+
+template <typename T>
+void add_random(T& table, NaiveTable& m, std::mt19937_64& g, size_t n, uint64_t range) {
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t key = g() % range;
+    uint64_t c = 1 + (g() % 3 == 0) * (g() % 5);
+    table.add(key, (typename T::count_type)c);
+    m[key] += c;
+  }
+}
+
+BOOST_AUTO_TEST_CASE( counts_match_unordered_map )
+{
+  std::mt19937_64 g(21);
+  for (uint64_t range : {10, 1000, 100000, 0}) {
+    lbio::count_table< uint64_t > table(0, 1);
+    NaiveTable m;
+    BOOST_TEST( same_counts(table, m, g) );
+    for (size_t n : {1, 10, 100, 10000, 100000}) {
+      add_random(table, m, g, n, (range == 0) ? ~(uint64_t)0 : range);
+      BOOST_TEST( same_counts(table, m, g) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( counters_saturate )
+{
+  std::mt19937_64 g(22);
+  lbio::count_table< uint64_t, std::hash<uint64_t>, uint8_t > table(0, 1);
+  NaiveTable m;
+  add_random(table, m, g, 50000, 200);
+  BOOST_TEST( same_counts(table, m, g) );
+  table.add(7, 255);
+  BOOST_TEST( table.count(7) == 255 );
+  // adding zero occurrences does not insert the key
+  table.add(1000, 0);
+  BOOST_TEST( table.count(1000) == 0 );
+  BOOST_TEST( table.size() == m.size() );
+}
+
+BOOST_AUTO_TEST_CASE( parallel_rehash_matches_unordered_map )
+{
+  std::mt19937_64 g(23);
+  for (size_t threads : {1, 2, 3, 4}) {
+    // the table doubles past 2^20 slots, which is rehashed in parallel
+    lbio::count_table< uint64_t > table(0, threads);
+    NaiveTable m;
+    add_random(table, m, g, 1200000, ~(uint64_t)0);
+    BOOST_TEST( table.capacity() > ((size_t)1 << 20) );
+    BOOST_TEST( same_counts(table, m, g) );
+
+    lbio::count_table< uint64_t, clustered_hash > clustered(0, threads);
+    NaiveTable c;
+    add_random(clustered, c, g, 1000000, 4000000);
+    BOOST_TEST( same_counts(clustered, c, g) );
+    // a large reserve moves the whole table at once
+    clustered.reserve(4 * clustered.capacity());
+    BOOST_TEST( same_counts(clustered, c, g) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( merged_counts_match_unordered_map )
+{
+  std::mt19937_64 g(24);
+  lbio::count_table< uint64_t > a(0, 2);
+  lbio::count_table< uint64_t > b(100, 2);
+  NaiveTable m;
+  add_random(a, m, g, 300000, 500000);
+  add_random(b, m, g, 300000, 500000);
+  a.merge(b);
+  BOOST_TEST( same_counts(a, m, g) );
+
+  size_t capacity = a.capacity();
+  a.clear();
+  BOOST_TEST( a.empty() );
+  BOOST_TEST( a.capacity() == capacity );
+  BOOST_TEST( same_counts(a, NaiveTable(), g) );
+}
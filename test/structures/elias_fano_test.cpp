@@ -0,0 +1,128 @@
+// elias_fano_test.cpp
+
+// Copyright 2017 Michele Schimd
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define BOOST_TEST_MODULE elias_fano_test
+#include <boost/test/included/unit_test.hpp>
+using namespace boost::unit_test;
+
+#include <structures/elias_fano.hpp>
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+bool same_values(const lbio::elias_fano& ef, const std::vector< uint64_t >& v) {
+  if (ef.size() != v.size() || ef.empty() != v.empty() ||
+      ef.back() != (v.empty() ? 0 : v.back())) {
+    return false;
+  }
+  for (size_t i = 0; i < v.size(); ++i) {
+    if (ef[i] != v[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// appends n values whose gaps are at most max_gap (with some jumps)
+void append_random(std::mt19937_64& g, size_t n, uint64_t max_gap, bool jumps,
+		   lbio::elias_fano& ef, std::vector< uint64_t >& v) {
+  uint64_t value = v.empty() ? 0 : v.back();
+  for (size_t i = 0; i < n; ++i) {
+    value += (max_gap == 0) ? 0 : g() % (max_gap + 1);
+    if (jumps && g() % 1000 == 0) {
+      value += (uint64_t)1 << (g() % 40);
+    }
+    ef.push_back(value);
+    v.push_back(value);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( values_match_vector )
+{
+  std::mt19937_64 g(16);
+  for (uint64_t max_gap : {0, 1, 3, 150, 100000}) {
+    for (bool jumps : {false, true}) {
+      lbio::elias_fano ef;
+      std::vector< uint64_t > v;
+      BOOST_TEST( same_values(ef, v) );
+      // sizes around the powers of two (where values are encoded again)
+      for (size_t n : {1, 62, 1, 1, 64, 127, 2, 300, 1000, 20000}) {
+	append_random(g, n, max_gap, jumps, ef, v);
+	BOOST_TEST( same_values(ef, v) );
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( growing_gaps_match_vector )
+{
+  // values growing much faster than expected from the first ones
+  lbio::elias_fano ef;
+  std::vector< uint64_t > v;
+  for (uint64_t i = 0; i < 5000; ++i) {
+    uint64_t value = i * i * i;
+    ef.push_back(value);
+    v.push_back(value);
+  }
+  BOOST_TEST( same_values(ef, v) );
+  // and then repeated
+  for (size_t i = 0; i < 1000; ++i) {
+    ef.push_back(v.back());
+    v.push_back(v.back());
+  }
+  BOOST_TEST( same_values(ef, v) );
+}
+
+BOOST_AUTO_TEST_CASE( large_values_match_vector )
+{
+  std::mt19937_64 g(17);
+  lbio::elias_fano ef;
+  std::vector< uint64_t > v;
+  uint64_t value = (uint64_t)1 << 62;
+  for (size_t i = 0; i < 3000; ++i) {
+    value += g() % ((uint64_t)1 << 48);
+    ef.push_back(value);
+    v.push_back(value);
+  }
+  BOOST_TEST( same_values(ef, v) );
+}
+
+BOOST_AUTO_TEST_CASE( offsets_take_few_bits )
+{
+  // offsets of reads of 150 bases
+  lbio::elias_fano ef;
+  size_t n = 100000;
+  for (size_t i = 0; i <= n; ++i) {
+    ef.push_back(150 * i);
+  }
+  BOOST_TEST( ef[n] == 150 * n );
+  BOOST_TEST( 8 * ef.size_in_bytes() < 12 * n );
+}
+
+BOOST_AUTO_TEST_CASE( decreasing_values_are_rejected )
+{
+  lbio::elias_fano ef;
+  ef.push_back(10);
+  BOOST_CHECK_THROW( ef.push_back(9), std::domain_error );
+  BOOST_TEST( ef.size() == 1 );
+  BOOST_TEST( ef[0] == 10 );
+  ef.clear();
+  BOOST_TEST( ef.empty() );
+  ef.push_back(0);
+  BOOST_TEST( ef[0] == 0 );
+}